@@ -0,0 +1,96 @@
+// Time to read the JSON recipient list of earlier versions, with parseRecipientListJson() and with the
+// Poco::JSON parser it replaced.
+//
+// recipient_list_bench [recipients]
+
+#include "recipient_list_store.hpp"
+
+#include <Poco/Dynamic/Var.h>
+#include <Poco/JSON/Parser.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace bacnet;
+
+static const unsigned recipients_per_class = 100;
+
+static std::string addressBytes(unsigned seed) {
+    std::string bytes;
+    for (unsigned i = 0; i < MAX_MAC_LEN; i++)
+        bytes += std::to_string((seed + i) & 0xFF) + ";";
+    return bytes;
+}
+
+// same layout as the files written by earlier versions
+static std::string recipientListJson(unsigned count) {
+    std::string json = "{\"notification_classes\": [";
+    for (unsigned i = 0; i < count; i++) {
+        if (i % recipients_per_class == 0) {
+            if (i != 0)
+                json += "]}, ";
+            json += "{\"nc_object_name\": \"notification class " + std::to_string(i / recipients_per_class + 1) +
+                    "\", \"recipients\": [";
+        } else {
+            json += ", ";
+        }
+
+        json += "{\"recipient_type\": " + std::to_string(i % 2 ? RECIPIENT_TYPE_ADDRESS : RECIPIENT_TYPE_DEVICE) +
+                ", \"device_identifier\": " + std::to_string(i + 1) +
+                ", \"address\": {\"adr\": \"" + addressBytes(i) + "\", \"len\": 6, \"mac\": \"" +
+                addressBytes(i + 1) + "\", \"mac_len\": 6, \"net\": " + std::to_string(i % 1000) +
+                "}, \"valid_days\": 127"
+                ", \"from_time\": {\"hour\": 0, \"min\": 0, \"sec\": 0, \"hundredths\": 0}"
+                ", \"to_time\": {\"hour\": 23, \"min\": 59, \"sec\": 59, \"hundredths\": 99}"
+                ", \"process_identifier\": " + std::to_string(i) +
+                ", \"transitions\": 7, \"confirmed_notify\": " + (i % 3 ? "true" : "false") + "}";
+    }
+    json += count ? "]}]}" : "]}";
+    return json;
+}
+
+template <typename F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    unsigned count = argc > 1 ? (unsigned)strtoul(argv[1], nullptr, 10) : 1000;
+    const int iterations = 100;
+
+    std::string json = recipientListJson(count);
+
+    for (int round = 0; round < 3; round++) {
+        bool parsed = true;
+        size_t recipients = 0;
+        double single_pass = seconds([&]() {
+            for (int i = 0; i < iterations; i++) {
+                RecipientLists lists;
+                parsed = parseRecipientListJson(json, lists) && parsed;
+                recipients = 0;
+                for (const auto& list : lists)
+                    recipients += list.second.size();
+            }
+        });
+
+        double dom = seconds([&]() {
+            for (int i = 0; i < iterations; i++) {
+                Poco::JSON::Parser parser;
+                Poco::Dynamic::Var result = parser.parse(json);
+            }
+        });
+
+        printf("%u recipients, %zu bytes: parseRecipientListJson %.3f ms, Poco::JSON %.3f ms%s\n",
+            count,
+            json.size(),
+            single_pass * 1000 / iterations,
+            dom * 1000 / iterations,
+            parsed && recipients == count ? "" : " (failed)");
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Time to add the objects of a large device at startup, one by one and with Container::addObjects().
+//
+// startup_bench [objects]
+
+#include "container.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace bacnet;
+
+static std::vector<std::string> names;
+
+static void addDevice() {
+    container.addDeviceObject(
+        [](unsigned, char* object_name) {
+            strcpy(object_name, "bench device");
+            return true;
+        },
+        nullptr,
+        []() -> unsigned { return 1234; },
+        nullptr,
+        [](unsigned, char* description) {
+            strcpy(description, "");
+            return true;
+        },
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+        "vendor",
+        0,
+        "model",
+        "1.0",
+        "1.0");
+}
+
+static int objectName(unsigned object_instance, char* object_name) {
+    // instance 0 is the device, the objects count from 1
+    strcpy(object_name, names[object_instance - 1].c_str());
+    return true;
+}
+
+static ObjectSpec spec(unsigned i) {
+    ObjectSpec spec;
+    spec.type = (i % 2) ? OBJECT_ANALOG_VALUE : OBJECT_ANALOG_INPUT;
+    spec.object_name = objectName;
+    spec.units = UNITS_DEGREES_CELSIUS;
+#if defined(CERTIFICATION_SOFTWARE)
+    spec.event_detection_enable_cb = [](unsigned, bool* event_detection_enable) {
+        *event_detection_enable = false;
+        return true;
+    };
+#endif
+    return spec;
+}
+
+template <typename F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    unsigned count = argc > 1 ? (unsigned)strtoul(argv[1], nullptr, 10) : 100000;
+
+    names.reserve(count);
+    std::vector<ObjectSpec> specs;
+    specs.reserve(count);
+    for (unsigned i = 0; i < count; i++) {
+        names.push_back("point " + std::to_string(i + 1));
+        specs.push_back(spec(i));
+    }
+
+    for (int round = 0; round < 3; round++) {
+        container.reset();
+        addDevice();
+        double one_by_one = seconds([&]() {
+            for (const auto& s : specs) {
+                if (s.type == OBJECT_ANALOG_INPUT)
+                    container.addAnalogInputObject(s.object_name,
+                        s.read_present_value_real,
+#if defined(CERTIFICATION_SOFTWARE)
+                        s.event_detection_enable_cb,
+#endif
+                        s.units,
+                        "Analog Input Intrinsic Object",
+                        s.device_type,
+                        s.max_value,
+                        s.min_value,
+                        s.resolution);
+                else
+                    container.addAnalogValueObject(s.object_name,
+                        s.read_present_value_real,
+                        s.write_present_value_real,
+                        s.units,
+                        "Analog Value Object",
+                        s.max_value,
+                        s.min_value,
+                        s.resolution);
+            }
+        });
+
+        container.reset();
+        addDevice();
+        bool added = false;
+        double bulk = seconds([&]() { added = container.addObjects(specs); });
+
+        printf("%u objects: one by one %.3f s, addObjects %.3f s%s\n",
+            count,
+            one_by_one,
+            bulk,
+            added ? "" : " (failed)");
+    }
+
+    container.reset();
+    return 0;
+}
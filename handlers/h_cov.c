@@ -32,6 +32,7 @@
 #include "bacdef.h"
 #include "bacerror.h"
 #include "bacdcode.h"
+#include "bacapp.h"
 #include "bacaddr.h"
 #include "apdu.h"
 #include "npdu.h"
@@ -46,128 +47,34 @@
 /* demo objects */
 #include "c_wrapper.h"
 #include "handlers.h"
+#include "cov_subscriptions.h"
 
 /** @file h_cov.c  Handles Change of Value (COV) services. */
 
-typedef struct BACnet_COV_Address {
-    bool valid : 1;
-    BACNET_ADDRESS dest;
-} BACNET_COV_ADDRESS;
-
 /* note: This COV service only monitors the properties
-   of an object that have been specified in the standard.  */
-typedef struct BACnet_COV_Subscription_Flags {
-    bool valid : 1;
-    bool issueConfirmedNotifications : 1; /* optional */
-    bool send_requested : 1;
-} BACNET_COV_SUBSCRIPTION_FLAGS;
-
-typedef struct BACnet_COV_Subscription {
-    BACNET_COV_SUBSCRIPTION_FLAGS flag;
-    uint8_t dest_index;
-    uint8_t invokeID; /* for confirmed COV */
-    uint32_t subscriberProcessIdentifier;
-    uint32_t lifetime; /* optional */
-    BACNET_OBJECT_ID monitoredObjectIdentifier;
-} BACNET_COV_SUBSCRIPTION;
+   of an object that have been specified in the standard.
+   Subscriptions are kept in the table of cov_subscriptions.h. */
 
-#ifndef MAX_COV_SUBCRIPTIONS
-#define MAX_COV_SUBCRIPTIONS 128
-#endif
-static BACNET_COV_SUBSCRIPTION COV_Subscriptions[MAX_COV_SUBCRIPTIONS];
-#ifndef MAX_COV_ADDRESSES
-#define MAX_COV_ADDRESSES 16
+/* properties one SubscribeCOVPropertyMultiple request may name, more than
+   an unsegmented request can hold */
+#ifndef MAX_COV_REFERENCES_PER_REQUEST
+#define MAX_COV_REFERENCES_PER_REQUEST 512
 #endif
-static BACNET_COV_ADDRESS COV_Addresses[MAX_COV_ADDRESSES];
-
-/**
- * Gets the address from the list of COV addresses
- *
- * @param  index - offset into COV address list where address is stored
- * @param  dest - address to be filled when found
- *
- * @return true if valid address, false if not valid or not found
- */
-static BACNET_ADDRESS* cov_address_get(int index) {
-    BACNET_ADDRESS* cov_dest = NULL;
-
-    if (index < MAX_COV_ADDRESSES) {
-        if (COV_Addresses[index].valid) {
-            cov_dest = &COV_Addresses[index].dest;
-        }
-    }
-
-    return cov_dest;
-}
-
-/**
- * Removes the address from the list of COV addresses, if it is not
- * used by other COV subscriptions
- */
-static void cov_address_remove_unused(void) {
-    unsigned index = 0;
-    unsigned cov_index = 0;
-    bool found = false;
-
-    for (cov_index = 0; cov_index < MAX_COV_ADDRESSES; cov_index++) {
-        if (COV_Addresses[cov_index].valid) {
-            found = false;
-            for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-                if ((COV_Subscriptions[index].flag.valid) && (COV_Subscriptions[index].dest_index == cov_index)) {
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                COV_Addresses[cov_index].valid = false;
-            }
-        }
-    }
-}
 
-/**
- * Adds the address to the list of COV addresses
- *
- * @param  dest - address to be added if there is room in the list
- *
- * @return index number 0..N, or -1 if unable to add
- */
-static int cov_address_add(BACNET_ADDRESS* dest) {
-    int index = -1;
-    unsigned i = 0;
-    bool found = false;
-    bool valid = false;
-    BACNET_ADDRESS* cov_dest = NULL;
-
-    if (dest) {
-        for (i = 0; i < MAX_COV_ADDRESSES; i++) {
-            valid = COV_Addresses[i].valid;
-            if (valid) {
-                cov_dest = &COV_Addresses[i].dest;
-                found = bacnet_address_same(dest, cov_dest);
-                if (found) {
-                    index = i;
-                    break;
-                }
-            }
-        }
-        if (!found) {
-            /* find a free place to add a new address */
-            for (i = 0; i < MAX_COV_ADDRESSES; i++) {
-                valid = COV_Addresses[i].valid;
-                if (!valid) {
-                    index = i;
-                    cov_dest = &COV_Addresses[i].dest;
-                    bacnet_address_copy(cov_dest, dest);
-                    COV_Addresses[i].valid = true;
-                    break;
-                }
-            }
-        }
-    }
+typedef struct BACnet_Subscribe_COV_Multiple_Data {
+    uint32_t subscriberProcessIdentifier;
+    bool issueConfirmedNotificationsPresent;
+    bool issueConfirmedNotifications;
+    bool lifetimePresent;
+    uint32_t lifetime;
+    uint32_t maxNotificationDelay;
+    unsigned count;
+    BACNET_COV_REFERENCE references[MAX_COV_REFERENCES_PER_REQUEST];
+    BACNET_ERROR_CLASS error_class;
+    BACNET_ERROR_CODE error_code;
+} BACNET_SUBSCRIBE_COV_MULTIPLE_DATA;
 
-    return index;
-}
+static BACNET_SUBSCRIBE_COV_MULTIPLE_DATA COV_Multiple_Request;
 
 /*
 BACnetCOVSubscription ::= SEQUENCE {
@@ -207,10 +114,7 @@ static int cov_encode_subscription(uint8_t* apdu, int max_apdu, BACNET_COV_SUBSC
     if (!cov_subscription) {
         return 0;
     }
-    dest = cov_address_get(cov_subscription->dest_index);
-    if (!dest) {
-        return 0;
-    }
+    dest = &cov_subscription->dest;
     /* Recipient [0] BACnetRecipientProcess - opening */
     len = encode_opening_tag(&apdu[apdu_len], 0);
     apdu_len += len;
@@ -255,18 +159,33 @@ static int cov_encode_subscription(uint8_t* apdu, int max_apdu, BACNET_COV_SUBSC
         cov_subscription->monitoredObjectIdentifier.instance);
     apdu_len += len;
     /* propertyIdentifier [1] */
-    /* FIXME: we are monitoring 2 properties! How to encode? */
-    len = encode_context_enumerated(&apdu[apdu_len], 1, PROP_PRESENT_VALUE);
-    apdu_len += len;
+    if (cov_subscription->monitoredProperty == COV_OBJECT_VALUE_LIST) {
+        /* FIXME: we are monitoring 2 properties! How to encode? */
+        len = encode_context_enumerated(&apdu[apdu_len], 1, PROP_PRESENT_VALUE);
+        apdu_len += len;
+    } else {
+        len = encode_context_enumerated(&apdu[apdu_len], 1, cov_subscription->monitoredProperty);
+        apdu_len += len;
+        /* propertyArrayIndex [2] */
+        if (cov_subscription->propertyArrayIndex != BACNET_ARRAY_ALL) {
+            len = encode_context_unsigned(&apdu[apdu_len], 2, cov_subscription->propertyArrayIndex);
+            apdu_len += len;
+        }
+    }
     /* MonitoredPropertyReference [1] - closing */
     len = encode_closing_tag(&apdu[apdu_len], 1);
     apdu_len += len;
     /* IssueConfirmedNotifications [2] BOOLEAN, */
-    len = encode_context_boolean(&apdu[apdu_len], 2, cov_subscription->flag.issueConfirmedNotifications);
+    len = encode_context_boolean(&apdu[apdu_len], 2, cov_subscription->issueConfirmedNotifications);
     apdu_len += len;
     /* TimeRemaining [3] Unsigned, */
-    len = encode_context_unsigned(&apdu[apdu_len], 3, cov_subscription->lifetime);
+    len = encode_context_unsigned(&apdu[apdu_len], 3, cov_subscription_time_remaining(cov_subscription));
     apdu_len += len;
+    /* COVIncrement [4] REAL OPTIONAL */
+    if (cov_subscription->covIncrementPresent) {
+        len = encode_context_real(&apdu[apdu_len], 4, cov_subscription->covIncrement);
+        apdu_len += len;
+    }
 
     return apdu_len;
 }
@@ -288,14 +207,12 @@ int handler_cov_encode_subscriptions(uint8_t* apdu, int max_apdu) {
     unsigned index = 0;
 
     if (apdu) {
-        for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-            if (COV_Subscriptions[index].flag.valid) {
-                len = cov_encode_subscription(&apdu[apdu_len], max_apdu - apdu_len, &COV_Subscriptions[index]);
-                apdu_len += len;
-                /* TODO: too late here to notice that we overran the buffer */
-                if (apdu_len > max_apdu) {
-                    return -2;
-                }
+        for (index = 0; index < cov_subscription_count(); index++) {
+            len = cov_encode_subscription(&apdu[apdu_len], max_apdu - apdu_len, cov_subscription_get(index));
+            apdu_len += len;
+            /* TODO: too late here to notice that we overran the buffer */
+            if (apdu_len > max_apdu) {
+                return -2;
             }
         }
     }
@@ -303,109 +220,59 @@ int handler_cov_encode_subscriptions(uint8_t* apdu, int max_apdu) {
     return apdu_len;
 }
 
-/** Handler to initialize the COV list, clearing and disabling each entry.
+/** Handler to initialize the COV list, dropping all subscriptions.
  * @ingroup DSCOV
  */
 void handler_cov_init(void) {
-    unsigned index = 0;
-
-    for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-        COV_Subscriptions[index].flag.valid = false;
-        COV_Subscriptions[index].dest_index = -1;
-        COV_Subscriptions[index].subscriberProcessIdentifier = 0;
-        COV_Subscriptions[index].monitoredObjectIdentifier.type = OBJECT_ANALOG_INPUT;
-        COV_Subscriptions[index].monitoredObjectIdentifier.instance = 0;
-        COV_Subscriptions[index].flag.issueConfirmedNotifications = false;
-        COV_Subscriptions[index].invokeID = 0;
-        COV_Subscriptions[index].lifetime = 0;
-        COV_Subscriptions[index].flag.send_requested = false;
-    }
-    for (index = 0; index < MAX_COV_ADDRESSES; index++) {
-        COV_Addresses[index].valid = false;
-    }
+    cov_subscriptions_init();
 }
 
 static bool cov_list_subscribe(BACNET_ADDRESS* src,
     BACNET_SUBSCRIBE_COV_DATA* cov_data,
     BACNET_ERROR_CLASS* error_class,
     BACNET_ERROR_CODE* error_code) {
-    bool existing_entry = false;
-    int index;
-    int first_invalid_index = -1;
-    bool found = true;
-    bool address_match = false;
-    BACNET_ADDRESS* dest = NULL;
+    BACNET_COV_SUBSCRIPTION* cov_subscription = NULL;
 
-    /* unable to subscribe - resources? */
-    /* unable to cancel subscription - other? */
-
-    /* existing? - match Object ID and Process ID and address */
-    for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-        if (COV_Subscriptions[index].flag.valid) {
-            dest = cov_address_get(COV_Subscriptions[index].dest_index);
-            if (dest) {
-                address_match = bacnet_address_same(src, dest);
-            } else {
-                /* skip address matching - we don't have an address */
-                address_match = true;
-            }
-            if ((COV_Subscriptions[index].monitoredObjectIdentifier.type == cov_data->monitoredObjectIdentifier.type) &&
-                (COV_Subscriptions[index].monitoredObjectIdentifier.instance ==
-                    cov_data->monitoredObjectIdentifier.instance) &&
-                (COV_Subscriptions[index].subscriberProcessIdentifier == cov_data->subscriberProcessIdentifier) &&
-                address_match) {
-                existing_entry = true;
-                if (cov_data->cancellationRequest) {
-                    COV_Subscriptions[index].flag.valid = false;
-                    COV_Subscriptions[index].dest_index = -1;
-                    cov_address_remove_unused();
-                } else {
-                    COV_Subscriptions[index].dest_index = cov_address_add(src);
-                    COV_Subscriptions[index].flag.issueConfirmedNotifications = cov_data->issueConfirmedNotifications;
-                    COV_Subscriptions[index].lifetime = cov_data->lifetime;
-                    COV_Subscriptions[index].flag.send_requested = true;
-                }
-                if (COV_Subscriptions[index].invokeID) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
-                }
-                break;
-            }
-        } else {
-            if (first_invalid_index < 0) {
-                first_invalid_index = index;
-            }
+    /* existing? - match Object ID, Property, Process ID and address */
+    cov_subscription = cov_subscription_find(src,
+        cov_data->subscriberProcessIdentifier,
+        &cov_data->monitoredObjectIdentifier,
+        cov_data->monitoredProperty.propertyIdentifier,
+        cov_data->monitoredProperty.propertyArrayIndex);
+    if (cov_data->cancellationRequest) {
+        /* From BACnet Standard 135-2010-13.14.2
+           ...Cancellations that are issued for which no matching COV
+           context can be found shall succeed as if a context had
+           existed, returning 'Result(+)'. */
+        if (cov_subscription) {
+            cov_subscription_remove(cov_subscription);
         }
+        return true;
     }
-    if (!existing_entry && (first_invalid_index >= 0) && (!cov_data->cancellationRequest)) {
-        index = first_invalid_index;
-        found = true;
-        COV_Subscriptions[index].flag.valid = true;
-        COV_Subscriptions[index].dest_index = cov_address_add(src);
-        COV_Subscriptions[index].monitoredObjectIdentifier.type = cov_data->monitoredObjectIdentifier.type;
-        COV_Subscriptions[index].monitoredObjectIdentifier.instance = cov_data->monitoredObjectIdentifier.instance;
-        COV_Subscriptions[index].subscriberProcessIdentifier = cov_data->subscriberProcessIdentifier;
-        COV_Subscriptions[index].flag.issueConfirmedNotifications = cov_data->issueConfirmedNotifications;
-        COV_Subscriptions[index].invokeID = 0;
-        COV_Subscriptions[index].lifetime = cov_data->lifetime;
-        COV_Subscriptions[index].flag.send_requested = true;
-    } else if (!existing_entry) {
-        if (first_invalid_index < 0) {
+    if (!cov_subscription) {
+        cov_subscription = cov_subscription_add(src,
+            cov_data->subscriberProcessIdentifier,
+            &cov_data->monitoredObjectIdentifier,
+            cov_data->monitoredProperty.propertyIdentifier,
+            cov_data->monitoredProperty.propertyArrayIndex);
+        if (!cov_subscription) {
             /* Out of resources */
             *error_class = ERROR_CLASS_RESOURCES;
             *error_code = ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT;
-            found = false;
-        } else {
-            /* cancellationRequest - valid object not subscribed */
-            /* From BACnet Standard 135-2010-13.14.2
-               ...Cancellations that are issued for which no matching COV
-               context can be found shall succeed as if a context had
-               existed, returning 'Result(+)'. */
-            found = true;
+            return false;
         }
+    } else if (cov_subscription->invokeID) {
+        tsm_free_invoke_id(cov_subscription->invokeID);
+        cov_subscription->invokeID = 0;
     }
+    cov_subscription->issueConfirmedNotifications = cov_data->issueConfirmedNotifications;
+    cov_subscription->covIncrementPresent = cov_data->covIncrementPresent;
+    cov_subscription->covIncrement = cov_data->covIncrement;
+    cov_subscription_set_lifetime(cov_subscription, cov_data->lifetime);
+    /* the subscriber gets the current values right away */
+    cov_subscription_request_send(cov_subscription);
 
-    return found;
+    return true;
 }
 
 static bool cov_send_request(BACNET_COV_SUBSCRIPTION* cov_subscription, BACNET_PROPERTY_VALUE* value_list) {
@@ -428,13 +295,7 @@ static bool cov_send_request(BACNET_COV_SUBSCRIPTION* cov_subscription, BACNET_P
     if (!cov_subscription) {
         return status;
     }
-    dest = cov_address_get(cov_subscription->dest_index);
-    if (!dest) {
-#if PRINT_ENABLED
-        fprintf(stderr, "COVnotification: dest not found!\n");
-#endif
-        return status;
-    }
+    dest = &cov_subscription->dest;
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len = npdu_encode_pdu(&Handler_Transmit_Buffer[0], dest, &my_address, &npdu_data);
@@ -443,9 +304,9 @@ static bool cov_send_request(BACNET_COV_SUBSCRIPTION* cov_subscription, BACNET_P
     cov_data.initiatingDeviceIdentifier = Device_Object_Instance_Number();
     cov_data.monitoredObjectIdentifier.type = cov_subscription->monitoredObjectIdentifier.type;
     cov_data.monitoredObjectIdentifier.instance = cov_subscription->monitoredObjectIdentifier.instance;
-    cov_data.timeRemaining = cov_subscription->lifetime;
+    cov_data.timeRemaining = cov_subscription_time_remaining(cov_subscription);
     cov_data.listOfValues = value_list;
-    if (cov_subscription->flag.issueConfirmedNotifications) {
+    if (cov_subscription->issueConfirmedNotifications) {
         npdu_data.data_expecting_reply = true;
         invoke_id = tsm_next_free_invokeID();
         if (invoke_id) {
@@ -458,7 +319,7 @@ static bool cov_send_request(BACNET_COV_SUBSCRIPTION* cov_subscription, BACNET_P
         len = ucov_notify_encode_apdu(&Handler_Transmit_Buffer[pdu_len], &cov_data);
     }
     pdu_len += len;
-    if (cov_subscription->flag.issueConfirmedNotifications) {
+    if (cov_subscription->issueConfirmedNotifications) {
         tsm_set_confirmed_unsegmented_transaction(invoke_id,
             dest,
             &npdu_data,
@@ -478,196 +339,197 @@ COV_FAILED:
     return status;
 }
 
-static void cov_lifetime_expiration_handler(unsigned index, uint32_t elapsed_seconds, uint32_t lifetime_seconds) {
-    if (index < MAX_COV_SUBCRIPTIONS) {
-        /* handle lifetime expiration */
-        if (lifetime_seconds >= elapsed_seconds) {
-            COV_Subscriptions[index].lifetime -= elapsed_seconds;
-#if 0
-            fprintf(stderr, "COVtimer: subscription[%d].lifetime=%lu\n", index,
-                (unsigned long) COV_Subscriptions[index].lifetime);
-#endif
-        } else {
-            COV_Subscriptions[index].lifetime = 0;
-        }
-        if (COV_Subscriptions[index].lifetime == 0) {
-            /* expire the subscription */
-#if PRINT_ENABLED
-            fprintf(stderr, "COVtimer: PID=%u ", COV_Subscriptions[index].subscriberProcessIdentifier);
-            fprintf(stderr,
-                "%s %u ",
-                bactext_object_type_name(COV_Subscriptions[index].monitoredObjectIdentifier.type),
-                COV_Subscriptions[index].monitoredObjectIdentifier.instance);
-            fprintf(stderr, "time remaining=%u seconds ", COV_Subscriptions[index].lifetime);
-            fprintf(stderr, "\n");
-#endif
-            COV_Subscriptions[index].flag.valid = false;
-            COV_Subscriptions[index].dest_index = -1;
-            cov_address_remove_unused();
-            if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
-                if (COV_Subscriptions[index].invokeID) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
-                }
-            }
-        }
-    }
-}
-
-/** Handler to check the list of subscribed objects for any that have changed
- *  and so need to have notifications sent.
- * @ingroup DSCOV
- * This handler will be invoked by the main program every second or so.
- * This example only handles Binary Inputs, but can be easily extended to
- * support other types.
- * For each subscribed object,
- *  - See if the subscription has timed out
- *    - Remove it if it has timed out.
- *  - See if the subscribed object instance has changed
- *    (eg, check with Binary_Input_Change_Of_Value() )
- *  - If changed,
- *    - Clear the COV (eg, Binary_Input_Change_Of_Value_Clear() )
- *    - Send the notice with cov_send_request()
- *      - Will be confirmed or unconfirmed, as per the subscription.
+/** Read a property into an entry of a COV notification's value list.
  *
- * @note worst case tasking: MS/TP with the ability to send only
- *        one notification per task cycle.
- *
- * @param elapsed_seconds [in] How many seconds have elapsed since last called.
+ * @param object_type [in] The object type
+ * @param object_instance [in] The object instance
+ * @param property [in] The property
+ * @param array_index [in] The array element, or BACNET_ARRAY_ALL
+ * @param value [out] The value list entry
+ * @return true if the property is a single value that could be read
  */
-void handler_cov_timer_seconds(uint32_t elapsed_seconds) {
-    unsigned index = 0;
-    uint32_t lifetime_seconds = 0;
+static bool cov_property_value(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID property,
+    uint32_t array_index,
+    BACNET_PROPERTY_VALUE* value) {
+    BACNET_READ_PROPERTY_DATA rpdata;
+    uint8_t buffer[MAX_APDU];
+    int len = 0;
 
-    if (elapsed_seconds) {
-        /* handle the subscription timeouts */
-        for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-            if (COV_Subscriptions[index].flag.valid) {
-                lifetime_seconds = COV_Subscriptions[index].lifetime;
-                if (lifetime_seconds) {
-                    /* only expire COV with definite lifetimes */
-                    cov_lifetime_expiration_handler(index, elapsed_seconds, lifetime_seconds);
-                }
-            }
-        }
+    rpdata.object_type = object_type;
+    rpdata.object_instance = object_instance;
+    rpdata.object_property = property;
+    rpdata.array_index = array_index;
+    rpdata.application_data = &buffer[0];
+    rpdata.application_data_len = sizeof(buffer);
+    len = Device_Read_Property(&rpdata);
+    if (len <= 0) {
+        return false;
     }
+    if (bacapp_decode_application_data(&buffer[0], (unsigned)len, &value->value) != len) {
+        return false;
+    }
+    value->value.next = NULL;
+    value->propertyIdentifier = property;
+    value->propertyArrayIndex = array_index;
+    value->priority = BACNET_NO_PRIORITY;
+
+    return true;
 }
 
-bool handler_cov_fsm(void) {
-    static int index = 0;
+/** Send a COV notification with the current values of the monitored object.
+ *
+ * @param cov_subscription [in] The subscription to notify
+ * @return true once the notification went out
+ */
+static bool cov_notify(BACNET_COV_SUBSCRIPTION* cov_subscription) {
+    BACNET_PROPERTY_VALUE value_list[2];
     BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
     uint32_t object_instance = 0;
-    bool status = false;
-    bool send = false;
-    BACNET_PROPERTY_VALUE value_list[2];
-    /* states for transmitting */
-    static enum {
-        COV_STATE_IDLE = 0,
-        COV_STATE_MARK,
-        COV_STATE_CLEAR,
-        COV_STATE_FREE,
-        COV_STATE_SEND
-    } cov_task_state = COV_STATE_IDLE;
-
-    switch (cov_task_state) {
-    case COV_STATE_IDLE:
-        index = 0;
-        cov_task_state = COV_STATE_MARK;
-        break;
-    case COV_STATE_MARK:
-        /* mark any subscriptions where the value has changed */
-        if (COV_Subscriptions[index].flag.valid) {
-            object_type = (BACNET_OBJECT_TYPE)COV_Subscriptions[index].monitoredObjectIdentifier.type;
-            object_instance = COV_Subscriptions[index].monitoredObjectIdentifier.instance;
-            status = Device_COV(object_type, object_instance);
-            if (status) {
-                COV_Subscriptions[index].flag.send_requested = true;
+    uint8_t buffer[MAX_APDU];
+    int len = 0;
+
+    object_type = (BACNET_OBJECT_TYPE)cov_subscription->monitoredObjectIdentifier.type;
+    object_instance = cov_subscription->monitoredObjectIdentifier.instance;
 #if PRINT_ENABLED
-                fprintf(stderr, "COVtask: Marking...\n");
+    fprintf(stderr, "COVtask: Sending...\n");
 #endif
-            }
+    /* configure the linked list for the two properties */
+    value_list[0].next = &value_list[1];
+    value_list[1].next = NULL;
+    if (cov_subscription->monitoredProperty != COV_OBJECT_VALUE_LIST) {
+        /* the monitored property, and Status_Flags if the object has them */
+        if (!cov_property_value(object_type,
+                object_instance,
+                cov_subscription->monitoredProperty,
+                cov_subscription->propertyArrayIndex,
+                &value_list[0])) {
+            return false;
         }
-        index++;
-        if (index >= MAX_COV_SUBCRIPTIONS) {
-            index = 0;
-            cov_task_state = COV_STATE_CLEAR;
+        if ((cov_subscription->monitoredProperty == PROP_STATUS_FLAGS) ||
+            !cov_property_value(object_type, object_instance, PROP_STATUS_FLAGS, BACNET_ARRAY_ALL, &value_list[1])) {
+            value_list[0].next = NULL;
         }
-        break;
-    case COV_STATE_CLEAR:
-        /* clear the COV flag after checking all subscriptions */
-        if ((COV_Subscriptions[index].flag.valid) && (COV_Subscriptions[index].flag.send_requested)) {
-            object_type = (BACNET_OBJECT_TYPE)COV_Subscriptions[index].monitoredObjectIdentifier.type;
-            object_instance = COV_Subscriptions[index].monitoredObjectIdentifier.instance;
-            Device_COV_Clear(object_type, object_instance);
-        }
-        index++;
-        if (index >= MAX_COV_SUBCRIPTIONS) {
-            index = 0;
-            cov_task_state = COV_STATE_FREE;
+    } else if (!Device_Encode_Value_List(object_type, object_instance, &value_list[0])) {
+        return false;
+    }
+    if (!cov_send_request(cov_subscription, &value_list[0])) {
+        return false;
+    }
+    if (cov_subscription->monitoredProperty != COV_OBJECT_VALUE_LIST) {
+        /* the next change is measured against what the subscriber got, the initial value included */
+        len = bacapp_encode_application_data(&buffer[0], &value_list[0].value);
+        if (len > 0) {
+            cov_subscription_notified(cov_subscription, &buffer[0], (unsigned)len);
         }
-        break;
-    case COV_STATE_FREE:
-        /* confirmed notification house keeping */
-        if ((COV_Subscriptions[index].flag.valid) && (COV_Subscriptions[index].flag.issueConfirmedNotifications) &&
-            (COV_Subscriptions[index].invokeID)) {
-            if (tsm_invoke_id_free(COV_Subscriptions[index].invokeID)) {
-                COV_Subscriptions[index].invokeID = 0;
-            } else if (tsm_invoke_id_failed(COV_Subscriptions[index].invokeID)) {
-                tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                COV_Subscriptions[index].invokeID = 0;
-            }
+    }
+
+    return true;
+}
+
+/** Send a COV-Multiple notification with the changes collected for a
+ * SubscribeCOVPropertyMultiple subscriber, as many as fit the subscriber's
+ * max APDU.
+ *
+ * @param cov_subscription [in] The subscriptions of the subscriber process
+ * @return true once the notification went out
+ */
+static bool cov_notify_multiple(BACNET_COV_MULTIPLE_SUBSCRIPTION* cov_subscription) {
+    int len = 0;
+    int pdu_len = 0;
+    int apdu_len = 0;
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_ADDRESS my_address;
+    int bytes_sent = 0;
+    uint8_t invoke_id = 0;
+    uint8_t* apdu = NULL;
+
+    if (!dcc_communication_enabled()) {
+        return false;
+    }
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, cov_subscription->issueConfirmedNotifications, MESSAGE_PRIORITY_NORMAL);
+    pdu_len = npdu_encode_pdu(&Handler_Transmit_Buffer[0], &cov_subscription->dest, &my_address, &npdu_data);
+    apdu = &Handler_Transmit_Buffer[pdu_len];
+    if (cov_subscription->issueConfirmedNotifications) {
+        invoke_id = tsm_next_free_invokeID();
+        if (!invoke_id) {
+            return false;
         }
-        index++;
-        if (index >= MAX_COV_SUBCRIPTIONS) {
-            index = 0;
-            cov_task_state = COV_STATE_SEND;
+        apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+        apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+        apdu[2] = invoke_id;
+        apdu[3] = COV_SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE;
+        apdu_len = 4;
+    } else {
+        apdu[0] = PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+        apdu[1] = COV_SERVICE_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE;
+        apdu_len = 2;
+    }
+    /* subscriberProcessIdentifier [0] Unsigned32 */
+    apdu_len += encode_context_unsigned(&apdu[apdu_len], 0, cov_subscription->subscriberProcessIdentifier);
+    /* initiatingDeviceIdentifier [1] BACnetObjectIdentifier */
+    apdu_len += encode_context_object_id(&apdu[apdu_len], 1, OBJECT_DEVICE, Device_Object_Instance_Number());
+    /* timeRemaining [2] Unsigned */
+    apdu_len += encode_context_unsigned(&apdu[apdu_len], 2, cov_multiple_time_remaining(cov_subscription));
+    /* listOfCOVNotifications [4] */
+    len = cov_multiple_encode_notifications(cov_subscription, &apdu[apdu_len], cov_subscription->max_apdu - apdu_len);
+    if (len <= 0) {
+        if (invoke_id) {
+            tsm_free_invoke_id(invoke_id);
         }
-        break;
-    case COV_STATE_SEND:
-        /* send any COVs that are requested */
-        if ((COV_Subscriptions[index].flag.valid) && (COV_Subscriptions[index].flag.send_requested)) {
-            send = true;
-            if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
-                if (COV_Subscriptions[index].invokeID != 0) {
-                    /* already sending */
-                    send = false;
-                }
-                if (!tsm_transaction_available()) {
-                    /* no transactions available - can't send now */
-                    send = false;
-                }
-            }
-            if (send) {
-                object_type = (BACNET_OBJECT_TYPE)COV_Subscriptions[index].monitoredObjectIdentifier.type;
-                object_instance = COV_Subscriptions[index].monitoredObjectIdentifier.instance;
+        return false;
+    }
+    apdu_len += len;
+    pdu_len += apdu_len;
+    if (invoke_id) {
+        cov_subscription->invokeID = invoke_id;
+        tsm_set_confirmed_unsegmented_transaction(invoke_id,
+            &cov_subscription->dest,
+            &npdu_data,
+            &Handler_Transmit_Buffer[0],
+            (uint16_t)pdu_len);
+    }
+    bytes_sent = datalink_send_pdu(&cov_subscription->dest, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    if (bytes_sent <= 0) {
+        return false;
+    }
 #if PRINT_ENABLED
-                fprintf(stderr, "COVtask: Sending...\n");
+    fprintf(stderr, "COVnotificationMultiple: Sent!\n");
 #endif
-                /* configure the linked list for the two properties */
-                value_list[0].next = &value_list[1];
-                value_list[1].next = NULL;
-                status = Device_Encode_Value_List(object_type, object_instance, &value_list[0]);
-                if (status) {
-                    status = cov_send_request(&COV_Subscriptions[index], &value_list[0]);
-                }
-                if (status) {
-                    COV_Subscriptions[index].flag.send_requested = false;
-                }
-            }
-        }
-        index++;
-        if (index >= MAX_COV_SUBCRIPTIONS) {
-            index = 0;
-            cov_task_state = COV_STATE_IDLE;
-        }
-        break;
-    default:
-        index = 0;
-        cov_task_state = COV_STATE_IDLE;
-        break;
+    cov_multiple_notified(cov_subscription);
+
+    return true;
+}
+
+/** Handler to expire subscriptions whose lifetime ran out.
+ * @ingroup DSCOV
+ * Only the subscriptions that expire are visited, the subscription
+ * table keeps them ordered by expiry time.
+ *
+ * @param elapsed_seconds [in] How many seconds have elapsed since last called.
+ */
+void handler_cov_timer_seconds(uint32_t elapsed_seconds) {
+    if (elapsed_seconds) {
+        cov_subscriptions_timer(elapsed_seconds);
     }
+}
+
+/** Handler to send the notifications that are due.
+ * @ingroup DSCOV
+ * Every monitored object is checked for a change once, however many
+ * subscriptions it has, and the notifications of changed objects and
+ * new subscriptions are sent, confirmed or unconfirmed as per the
+ * subscription. Changes of SubscribeCOVPropertyMultiple subscriptions
+ * are sent once the subscriber's max notification delay has passed.
+ *
+ * @return true, a call always completes a full pass
+ */
+bool handler_cov_fsm(void) {
+    cov_subscriptions_task(cov_notify, cov_notify_multiple);
 
-    return (cov_task_state == COV_STATE_IDLE);
+    return true;
 }
 
 void handler_cov_task(void) {
@@ -681,11 +543,25 @@ static bool cov_subscribe(BACNET_ADDRESS* src,
     bool status = false; /* return value */
     BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
     uint32_t object_instance = 0;
+    BACNET_PROPERTY_VALUE value;
 
     object_type = (BACNET_OBJECT_TYPE)cov_data->monitoredObjectIdentifier.type;
     object_instance = cov_data->monitoredObjectIdentifier.instance;
     status = Device_Valid_Object_Id(object_type, object_instance);
-    if (status) {
+    if (status && (cov_data->monitoredProperty.propertyIdentifier != COV_OBJECT_VALUE_LIST)) {
+        /* SubscribeCOVProperty: any property that reads as a single value */
+        if (!cov_data->cancellationRequest &&
+            !cov_property_value(object_type,
+                object_instance,
+                cov_data->monitoredProperty.propertyIdentifier,
+                cov_data->monitoredProperty.propertyArrayIndex,
+                &value)) {
+            *error_class = ERROR_CLASS_PROPERTY;
+            *error_code = ERROR_CODE_NOT_COV_PROPERTY;
+            return false;
+        }
+        status = cov_list_subscribe(src, cov_data, error_class, error_code);
+    } else if (status) {
         status = Device_Value_List_Supported(object_type);
         if (status) {
             status = cov_list_subscribe(src, cov_data, error_class, error_code);
@@ -701,11 +577,9 @@ static bool cov_subscribe(BACNET_ADDRESS* src,
     return status;
 }
 
-/** Handler for a COV Subscribe Service request.
+/** Handles a SubscribeCOV or SubscribeCOVProperty Service request.
  * @ingroup DSCOV
- * This handler will be invoked by apdu_handler() if it has been enabled
- * by a call to apdu_set_confirmed_handler().
- * This handler builds a response packet, which is
+ * This builds a response packet, which is
  * - an Abort if
  *   - the message is segmented
  *   - if decoding fails
@@ -717,11 +591,14 @@ static bool cov_subscribe(BACNET_ADDRESS* src,
  * @param src [in] BACNET_ADDRESS of the source of the message
  * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
  *                          decoded from the APDU header of this message.
+ * @param service [in] SERVICE_CONFIRMED_SUBSCRIBE_COV or
+ *                     SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY
  */
-void handler_cov_subscribe(uint8_t* service_request,
+static void cov_subscribe_handler(uint8_t* service_request,
     uint16_t service_len,
     BACNET_ADDRESS* src,
-    BACNET_CONFIRMED_SERVICE_DATA* service_data) {
+    BACNET_CONFIRMED_SERVICE_DATA* service_data,
+    BACNET_CONFIRMED_SERVICE service) {
     BACNET_SUBSCRIBE_COV_DATA cov_data;
     int len = 0;
     int pdu_len = 0;
@@ -748,7 +625,17 @@ void handler_cov_subscribe(uint8_t* service_request,
         error = true;
         goto COV_ABORT;
     }
-    len = cov_subscribe_decode_service_request(service_request, service_len, &cov_data);
+    if (service == SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY) {
+        cov_data.covIncrementPresent = false;
+        len = cov_subscribe_property_decode_service_request(service_request, service_len, &cov_data);
+    } else {
+        len = cov_subscribe_decode_service_request(service_request, service_len, &cov_data);
+        /* the object's COV value list */
+        cov_data.monitoredProperty.propertyIdentifier = COV_OBJECT_VALUE_LIST;
+        cov_data.monitoredProperty.propertyArrayIndex = BACNET_ARRAY_ALL;
+        cov_data.covIncrementPresent = false;
+        cov_data.covIncrement = 0.0f;
+    }
 #if PRINT_ENABLED
     if (len <= 0)
         fprintf(stderr, "SubscribeCOV: Unable to decode Request!\n");
@@ -763,7 +650,7 @@ void handler_cov_subscribe(uint8_t* service_request,
     if (success) {
         apdu_len = encode_simple_ack(&Handler_Transmit_Buffer[npdu_len],
             service_data->invoke_id,
-            SERVICE_CONFIRMED_SUBSCRIBE_COV);
+            service);
 #if PRINT_ENABLED
         fprintf(stderr, "SubscribeCOV: Sending Simple Ack!\n");
 #endif
@@ -787,7 +674,7 @@ COV_ABORT:
         } else if (len == BACNET_STATUS_ERROR) {
             apdu_len = bacerror_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
                 service_data->invoke_id,
-                SERVICE_CONFIRMED_SUBSCRIBE_COV,
+                service,
                 cov_data.error_class,
                 cov_data.error_code);
 #if PRINT_ENABLED
@@ -812,3 +699,434 @@ COV_ABORT:
 
     return;
 }
+
+/** Handler for a COV Subscribe Service request.
+ * @ingroup DSCOV
+ * This handler will be invoked by apdu_handler() if it has been enabled
+ * by a call to apdu_set_confirmed_handler().
+ */
+void handler_cov_subscribe(uint8_t* service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS* src,
+    BACNET_CONFIRMED_SERVICE_DATA* service_data) {
+    cov_subscribe_handler(service_request, service_len, src, service_data, SERVICE_CONFIRMED_SUBSCRIBE_COV);
+}
+
+/** Handler for a COV Subscribe Property Service request.
+ * @ingroup DSCOV
+ * Like SubscribeCOV, for a single property of any object. Changes of a
+ * REAL property smaller than the subscription's COV increment are not
+ * notified. The COV increment of a property of another datatype is
+ * accepted and ignored, as the standard requires, and any change of
+ * such a property is notified.
+ */
+void handler_cov_subscribe_property(uint8_t* service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS* src,
+    BACNET_CONFIRMED_SERVICE_DATA* service_data) {
+    cov_subscribe_handler(service_request, service_len, src, service_data, SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY);
+}
+
+/* header of the next tag if it is the primitive context tag tag_number, 0 otherwise */
+static int cov_decode_context_tag(uint8_t* apdu, unsigned apdu_len, int len, uint8_t tag_number, uint32_t* len_value) {
+    uint8_t decoded_tag = 0;
+    int tag_len = 0;
+
+    if ((unsigned)len >= apdu_len) {
+        return 0;
+    }
+    if (!decode_is_context_tag(&apdu[len], tag_number) || decode_is_opening_tag(&apdu[len]) ||
+        decode_is_closing_tag(&apdu[len])) {
+        return 0;
+    }
+    tag_len = decode_tag_number_and_value(&apdu[len], &decoded_tag, len_value);
+    if ((unsigned)len + tag_len + *len_value > apdu_len) {
+        return 0;
+    }
+
+    return tag_len;
+}
+
+static bool cov_decode_is_opening_tag(uint8_t* apdu, unsigned apdu_len, int len, uint8_t tag_number) {
+    return ((unsigned)len < apdu_len) && decode_is_opening_tag_number(&apdu[len], tag_number);
+}
+
+static bool cov_decode_is_closing_tag(uint8_t* apdu, unsigned apdu_len, int len, uint8_t tag_number) {
+    return ((unsigned)len < apdu_len) && decode_is_closing_tag_number(&apdu[len], tag_number);
+}
+
+/*
+SubscribeCOVPropertyMultiple-Request ::= SEQUENCE {
+    subscriberProcessIdentifier [0] Unsigned32,
+    issueConfirmedNotifications [1] BOOLEAN OPTIONAL,
+    lifetime [2] Unsigned OPTIONAL,
+    maxNotificationDelay [3] Unsigned OPTIONAL,
+    listOfCovSubscriptionSpecifications [4] SEQUENCE OF SEQUENCE {
+        monitoredObjectIdentifier [0] BACnetObjectIdentifier,
+        listOfCovReferences [1] SEQUENCE OF SEQUENCE {
+            monitoredProperty [0] BACnetPropertyReference,
+            covIncrement [1] REAL OPTIONAL,
+            timestamped [2] BOOLEAN
+        }
+    }
+}
+*/
+static int cov_subscribe_multiple_decode_service_request(uint8_t* apdu,
+    unsigned apdu_len,
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA* data) {
+    int len = 0;
+    int tag_len = 0;
+    uint8_t tag_number = 0;
+    uint32_t len_value = 0;
+    uint32_t decoded_value = 0;
+    uint16_t decoded_type = 0;
+    BACNET_OBJECT_ID object_id;
+    BACNET_COV_REFERENCE* reference = NULL;
+
+    data->error_code = ERROR_CODE_REJECT_MISSING_REQUIRED_PARAMETER;
+    data->count = 0;
+    data->maxNotificationDelay = 0;
+    /* subscriberProcessIdentifier [0] Unsigned32 */
+    tag_len = cov_decode_context_tag(apdu, apdu_len, len, 0, &len_value);
+    if (!tag_len) {
+        return BACNET_STATUS_REJECT;
+    }
+    len += tag_len;
+    if (len_value > 4) {
+        data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+        return BACNET_STATUS_REJECT;
+    }
+    len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+    data->subscriberProcessIdentifier = decoded_value;
+    /* issueConfirmedNotifications [1] BOOLEAN OPTIONAL */
+    data->issueConfirmedNotificationsPresent = false;
+    tag_len = cov_decode_context_tag(apdu, apdu_len, len, 1, &len_value);
+    if (tag_len) {
+        len += tag_len;
+        if (len_value != 1) {
+            data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+            return BACNET_STATUS_REJECT;
+        }
+        data->issueConfirmedNotifications = decode_context_boolean(&apdu[len]);
+        data->issueConfirmedNotificationsPresent = true;
+        len += len_value;
+    }
+    /* lifetime [2] Unsigned OPTIONAL */
+    data->lifetimePresent = false;
+    tag_len = cov_decode_context_tag(apdu, apdu_len, len, 2, &len_value);
+    if (tag_len) {
+        len += tag_len;
+        if (len_value > 4) {
+            data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+            return BACNET_STATUS_REJECT;
+        }
+        len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+        data->lifetime = decoded_value;
+        data->lifetimePresent = true;
+    }
+    /* both or neither, neither is a cancellation */
+    if (data->issueConfirmedNotificationsPresent != data->lifetimePresent) {
+        return BACNET_STATUS_REJECT;
+    }
+    /* maxNotificationDelay [3] Unsigned OPTIONAL */
+    tag_len = cov_decode_context_tag(apdu, apdu_len, len, 3, &len_value);
+    if (tag_len) {
+        len += tag_len;
+        if (len_value > 4) {
+            data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+            return BACNET_STATUS_REJECT;
+        }
+        len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+        data->maxNotificationDelay = decoded_value;
+    }
+    /* listOfCovSubscriptionSpecifications [4] */
+    if (!cov_decode_is_opening_tag(apdu, apdu_len, len, 4)) {
+        return BACNET_STATUS_REJECT;
+    }
+    len++;
+    while (!cov_decode_is_closing_tag(apdu, apdu_len, len, 4)) {
+        /* monitoredObjectIdentifier [0] BACnetObjectIdentifier */
+        tag_len = cov_decode_context_tag(apdu, apdu_len, len, 0, &len_value);
+        if (!tag_len) {
+            return BACNET_STATUS_REJECT;
+        }
+        len += tag_len;
+        if (len_value != 4) {
+            data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+            return BACNET_STATUS_REJECT;
+        }
+        len += decode_object_id(&apdu[len], &decoded_type, &object_id.instance);
+        object_id.type = decoded_type;
+        /* listOfCovReferences [1] */
+        if (!cov_decode_is_opening_tag(apdu, apdu_len, len, 1)) {
+            return BACNET_STATUS_REJECT;
+        }
+        len++;
+        while (!cov_decode_is_closing_tag(apdu, apdu_len, len, 1)) {
+            if (data->count >= MAX_COV_REFERENCES_PER_REQUEST) {
+                data->error_code = ERROR_CODE_ABORT_BUFFER_OVERFLOW;
+                return BACNET_STATUS_ABORT;
+            }
+            reference = &data->references[data->count];
+            reference->monitoredObjectIdentifier = object_id;
+            /* monitoredProperty [0] BACnetPropertyReference */
+            if (!cov_decode_is_opening_tag(apdu, apdu_len, len, 0)) {
+                return BACNET_STATUS_REJECT;
+            }
+            len++;
+            tag_len = cov_decode_context_tag(apdu, apdu_len, len, 0, &len_value);
+            if (!tag_len) {
+                return BACNET_STATUS_REJECT;
+            }
+            len += tag_len;
+            if (len_value > 4) {
+                data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+                return BACNET_STATUS_REJECT;
+            }
+            len += decode_enumerated(&apdu[len], len_value, &decoded_value);
+            reference->monitoredProperty = (BACNET_PROPERTY_ID)decoded_value;
+            reference->propertyArrayIndex = BACNET_ARRAY_ALL;
+            tag_len = cov_decode_context_tag(apdu, apdu_len, len, 1, &len_value);
+            if (tag_len) {
+                len += tag_len;
+                if (len_value > 4) {
+                    data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+                    return BACNET_STATUS_REJECT;
+                }
+                len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+                reference->propertyArrayIndex = decoded_value;
+            }
+            if (!cov_decode_is_closing_tag(apdu, apdu_len, len, 0)) {
+                return BACNET_STATUS_REJECT;
+            }
+            len++;
+            /* covIncrement [1] REAL OPTIONAL */
+            reference->covIncrementPresent = false;
+            reference->covIncrement = 0.0f;
+            tag_len = cov_decode_context_tag(apdu, apdu_len, len, 1, &len_value);
+            if (tag_len) {
+                len += tag_len;
+                if (len_value != 4) {
+                    data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+                    return BACNET_STATUS_REJECT;
+                }
+                len += decode_real(&apdu[len], &reference->covIncrement);
+                reference->covIncrementPresent = true;
+            }
+            /* timestamped [2] BOOLEAN */
+            tag_len = cov_decode_context_tag(apdu, apdu_len, len, 2, &len_value);
+            if (!tag_len) {
+                return BACNET_STATUS_REJECT;
+            }
+            len += tag_len;
+            if (len_value != 1) {
+                data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+                return BACNET_STATUS_REJECT;
+            }
+            reference->timestamped = decode_context_boolean(&apdu[len]);
+            len += len_value;
+            data->count++;
+        }
+        len++;
+    }
+    len++;
+
+    return len;
+}
+
+/*
+SubscribeCOVPropertyMultiple-Error ::= SEQUENCE {
+    error-type [0] Error,
+    first-failed-subscription [1] SEQUENCE {
+        monitoredObjectIdentifier [0] BACnetObjectIdentifier,
+        monitoredPropertyReference [1] BACnetPropertyReference,
+        errorType [2] Error
+    }
+}
+*/
+static int cov_subscribe_multiple_error_encode_apdu(uint8_t* apdu,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code,
+    BACNET_COV_REFERENCE* reference) {
+    int len = 0;
+
+    apdu[0] = PDU_TYPE_ERROR;
+    apdu[1] = invoke_id;
+    apdu[2] = COV_SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE;
+    len = 3;
+    len += encode_opening_tag(&apdu[len], 0);
+    len += encode_application_enumerated(&apdu[len], error_class);
+    len += encode_application_enumerated(&apdu[len], error_code);
+    len += encode_closing_tag(&apdu[len], 0);
+    len += encode_opening_tag(&apdu[len], 1);
+    len += encode_context_object_id(&apdu[len],
+        0,
+        (BACNET_OBJECT_TYPE)reference->monitoredObjectIdentifier.type,
+        reference->monitoredObjectIdentifier.instance);
+    len += encode_opening_tag(&apdu[len], 1);
+    len += encode_context_enumerated(&apdu[len], 0, reference->monitoredProperty);
+    if (reference->propertyArrayIndex != BACNET_ARRAY_ALL) {
+        len += encode_context_unsigned(&apdu[len], 1, reference->propertyArrayIndex);
+    }
+    len += encode_closing_tag(&apdu[len], 1);
+    len += encode_opening_tag(&apdu[len], 2);
+    len += encode_application_enumerated(&apdu[len], error_class);
+    len += encode_application_enumerated(&apdu[len], error_code);
+    len += encode_closing_tag(&apdu[len], 2);
+    len += encode_closing_tag(&apdu[len], 1);
+
+    return len;
+}
+
+/* Subscribes to all properties of the request or to none of them,
+   failed is the first property that could not be subscribed. */
+static bool cov_subscribe_multiple(BACNET_ADDRESS* src,
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA* data,
+    BACNET_CONFIRMED_SERVICE_DATA* service_data,
+    unsigned* failed) {
+    BACNET_COV_MULTIPLE_SUBSCRIPTION* cov_subscription = NULL;
+    BACNET_READ_PROPERTY_DATA rpdata;
+    uint8_t value[MAX_APDU];
+    unsigned index = 0;
+    int len = 0;
+
+    cov_subscription = cov_multiple_find(src, data->subscriberProcessIdentifier);
+    if (!data->lifetimePresent) {
+        /* cancellations without a matching subscription succeed as well */
+        if (cov_subscription) {
+            cov_multiple_cancel(cov_subscription, &data->references[0], data->count);
+        }
+        return true;
+    }
+    if (data->count == 0) {
+        return true;
+    }
+    for (index = 0; index < data->count; index++) {
+        BACNET_COV_REFERENCE* reference = &data->references[index];
+
+        *failed = index;
+        if (!Device_Valid_Object_Id(reference->monitoredObjectIdentifier.type,
+                reference->monitoredObjectIdentifier.instance)) {
+            data->error_class = ERROR_CLASS_OBJECT;
+            data->error_code = ERROR_CODE_UNKNOWN_OBJECT;
+            return false;
+        }
+        /* the property has to be readable to be monitored */
+        rpdata.object_type = (BACNET_OBJECT_TYPE)reference->monitoredObjectIdentifier.type;
+        rpdata.object_instance = reference->monitoredObjectIdentifier.instance;
+        rpdata.object_property = reference->monitoredProperty;
+        rpdata.array_index = reference->propertyArrayIndex;
+        rpdata.application_data = &value[0];
+        rpdata.application_data_len = sizeof(value);
+        rpdata.error_class = ERROR_CLASS_PROPERTY;
+        rpdata.error_code = ERROR_CODE_UNKNOWN_PROPERTY;
+        len = Device_Read_Property(&rpdata);
+        if (len == BACNET_STATUS_ERROR) {
+            data->error_class = rpdata.error_class;
+            data->error_code = rpdata.error_code;
+            return false;
+        } else if (len < 0) {
+            data->error_class = ERROR_CLASS_RESOURCES;
+            data->error_code = ERROR_CODE_OTHER;
+            return false;
+        }
+    }
+    *failed = 0;
+    cov_subscription =
+        cov_multiple_subscribe(src, data->subscriberProcessIdentifier, &data->references[0], data->count);
+    if (!cov_subscription) {
+        /* Out of resources */
+        data->error_class = ERROR_CLASS_RESOURCES;
+        data->error_code = ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT;
+        return false;
+    }
+    cov_subscription->issueConfirmedNotifications = data->issueConfirmedNotifications;
+    cov_subscription->maxNotificationDelay = data->maxNotificationDelay;
+    cov_subscription->max_apdu = (service_data->max_resp < MAX_APDU) ? service_data->max_resp : MAX_APDU;
+    cov_multiple_set_lifetime(cov_subscription, data->lifetime);
+
+    return true;
+}
+
+/** Handler for a SubscribeCOVPropertyMultiple Service request.
+ * @ingroup DSCOV
+ * This handler builds a response packet, which is
+ * - an Abort if
+ *   - the message is segmented
+ *   - the request names more properties than MAX_COV_REFERENCES_PER_REQUEST
+ * - a Reject if decoding fails
+ * - an ACK, if cov_subscribe_multiple() succeeds
+ * - a SubscribeCOVPropertyMultiple-Error naming the first failed
+ *   subscription if cov_subscribe_multiple() fails
+ *
+ * @param service_request [in] The contents of the service request.
+ * @param service_len [in] The length of the service_request.
+ * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
+ *                          decoded from the APDU header of this message.
+ */
+void handler_cov_subscribe_property_multiple(uint8_t* service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS* src,
+    BACNET_CONFIRMED_SERVICE_DATA* service_data) {
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA* data = &COV_Multiple_Request;
+    int len = 0;
+    int pdu_len = 0;
+    int npdu_len = 0;
+    int apdu_len = 0;
+    BACNET_NPDU_DATA npdu_data;
+    int bytes_sent = 0;
+    BACNET_ADDRESS my_address;
+    unsigned failed = 0;
+
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    npdu_len = npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    if (service_data->segmented_message) {
+        /* we don't support segmentation - send an abort */
+        len = BACNET_STATUS_ABORT;
+        data->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
+    } else {
+        len = cov_subscribe_multiple_decode_service_request(service_request, service_len, data);
+    }
+    if (len == BACNET_STATUS_ABORT) {
+        apdu_len = abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            service_data->invoke_id,
+            abort_convert_error_code(data->error_code),
+            true);
+#if PRINT_ENABLED
+        fprintf(stderr, "SubscribeCOVPropertyMultiple: Sending Abort!\n");
+#endif
+    } else if (len < 0) {
+        apdu_len = reject_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            service_data->invoke_id,
+            reject_convert_error_code(data->error_code));
+#if PRINT_ENABLED
+        fprintf(stderr, "SubscribeCOVPropertyMultiple: Sending Reject!\n");
+#endif
+    } else if (cov_subscribe_multiple(src, data, service_data, &failed)) {
+        apdu_len = encode_simple_ack(&Handler_Transmit_Buffer[npdu_len],
+            service_data->invoke_id,
+            COV_SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE);
+#if PRINT_ENABLED
+        fprintf(stderr, "SubscribeCOVPropertyMultiple: Sending Simple Ack!\n");
+#endif
+    } else {
+        apdu_len = cov_subscribe_multiple_error_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            service_data->invoke_id,
+            data->error_class,
+            data->error_code,
+            &data->references[failed]);
+#if PRINT_ENABLED
+        fprintf(stderr, "SubscribeCOVPropertyMultiple: Sending Error!\n");
+#endif
+    }
+    pdu_len = npdu_len + apdu_len;
+    bytes_sent = datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    if (bytes_sent <= 0) {
+#if PRINT_ENABLED
+        fprintf(stderr, "SubscribeCOVPropertyMultiple: Failed to send PDU (%s)!\n", strerror(errno));
+#endif
+    }
+}
@@ -38,6 +38,7 @@
 #include "getevent.h"
 #include "abort.h"
 #include "handlers.h"
+#include "c_wrapper.h"
 
 /** @file h_getevent.c  Handles Get Event Information request. */
 
@@ -109,22 +110,22 @@ void handler_get_event_information(uint8_t* service_request,
     apdu_len = len;
     for (i = 0; i < MAX_BACNET_OBJECT_TYPE; i++) {
         if (Get_Event_Info[i]) {
-            for (j = 0; j < 0xffff; j++) {
+            /* the event information functions index the active events of
+               their type in object identifier order, so resume right after
+               the 'Last Received Object Identifier' */
+            j = 0;
+            if (object_id.type != MAX_BACNET_OBJECT_TYPE) {
+                if (i < object_id.type) {
+                    continue;
+                } else if (i == object_id.type) {
+                    j = Device_Active_Alarm_Index((BACNET_OBJECT_TYPE)i, object_id.instance);
+                }
+            }
+            for (; j < 0xffff; j++) {
                 valid_event = Get_Event_Info[i](j, &getevent_data);
                 if (valid_event == 0) {
                     continue;
                 } else if (valid_event > 0) {
-                    /* encode GetEvent_data only when type of object_id has max value */
-                    if (object_id.type != MAX_BACNET_OBJECT_TYPE) {
-                        if ((object_id.type == getevent_data.objectIdentifier.type) &&
-                            (object_id.instance == getevent_data.objectIdentifier.instance)) {
-                            /* found 'Last Received Object Identifier'
-                               so should set type of object_id to max value */
-                            object_id.type = MAX_BACNET_OBJECT_TYPE;
-                            continue;
-                        }
-                    }
-
                     getevent_data.next = NULL;
                     len = getevent_ack_encode_apdu_data(&Handler_Transmit_Buffer[pdu_len],
                         sizeof(Handler_Transmit_Buffer) - pdu_len,
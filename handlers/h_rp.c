@@ -43,6 +43,7 @@
 
 #include "c_wrapper.h"
 #include "handlers.h"
+#include "segmentation.h"
 
 /**
  * Check for error during property reading and send PDU.
@@ -60,6 +61,7 @@ void readproperty_send_pdu(bool error, int err_type, int apdu_len, int npdu_len,
 {
     if (error) {
         if (BACNET_STATUS_ABORT == err_type) {
+            rp_data->error_code = segmentation_abort_error_code(service_data, rp_data->error_code);
             apdu_len = abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len], service_data->invoke_id, abort_convert_error_code(rp_data->error_code), true);
 #if PRINT_ENABLED
             fprintf(stderr, "RP: Sending Abort!\n");
@@ -112,6 +114,8 @@ void handler_read_property(uint8_t* service_request, uint16_t service_len, BACNE
     BACNET_NPDU_DATA npdu_data;
     bool error = true;
     BACNET_ADDRESS my_address;
+    uint8_t* apdu = NULL;
+    int max_apdu = 0;
 
     // Configure default error code as an abort since it is common
     rp_data.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
@@ -148,16 +152,19 @@ void handler_read_property(uint8_t* service_request, uint16_t service_len, BACNE
         rp_data.object_instance = Device_Object_Instance_Number();
     }
 
-    apdu_len = rp_ack_encode_apdu_init(&Handler_Transmit_Buffer[npdu_len], service_data->invoke_id, &rp_data);
-    // Configure our storage
-    rp_data.application_data = &Handler_Transmit_Buffer[npdu_len + apdu_len];
-    rp_data.application_data_len = sizeof(Handler_Transmit_Buffer) - (npdu_len + apdu_len);
+    // The ack is encoded unsegmented, it is split into segments when it doesn't fit the requester's max APDU
+    apdu = segmentation_buffer();
+    max_apdu = segmentation_max_apdu(service_data);
+    apdu_len = rp_ack_encode_apdu_init(&apdu[0], service_data->invoke_id, &rp_data);
+    // Configure our storage, leaving room for the closing tag
+    rp_data.application_data = &apdu[apdu_len];
+    rp_data.application_data_len = max_apdu - apdu_len - 1;
     len = Device_Read_Property(&rp_data);
     if (len >= 0) {
         apdu_len += len;
-        len = rp_ack_encode_apdu_object_property_end(&Handler_Transmit_Buffer[npdu_len + apdu_len]);
+        len = rp_ack_encode_apdu_object_property_end(&apdu[apdu_len]);
         apdu_len += len;
-        if (apdu_len > service_data->max_resp) {
+        if (apdu_len > max_apdu) {
             // Too big for the sender - send an abort
             // Setting of error code needed here as read property processing may have overriden the default set at start
             rp_data.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
@@ -185,5 +192,9 @@ void handler_read_property(uint8_t* service_request, uint16_t service_len, BACNE
         }
 #endif
     }
+    if (!error) {
+        segmentation_send_complex_ack(src, service_data, apdu, apdu_len);
+        return;
+    }
     readproperty_send_pdu(error, len, apdu_len, npdu_len, &npdu_data, service_data, &rp_data, src);
 }
@@ -43,9 +43,12 @@
 #include "handlers.h"
 /* device object has custom handler for all objects */
 #include "c_wrapper.h"
+#include "segmentation.h"
 
 /** @file h_rpm.c  Handles Read Property Multiple requests. */
 
+/* tags, errors and small property values; values too large for it are
+   read straight into the segmentation buffer */
 static uint8_t Temp_Buf[MAX_APDU] = { 0 };
 
 static BACNET_PROPERTY_ID RPM_Object_Property(
@@ -105,13 +108,15 @@ static unsigned RPM_Object_Property_Count(
    or 0 if there is no room to fit the encoding.  */
 static int RPM_Encode_Property(
     uint8_t * apdu,
-    uint16_t offset,
-    uint16_t max_apdu,
+    size_t offset,
+    size_t max_apdu,
     BACNET_RPM_DATA * rpmdata)
 {
     int len = 0;
     size_t copy_len = 0;
     int apdu_len = 0;
+    size_t room = 0;
+    bool in_place = false;
     BACNET_READ_PROPERTY_DATA rpdata;
 
     len =
@@ -130,8 +135,19 @@ static int RPM_Encode_Property(
     rpdata.object_instance = rpmdata->object_instance;
     rpdata.object_property = rpmdata->object_property;
     rpdata.array_index = rpmdata->array_index;
-    rpdata.application_data = &Temp_Buf[0];
-    rpdata.application_data_len = sizeof(Temp_Buf);
+    /* room left for the value between its opening and closing tags */
+    if ((offset + apdu_len + 2) < max_apdu) {
+        room = max_apdu - (offset + apdu_len + 2);
+    }
+    if (room >= sizeof(Temp_Buf)) {
+        /* encode behind the opening tag to avoid a second full-size copy */
+        in_place = true;
+        rpdata.application_data = &apdu[offset + apdu_len + 1];
+        rpdata.application_data_len = room;
+    } else {
+        rpdata.application_data = &Temp_Buf[0];
+        rpdata.application_data_len = sizeof(Temp_Buf);
+    }
     len = Device_Read_Property(&rpdata);
     if (len < 0) {
         if ((len == BACNET_STATUS_ABORT) || (len == BACNET_STATUS_REJECT)) {
@@ -150,7 +166,12 @@ static int RPM_Encode_Property(
             rpmdata->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
             return BACNET_STATUS_ABORT;
         }
-    } else if ((offset + apdu_len + 1 + len + 1) < max_apdu) {
+    } else if (in_place && ((size_t) len <= room)) {
+        /* the value is already in place - wrap it in its tags */
+        encode_opening_tag(&apdu[offset + apdu_len], 4);
+        encode_closing_tag(&apdu[offset + apdu_len + 1 + len], 4);
+        len += 2;
+    } else if (!in_place && ((offset + apdu_len + 1 + len + 1) < max_apdu)) {
         /* enough room to fit the property value and tags */
         len =
             rpm_ack_encode_apdu_object_property_value(&apdu[offset + apdu_len],
@@ -165,6 +186,71 @@ static int RPM_Encode_Property(
     return apdu_len;
 }
 
+/** Walk the whole request once and queue every (object, property) it
+   reads, so batch read hooks get all of them in a single call before
+   the reply is encoded.  Decoding errors are left for the main loop. */
+static void RPM_Batch_Read_Prefetch(
+    uint8_t * service_request,
+    uint16_t service_len)
+{
+    int len = 0;
+    uint16_t decode_len = 0;
+    BACNET_RPM_DATA rpmdata;
+    struct special_property_list_t property_list;
+    unsigned property_count = 0;
+    unsigned index = 0;
+
+    while (decode_len < service_len) {
+        len =
+            rpm_decode_object_id(&service_request[decode_len],
+            service_len - decode_len, &rpmdata);
+        if (len < 0) {
+            return;
+        }
+        decode_len += len;
+        if ((rpmdata.object_type == OBJECT_DEVICE) &&
+            (rpmdata.object_instance == BACNET_MAX_INSTANCE)) {
+            rpmdata.object_instance = Device_Object_Instance_Number();
+        }
+        for (;;) {
+            len =
+                rpm_decode_object_property(&service_request[decode_len],
+                service_len - decode_len, &rpmdata);
+            if (len < 0) {
+                return;
+            }
+            decode_len += len;
+            if (rpmdata.array_index != BACNET_ARRAY_ALL) {
+                /* array elements are read through the property callbacks */
+            } else if ((rpmdata.object_property == PROP_ALL) ||
+                (rpmdata.object_property == PROP_REQUIRED) ||
+                (rpmdata.object_property == PROP_OPTIONAL)) {
+                Device_Object_Property_List(rpmdata.object_type,
+                    rpmdata.object_instance, &property_list);
+                property_count =
+                    RPM_Object_Property_Count(&property_list,
+                    rpmdata.object_property);
+                for (index = 0; index < property_count; index++) {
+                    Device_Batch_Read_Queue(rpmdata.object_type,
+                        rpmdata.object_instance,
+                        RPM_Object_Property(&property_list,
+                            rpmdata.object_property, index));
+                }
+            } else {
+                Device_Batch_Read_Queue(rpmdata.object_type,
+                    rpmdata.object_instance, rpmdata.object_property);
+            }
+            if (decode_len >= service_len) {
+                return;
+            }
+            if (decode_is_closing_tag_number(&service_request[decode_len], 1)) {
+                decode_len++;
+                break;
+            }
+        }
+    }
+}
+
 /** Handler for a ReadPropertyMultiple Service request.
  * @ingroup DSRPM
  * This handler will be invoked by apdu_handler() if it has been enabled
@@ -191,7 +277,7 @@ void handler_read_property_multiple(
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     int len = 0;
-    uint16_t copy_len = 0;
+    size_t copy_len = 0;
     uint16_t decode_len = 0;
     int pdu_len = 0;
     BACNET_NPDU_DATA npdu_data;
@@ -201,6 +287,8 @@ void handler_read_property_multiple(
     int apdu_len = 0;
     int npdu_len = 0;
     int error = 0;
+    uint8_t *apdu = NULL;
+    int max_apdu = 0;
 
     /* jps_debug - see if we are utilizing all the buffer */
     /* memset(&Handler_Transmit_Buffer[0], 0xff, sizeof(Handler_Transmit_Buffer)); */
@@ -218,11 +306,18 @@ void handler_read_property_multiple(
 #endif
         goto RPM_FAILURE;
     }
+    /* let the batch read hooks fetch everything this request reads */
+    if (Device_Batch_Read_Enabled()) {
+        RPM_Batch_Read_Prefetch(service_request, service_len);
+        Device_Batch_Read_Flush();
+    }
+    /* the reply is encoded unsegmented, and split into segments
+       when it doesn't fit the requester's max APDU */
+    apdu = segmentation_buffer();
+    max_apdu = (int) segmentation_max_apdu(service_data);
     /* decode apdu request & encode apdu reply
        encode complex ack, invoke id, service choice */
-    apdu_len =
-        rpm_ack_encode_apdu_init(&Handler_Transmit_Buffer[npdu_len],
-        service_data->invoke_id);
+    apdu_len = rpm_ack_encode_apdu_init(&apdu[0], service_data->invoke_id);
     for (;;) {
         /* Start by looking for an object ID */
         len =
@@ -249,8 +344,8 @@ void handler_read_property_multiple(
         /* Stick this object id into the reply - if it will fit */
         len = rpm_ack_encode_apdu_object_begin(&Temp_Buf[0], &rpmdata);
         copy_len =
-            memcopy(&Handler_Transmit_Buffer[npdu_len], &Temp_Buf[0], apdu_len,
-            len, MAX_APDU);
+            memcopy(&apdu[0], &Temp_Buf[0], apdu_len,
+            len, max_apdu);
         if (copy_len == 0) {
 #if PRINT_ENABLED
             fprintf(stderr, "RPM: Response too big!\r\n");
@@ -292,8 +387,8 @@ void handler_read_property_multiple(
                         rpm_ack_encode_apdu_object_property(&Temp_Buf[0],
                         rpmdata.object_property, rpmdata.array_index);
                     copy_len =
-                        memcopy(&Handler_Transmit_Buffer[npdu_len],
-                        &Temp_Buf[0], apdu_len, len, MAX_APDU);
+                        memcopy(&apdu[0],
+                        &Temp_Buf[0], apdu_len, len, max_apdu);
                     if (copy_len == 0) {
 #if PRINT_ENABLED
                         fprintf(stderr,
@@ -310,8 +405,8 @@ void handler_read_property_multiple(
                         ERROR_CLASS_PROPERTY,
                         ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY);
                     copy_len =
-                        memcopy(&Handler_Transmit_Buffer[npdu_len],
-                        &Temp_Buf[0], apdu_len, len, MAX_APDU);
+                        memcopy(&apdu[0],
+                        &Temp_Buf[0], apdu_len, len, max_apdu);
                     if (copy_len == 0) {
 #if PRINT_ENABLED
                         fprintf(stderr, "RPM: Too full to encode error!\r\n");
@@ -324,8 +419,8 @@ void handler_read_property_multiple(
                     apdu_len += len;
                 } else {
                     special_object_property = rpmdata.object_property;
-                    Device_Objects_Property_List(rpmdata.object_type,
-                        &property_list);
+                    Device_Object_Property_List(rpmdata.object_type,
+                        rpmdata.object_instance, &property_list);
                     property_count =
                         RPM_Object_Property_Count(&property_list,
                         special_object_property);
@@ -342,8 +437,8 @@ void handler_read_property_multiple(
                                 RPM_Object_Property(&property_list,
                                 special_object_property, index);
                             len =
-                                RPM_Encode_Property(&Handler_Transmit_Buffer
-                                [npdu_len], (uint16_t) apdu_len, MAX_APDU,
+                                RPM_Encode_Property(&apdu[0],
+                                (size_t) apdu_len, (size_t) max_apdu,
                                 &rpmdata);
                             if (len > 0) {
                                 apdu_len += len;
@@ -361,8 +456,8 @@ void handler_read_property_multiple(
             } else {
                 /* handle an individual property */
                 len =
-                    RPM_Encode_Property(&Handler_Transmit_Buffer[npdu_len],
-                    (uint16_t) apdu_len, MAX_APDU, &rpmdata);
+                    RPM_Encode_Property(&apdu[0],
+                    (size_t) apdu_len, (size_t) max_apdu, &rpmdata);
                 if (len > 0) {
                     apdu_len += len;
                 } else {
@@ -379,8 +474,8 @@ void handler_read_property_multiple(
                 decode_len++;
                 len = rpm_ack_encode_apdu_object_end(&Temp_Buf[0]);
                 copy_len =
-                    memcopy(&Handler_Transmit_Buffer[npdu_len], &Temp_Buf[0],
-                    apdu_len, len, MAX_APDU);
+                    memcopy(&apdu[0], &Temp_Buf[0],
+                    apdu_len, len, max_apdu);
                 if (copy_len == 0) {
 #if PRINT_ENABLED
                     fprintf(stderr, "RPM: Too full to encode object end!\r\n");
@@ -401,7 +496,7 @@ void handler_read_property_multiple(
         }
     }
 
-    if (apdu_len > service_data->max_resp) {
+    if (apdu_len > max_apdu) {
         /* too big for the sender - send an abort */
         rpmdata.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
         error = BACNET_STATUS_ABORT;
@@ -414,6 +509,9 @@ void handler_read_property_multiple(
   RPM_FAILURE:
     if (error) {
         if (error == BACNET_STATUS_ABORT) {
+            rpmdata.error_code =
+                segmentation_abort_error_code(service_data,
+                rpmdata.error_code);
             apdu_len =
                 abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
                 service_data->invoke_id,
@@ -440,6 +538,13 @@ void handler_read_property_multiple(
         }
     }
 
+    Device_Batch_Read_Clear();
+
+    if (!error) {
+        segmentation_send_complex_ack(src, service_data, &apdu[0], apdu_len);
+        return;
+    }
+
     pdu_len = apdu_len + npdu_len;
     bytes_sent =
         datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
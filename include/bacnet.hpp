@@ -2,8 +2,11 @@
 #define BACNET_HPP
 
 #include "callbacks.hpp"
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace bacnet {
@@ -16,6 +19,20 @@ namespace bacnet {
 
     bool isDateWildcard(const BACNET_DATE *date);
 
+    struct ExecuteResult {
+        unsigned handled;   // PDUs received and dispatched
+        bool pending;       // datagrams were still queued when the budget ran out
+    };
+
+    struct DatalinkStatistics {
+        uint64_t rx_calls;      // recvmmsg() calls that returned datagrams
+        uint64_t rx_packets;    // datagrams received through them
+        unsigned rx_max_batch;  // most datagrams received by one call
+        uint64_t tx_calls;      // sendmmsg() calls
+        uint64_t tx_packets;    // datagrams sent through them
+        unsigned tx_max_batch;  // most datagrams sent by one call
+    };
+
     class BACnet {
     public:
         BACnet(const std::string &vendor_name,
@@ -120,19 +137,127 @@ namespace bacnet {
 #endif
                                         const std::string &description = "Notification Class Object");
 
+        /**
+         * Add many objects at once, e.g. at startup with tens of thousands of points. Storage and
+         * indexes are sized for all of them up front instead of growing with every object.
+         * Notification classes must be added with addNotificationClassObject().
+         *
+         * @param specs Objects to add, they get consecutive instance numbers in this order
+         * @return true if all objects were added, false on the first one that could not be added
+         */
+        bool addObjects(const std::vector<ObjectSpec> &specs);
+
+        /**
+         * Add count objects of one type that differ only by instance, e.g. thousands of identical
+         * analog inputs. A single object with one set of callbacks serves all of them, the callbacks
+         * get the instance being accessed. Each instance is listed and accessed like an ordinary
+         * object, but has no intrinsic reporting and no present value store, so the read present
+         * value callback is required. Notification classes can't be added as a range. The instances
+         * are found by name, e.g. by Who-Has, only if spec.find_object_name is set.
+         *
+         * @param spec The objects to add
+         * @param count Number of instances
+         * @param first_instance Set to the first of the consecutive instances of the range
+         * @return true if the range was added, false e.g. if its instances would exceed BACNET_MAX_INSTANCE
+         */
+        bool addObjectRange(const ObjectSpec &spec, unsigned count, uint32_t *first_instance = nullptr);
+
+        /**
+         * Restore the notification class recipient lists saved before the last restart. The saved
+         * file is read once, notification classes added afterwards pick up their recipients from it.
+         * Called by initialize() if the application hasn't called it before, typically right after
+         * all objects have been added.
+         */
+        void loadPersistentState();
+
         void initialize();
 
         void deinitialize();
 
         void execute();
 
+        /**
+         * Receive and dispatch packets until the socket is empty or the budget runs out,
+         * running the timers whenever a second boundary is crossed.
+         *
+         * @param max_packets Maximum number of packets to handle in this call, and of datagrams
+         *                    without a PDU (BVLC control messages, our own broadcasts) to consume
+         * @param max_milliseconds Maximum time to spend receiving in this call
+         * @return Number of packets handled and whether more are still queued
+         */
+        ExecuteResult execute(unsigned max_packets, unsigned max_milliseconds);
+
+        /**
+         * Run the stack on a dedicated service thread instead of polling execute().
+         * The thread sleeps in epoll until a packet arrives or the next timer deadline is due.
+         * Must be called after initialize(). While the service thread is running all object
+         * callbacks are invoked from it and execute() must not be called.
+         *
+         * @return true if the service thread was started
+         */
+        bool start();
+
+        /**
+         * Stop the service thread started by start() and wait for it to exit.
+         */
+        void stop();
+
+        /**
+         * Get the receive and send batch sizes of the B/IP datalink since startup.
+         * Average batch size is packets / calls.
+         */
+        DatalinkStatistics getDatalinkStatistics();
+
         unsigned getDatabaseRevision();
 
         void incDatabaseRevision();
 
         std::shared_ptr<BACnetObject> getDeviceObject();
 
+        /**
+         * Notify the stack that the name reported by an object's name callback has changed,
+         * so Who-Has and name uniqueness checks see the new name.
+         */
+        void objectNameChanged(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+
+        /**
+         * Notify the stack that properties fixed at registration, like units or description, have
+         * changed. Their encodings are cached after the first read and rebuilt after this call.
+         */
+        void staticPropertiesChanged(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+
+        /**
+         * Register a hook that receives every (instance, property) of the given object type that a
+         * ReadPropertyMultiple request reads, before the reply is encoded. Values it marks as found
+         * are used instead of the per-property callbacks. Pass nullptr to remove the hook.
+         */
+        void setBatchReadHandler(BACNET_OBJECT_TYPE object_type, object_batch_read_cb batch_read_cb);
+
+        /**
+         * Push a new present value for an object that was added without a read present value
+         * callback. ReadProperty is then served from the stored value without calling back into
+         * the application. Safe to call from any thread once all objects have been added.
+         *
+         * @return false if the object does not exist, does not use the value store or has a
+         *         present value of a different type
+         */
+        bool updatePresentValue(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, float value);
+
+        bool updatePresentValue(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, unsigned value);
+
+        bool updatePresentValue(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, const BACNET_TIME &value);
+
+        bool updatePresentValue(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, const BACNET_DATE &value);
+
     private:
+        void processTimers();
+
+        uint32_t secondsUntilNextDeadline();
+
+        void serviceLoop();
+
+        unsigned receivePackets(unsigned max_packets, unsigned max_milliseconds, bool *pending);
+
         std::string vendor_name;
         uint16_t vendor_identifier;
         std::string model_name;
@@ -150,6 +275,15 @@ namespace bacnet {
         long _bbmd_addr;
         long _bbmd_port;
         long _bbmd_ttl;
+
+        std::thread service_thread;
+        std::atomic<bool> service_running;
+        int epoll_fd;
+        int timer_fd;
+        int wakeup_fd;
+
+        // Allocated once and never cleared, datalink_receive() copies only the bytes it returns into it
+        std::unique_ptr<uint8_t[]> receive_buffer;
     };
 
 } // namespace bacnet
@@ -0,0 +1,94 @@
+#ifndef BACNET_BIP_BATCH_H
+#define BACNET_BIP_BATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <netinet/in.h>
+#include <sys/uio.h>
+
+/* max datagrams read by a single recvmmsg() */
+#ifndef BIP_RX_BATCH_SIZE
+#define BIP_RX_BATCH_SIZE 16
+#endif
+
+/* max datagrams queued for a single sendmmsg() */
+#ifndef BIP_TX_BATCH_SIZE
+#define BIP_TX_BATCH_SIZE 16
+#endif
+
+typedef struct BIP_Batch_Stats {
+    uint64_t rx_calls;     /* recvmmsg() calls that returned data */
+    uint64_t rx_packets;   /* datagrams received through them */
+    unsigned rx_max_batch; /* largest number of datagrams received at once */
+    uint64_t tx_calls;     /* sendmmsg() calls */
+    uint64_t tx_packets;   /* datagrams sent through them */
+    unsigned tx_max_batch; /* largest number of datagrams sent at once */
+} BIP_BATCH_STATS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Get the next datagram from the B/IP socket. Datagrams are read in
+ * batches with recvmmsg() and handed out one at a time, in order.
+ *
+ * @param sin [out] Source address of the datagram
+ * @param mtu [out] Points to the datagram, valid until the next call
+ * @param timeout Milliseconds to wait when no datagram is queued
+ * @return Number of bytes in the datagram, 0 on timeout, negative on error
+ */
+int bip_receive_mpdu(struct sockaddr_in* sin, uint8_t** mtu, unsigned timeout);
+
+/**
+ * Get the number of datagrams already read from the socket that were
+ * not handed out yet.
+ */
+unsigned bip_receive_queued(void);
+
+/**
+ * Send a datagram out the B/IP socket, or queue it when a transmit
+ * batch is open.
+ *
+ * @param dest Destination address in network byte order
+ * @param mtu Bytes to send
+ * @param mtu_len Number of bytes to send
+ * @return Number of bytes sent or queued, negative on error
+ */
+int bip_send_mpdu(struct sockaddr_in* dest, uint8_t* mtu, uint16_t mtu_len);
+
+/**
+ * Send a datagram gathered from several buffers, e.g. a BVLC header and
+ * the NPDU behind it, without copying them together first. When a
+ * transmit batch is open the buffers are copied into a batch slot.
+ *
+ * @param dest Destination address in network byte order
+ * @param iov Buffers to send, in order
+ * @param iov_count Number of buffers
+ * @return Number of bytes sent or queued, negative on error
+ */
+int bip_send_mpdu_iov(struct sockaddr_in* dest, const struct iovec* iov, unsigned iov_count);
+
+/**
+ * Start queueing outgoing datagrams instead of sending them one by one.
+ * Batches nest, the datagrams go out when the outermost batch ends.
+ */
+void bip_send_batch_begin(void);
+
+/**
+ * End a batch. Ending the outermost batch sends all queued datagrams with
+ * sendmmsg() and stops queueing.
+ */
+void bip_send_batch_end(void);
+
+/**
+ * Get the receive and send batch statistics.
+ */
+void bip_batch_stats(BIP_BATCH_STATS* stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BACNET_BIP_BATCH_H */
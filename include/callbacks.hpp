@@ -6,12 +6,19 @@
 #include "get_alarm_sum.h"
 #include "getevent.h"
 #endif
+#include <bacnet/bacapp.h>
 #include <bacnet/bacenum.h>
 #include <bacnet/bacstr.h>
 #include <bacnet/datetime.h>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 /* max "length" of recipient_list */
@@ -32,6 +39,8 @@ enum CustomErrorStatusCode : unsigned;
 
 typedef std::function<int(unsigned object_instance, char* object_name)> read_object_name_cb;
 typedef std::function<int(unsigned object_instance, const char* object_name)> write_object_name_cb;
+// the instance of an object range that has the name, see ObjectSpec::find_object_name
+typedef std::function<int(const char* object_name, unsigned* object_instance)> find_object_name_cb;
 
 typedef std::function<unsigned()> read_object_identifier_cb;
 typedef std::function<int(unsigned object_identifier)> write_object_identifier_cb;
@@ -154,88 +163,166 @@ typedef std::function<int(unsigned object_instance, uint8_t last_offnormal_event
 typedef std::function<int(unsigned object_instance, ACK_NOTIFICATION& ack_notify_data)> read_ack_notify_data_cb;
 typedef std::function<int(unsigned object_instance, const ACK_NOTIFICATION& ack_notify_data)> write_ack_notify_data_cb;
 
+// Blocks holding the std::function of a SparseCallback, taken from a pool shared by all objects
+void* allocateCallbackBlock(size_t size);
+void releaseCallbackBlock(void* block, size_t size);
+
+// Optional callback that takes a single pointer while it is unset. Most callbacks of an object are never set,
+// so they cost a null pointer instead of a whole std::function each. The std::function of a set callback lives
+// in a pooled block, a target too large for its small buffer, such as a lambda capturing a string, is still
+// allocated by std::function itself.
+template <typename Function>
+class SparseCallback {
+  public:
+    SparseCallback() = default;
+    SparseCallback(const SparseCallback& other)
+        : function(other.function ? make(Function(*other.function)) : nullptr) {}
+    SparseCallback(SparseCallback&&) noexcept = default;
+
+    SparseCallback& operator=(const SparseCallback& other) {
+        function.reset(other.function ? make(Function(*other.function)) : nullptr);
+        return *this;
+    }
+    SparseCallback& operator=(SparseCallback&&) noexcept = default;
+
+    // Assigning an empty callback unsets it
+    template <typename F,
+        typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, SparseCallback>::value>::type>
+    SparseCallback& operator=(F&& f) {
+        Function callback(std::forward<F>(f));
+        function.reset(callback ? make(std::move(callback)) : nullptr);
+        return *this;
+    }
+
+    explicit operator bool() const { return (bool)function; }
+
+    template <typename... Args>
+    typename Function::result_type operator()(Args&&... args) const {
+        if (!function)
+            throw std::bad_function_call();
+        return (*function)(std::forward<Args>(args)...);
+    }
+
+  private:
+    struct Release {
+        void operator()(Function* function) const {
+            function->~Function();
+            releaseCallbackBlock(function, sizeof(Function));
+        }
+    };
+
+    static Function* make(Function&& callback) {
+        void* block = allocateCallbackBlock(sizeof(Function));
+        return new (block) Function(std::move(callback));
+    }
+
+    std::unique_ptr<Function, Release> function;
+};
+
 struct ReadProperty {
+    SparseCallback<read_object_name_cb> object_name;
+    SparseCallback<read_object_identifier_cb> object_identifier;
+    SparseCallback<read_present_value_real_cb> present_value_real;
+    SparseCallback<read_present_value_unsigned_cb> present_value_unsigned;
+    SparseCallback<read_present_value_characterstring_cb> present_value_characterstring;
+    SparseCallback<read_present_value_time_cb> present_value_time;
+    SparseCallback<read_present_value_date_cb> present_value_date;
+    SparseCallback<read_present_value_bitstring_cb> present_value_bitstring;
+    SparseCallback<read_number_of_bits_cb> number_of_bits;
+    SparseCallback<read_max_pres_value_cb> max_pres_value;
+    SparseCallback<read_min_pres_value_cb> min_pres_value;
+    SparseCallback<read_resolution_cb> resolution;
+    SparseCallback<read_units_cb> units;
+    SparseCallback<read_number_of_states_cb> number_of_states;
+    SparseCallback<read_state_text_cb> state_text;
+    SparseCallback<read_bit_text_cb> bit_text;
+    SparseCallback<read_out_of_service_cb> out_of_service;
+    SparseCallback<read_description_cb> description;
+    SparseCallback<read_device_type_cb> device_type;
+    SparseCallback<read_application_version_cb> application_version;
+    SparseCallback<read_firmware_version_cb> firmware_revision;
+    SparseCallback<read_location_cb> location;
+    SparseCallback<read_local_time_cb> local_time;
+    SparseCallback<read_local_date_cb> local_date;
+    SparseCallback<read_vendor_name_cb> vendor_name;
+    SparseCallback<read_model_name_cb> model_name;
+    SparseCallback<read_vendor_identifier_cb> vendor_identifier;
+    SparseCallback<read_database_revision_cb> database_revision;
+
+    // analog input intrinsic, the application decides in certified builds
+    SparseCallback<read_event_detection_enable_cb> event_detection_enable;
+
+    // object ranges, resolves Who-Has and the Object_Name duplicate check
+    SparseCallback<find_object_name_cb> find_object_name;
+};
+
+struct WriteProperty {
+    SparseCallback<write_object_name_cb> object_name;
+    SparseCallback<write_object_identifier_cb> object_identifier;
+    SparseCallback<write_present_value_real_cb> present_value_real;
+    SparseCallback<write_present_value_unsigned_cb> present_value_unsigned;
+    SparseCallback<write_present_value_characterstring_cb> present_value_characterstring;
+    SparseCallback<write_present_value_time_cb> present_value_time;
+    SparseCallback<write_present_value_date_cb> present_value_date;
+    SparseCallback<write_present_value_bitstring_cb> present_value_bitstring;
+};
+
+// One property value a ReadPropertyMultiple request needs, see object_batch_read_cb
+struct BatchReadItem {
+    uint32_t object_instance;
+    BACNET_PROPERTY_ID object_property;
+    BACNET_APPLICATION_DATA_VALUE value; // filled in by the application
+    bool found;                          // set when value was filled in, otherwise the property callback is used
+};
+
+// Reads all properties of one object type that a ReadPropertyMultiple request asks for in a single call
+typedef std::function<void(std::vector<BatchReadItem>& items)> object_batch_read_cb;
+
+// One object to add with BACnet::addObjects(). Only the members used by the object type need to be set,
+// an empty description selects the default description of the type.
+struct ObjectSpec {
+    BACNET_OBJECT_TYPE type;
     read_object_name_cb object_name;
-    read_object_identifier_cb object_identifier;
-    read_present_value_real_cb present_value_real;
-    read_present_value_unsigned_cb present_value_unsigned;
-    read_present_value_characterstring_cb present_value_characterstring;
-    read_present_value_time_cb present_value_time;
-    read_present_value_date_cb present_value_date;
-    read_present_value_bitstring_cb present_value_bitstring;
-    read_number_of_bits_cb number_of_bits;
-    read_max_pres_value_cb max_pres_value;
-    read_min_pres_value_cb min_pres_value;
-    read_resolution_cb resolution;
-    read_units_cb units;
+    // object ranges only: the instance that has a name, false if no instance of the range has it. Without
+    // it the instances of a range can't be found by name.
+    find_object_name_cb find_object_name;
+    std::string description;
+
+    // analog input and analog value
+    read_present_value_real_cb read_present_value_real;
+    write_present_value_real_cb write_present_value_real; // analog value only
+    BACNET_ENGINEERING_UNITS units = UNITS_NO_UNITS;
+    float max_value = 10000.0f;
+    float min_value = -10000.0f;
+    float resolution = 0.1f;
+    // analog input only
+    std::string device_type = "Sensor";
+#if defined(CERTIFICATION_SOFTWARE)
+    read_event_detection_enable_cb event_detection_enable_cb;
+#else
+    bool event_detection_enable = false;
+    unsigned notification_class_instance = BACNET_MAX_INSTANCE;
+#endif
+
+    // multi-state input and multi-state value
+    read_present_value_unsigned_cb read_present_value_unsigned;
+    write_present_value_unsigned_cb write_present_value_unsigned; // multi-state value only
     read_number_of_states_cb number_of_states;
     read_state_text_cb state_text;
-    read_bit_text_cb bit_text;
-    read_out_of_service_cb out_of_service;
-    read_event_state_cb event_state;
-    read_description_cb description;
-    read_device_type_cb device_type;
-    read_application_version_cb application_version;
-    read_firmware_version_cb firmware_revision;
-    read_location_cb location;
-    read_local_time_cb local_time;
-    read_local_date_cb local_date;
-    read_vendor_name_cb vendor_name;
-    read_model_name_cb model_name;
-    read_vendor_identifier_cb vendor_identifier;
-    read_database_revision_cb database_revision;
-
-    // notification class
-    read_priority_cb priority;
-    read_ack_required_cb ack_required;
-    read_recipient_list_cb recipient_list;
-    // analog input intrinsic
-    read_event_detection_enable_cb event_detection_enable;
-    read_time_delay_cb time_delay;
-    read_notification_class_cb notification_class;
-    read_high_limit_cb high_limit;
-    read_low_limit_cb low_limit;
-    read_deadband_cb deadband;
-    read_limit_enable_cb limit_enable;
-    read_event_enable_cb event_enable;
-    read_acked_transitions_cb acked_transitions;
-    read_notify_type_cb notify_type;
-    read_event_time_stamps_cb event_time_stamps;
-    read_remaining_time_delay_cb remaining_time_delay;
-    read_ack_notify_data_cb ack_notify_data;
-    read_last_offnormal_event_state_cb last_offnormal_event_state;
-};
 
-struct WriteProperty {
-    write_object_name_cb object_name;
-    write_object_identifier_cb object_identifier;
-    write_present_value_real_cb present_value_real;
-    write_present_value_unsigned_cb present_value_unsigned;
-    write_present_value_characterstring_cb present_value_characterstring;
-    write_present_value_time_cb present_value_time;
-    write_present_value_date_cb present_value_date;
-    write_present_value_bitstring_cb present_value_bitstring;
-
-    // notification class
-    write_priority_cb priority;
-    write_ack_required_cb ack_required;
-    write_recipient_list_cb recipient_list;
-    // analog input intrinsic
-    write_event_detection_enable_cb event_detection_enable;
-    write_time_delay_cb time_delay;
-    write_remaining_time_delay_cb remaining_time_delay;
-    write_notification_class_cb notification_class;
-    write_high_limit_cb high_limit;
-    write_low_limit_cb low_limit;
-    write_deadband_cb deadband;
-    write_limit_enable_cb limit_enable;
-    write_event_enable_cb event_enable;
-    write_notify_type_cb notify_type;
-    write_event_state_cb event_state;
-    write_acked_transitions_cb acked_transitions;
-    write_ack_notify_data_cb ack_notify_data;
-    write_event_time_stamps_cb event_time_stamps;
-    write_last_offnormal_event_state_cb last_offnormal_event_state;
+    read_present_value_characterstring_cb read_present_value_characterstring;
+    write_present_value_characterstring_cb write_present_value_characterstring;
+
+    read_present_value_time_cb read_present_value_time;
+    write_present_value_time_cb write_present_value_time;
+
+    read_present_value_date_cb read_present_value_date;
+    write_present_value_date_cb write_present_value_date;
+
+    read_present_value_bitstring_cb read_present_value_bitstring;
+    write_present_value_bitstring_cb write_present_value_bitstring;
+    read_number_of_bits_cb number_of_bits;
+    read_bit_text_cb bit_text;
 };
 
 struct BACnetObject;
@@ -246,10 +333,10 @@ typedef std::function<unsigned(const BACnetObject&, BACNET_READ_PROPERTY_DATA*)>
 typedef std::function<bool(BACnetObject&, BACNET_WRITE_PROPERTY_DATA*)> object_write_property_cb;
 typedef std::function<void(const int** pRequired, const int** pOptional, const int** pProprietary)>
     object_rpm_property_list_cb;
-// typedef std::function<bool(const BACnetObject&, BACNET_PROPERTY_VALUE* value_list)> object_value_list_cb;
-// typedef std::function<bool(const BACnetObject&)> object_cov_cb;
-// typedef std::function<void(const BACnetObject&)> object_cov_clear_cb;
-typedef std::function<void(const BACnetObject&)> object_intrinsic_reporting_cb;
+// Fills in Present_Value and Status_Flags of a COV notification, see encode_cov_value_list()
+typedef std::function<bool(const BACnetObject&, uint32_t object_instance, BACNET_PROPERTY_VALUE* value_list)>
+    object_value_list_cb;
+typedef std::function<void(BACnetObject&)> object_intrinsic_reporting_cb;
 
 struct ObjectTypeHandler {
     object_init_cb init;
@@ -257,9 +344,9 @@ struct ObjectTypeHandler {
     object_read_property_cb read_property;
     object_write_property_cb write_property;
     object_rpm_property_list_cb rpm_property_list;
-    // object_cov_cb cov;
-    // object_cov_clear_cb cov_clear;
-    // object_value_list_cb value_list;
+    // property lists of the instances of an object range, when they have fewer properties
+    object_rpm_property_list_cb rpm_range_property_list;
+    object_value_list_cb value_list;
     object_intrinsic_reporting_cb intrinsic_reporting;
 };
 
@@ -285,18 +372,91 @@ struct AiIntrinsicReportingParams {
     uint8_t event_state;
     uint8_t last_offnormal_event_state;
     std::unique_ptr<ACK_NOTIFICATION> ack_notify_data;
+    // set by a reporting pass that changed nothing, the next passes are skipped until
+    // PresentValueStore::changes moves or a property is written
+    bool settled = false;
+    uint32_t settled_changes = 0;
+};
+
+// Present value pushed by the application with BACnet::updatePresentValue(). Used instead of the read
+// present value callback by objects that were added without one, so reads never call into the application.
+struct PresentValueStore {
+    bool enabled = false;
+    std::atomic<uint64_t> value{0};   // bits of a float, unsigned, BACNET_TIME or BACNET_DATE
+    // incremented whenever a stored value differs from the previous one, and when the event state of the
+    // object changes. COV and intrinsic reporting don't look at an object again while it stands still.
+    std::atomic<uint32_t> changes{0};
+
+    template <typename T>
+    T load() const {
+        static_assert(sizeof(T) <= sizeof(uint64_t), "present value does not fit the store");
+        uint64_t bits = value.load(std::memory_order_acquire);
+        T present_value;
+        memcpy(&present_value, &bits, sizeof(T));
+        return present_value;
+    }
+
+    template <typename T>
+    bool store(const T& present_value) {
+        static_assert(sizeof(T) <= sizeof(uint64_t), "present value does not fit the store");
+        uint64_t bits = 0;
+        memcpy(&bits, &present_value, sizeof(T));
+        if (value.exchange(bits, std::memory_order_acq_rel) == bits)
+            return false;
+        changes.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Encodings of properties that don't change after the object is added, copied straight into the APDU on
+// every later read. Filled on first read and dropped when the application signals a change.
+struct EncodedPropertyCache {
+    struct Entry {
+        BACNET_PROPERTY_ID property;
+        uint16_t offset;
+        uint16_t length;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<uint8_t> arena; // all encodings back to back
+    std::atomic<bool> stale{false};
+};
+
+// Change of value state of an object. A REAL present value is notified once it moved by at least the
+// increment, any other change is notified right away.
+struct CovState {
+    // COV_Increment of the object, the instances of a range use the one of the range object
+    float increment = 0.0f;
+    // Present_Value and Status_Flags last notified, allocated when the object is first notified
+    std::unique_ptr<BACNET_APPLICATION_DATA_VALUE[]> reported;
+    // PresentValueStore::changes and the increment when the object was last found unchanged, see
+    // Container::deviceCov()
+    bool unchanged = false;
+    uint32_t unchanged_changes = 0;
+    float unchanged_increment = 0.0f;
 };
 
 struct BACnetObject {
     BACNET_OBJECT_TYPE type;
     uint32_t instance;
+    // An object range stands for range_count consecutive instances starting at range_first, see
+    // Container::addObjectRange(). instance stays range_first, the instance being accessed is passed
+    // to the handlers and callbacks.
+    uint32_t range_first;
+    uint32_t range_count; // 0 for an ordinary object
 
     ReadProperty read;
     WriteProperty write;
-    ObjectTypeHandler handler;
+    // shared by all objects of the type, owned by the container
+    const ObjectTypeHandler* handler = nullptr;
+
+    // intrinsic reporting state, allocated for notification class and analog input objects only
+    std::unique_ptr<NcIntrinsicReportingParams> nc_irp;
+    std::unique_ptr<AiIntrinsicReportingParams> ai_irp;
 
-    NcIntrinsicReportingParams nc_irp;
-    AiIntrinsicReportingParams ai_irp;
+    PresentValueStore present_value;
+    EncodedPropertyCache encoded_properties;
+    CovState cov;
 
     std::vector<std::shared_ptr<BACnetObject>> objects;
 };
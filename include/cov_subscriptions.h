@@ -0,0 +1,274 @@
+#ifndef BACNET_COV_SUBSCRIPTIONS_H
+#define BACNET_COV_SUBSCRIPTIONS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "apdu.h"
+#include "bacdef.h"
+#include "bacenum.h"
+
+/* upper bound on subscriptions from all subscribers together, each property
+   subscribed with SubscribeCOVPropertyMultiple counts as one */
+#ifndef MAX_COV_SUBSCRIPTIONS
+#define MAX_COV_SUBSCRIPTIONS 16384
+#endif
+
+/* monitoredProperty of a SubscribeCOV subscription, which notifies the
+   object's COV value list rather than a single property */
+#define COV_OBJECT_VALUE_LIST MAX_BACNET_PROPERTY_ID
+
+typedef struct BACnet_COV_Subscription {
+    BACNET_ADDRESS dest;
+    uint32_t subscriberProcessIdentifier;
+    BACNET_OBJECT_ID monitoredObjectIdentifier;
+    BACNET_PROPERTY_ID monitoredProperty; /* COV_OBJECT_VALUE_LIST for SubscribeCOV */
+    uint32_t propertyArrayIndex; /* BACNET_ARRAY_ALL if absent */
+    bool covIncrementPresent; /* SubscribeCOVProperty of a REAL property only */
+    float covIncrement;
+    bool issueConfirmedNotifications;
+    uint8_t invokeID; /* of the confirmed notification in progress, 0 if none */
+    uint32_t lifetime; /* requested lifetime in seconds, 0 is indefinite */
+    /* maintained by the subscription table */
+    bool send_requested;
+    unsigned index;
+    uint64_t expires;
+} BACNET_COV_SUBSCRIPTION;
+
+/* BACnet 2016 COV-Multiple services (Clause 13.15 to 13.17), stacks older than
+   protocol revision 18 do not enumerate them */
+#define COV_SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE 30
+#define COV_SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE 31
+#define COV_SERVICE_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE 11
+#define COV_SERVICE_SUPPORTED_SUBSCRIBE_COV_PROPERTY_MULTIPLE 41
+
+/* a property subscribed with SubscribeCOVPropertyMultiple */
+typedef struct BACnet_COV_Reference {
+    BACNET_OBJECT_ID monitoredObjectIdentifier;
+    BACNET_PROPERTY_ID monitoredProperty;
+    uint32_t propertyArrayIndex; /* BACNET_ARRAY_ALL if absent */
+    bool covIncrementPresent;
+    float covIncrement;
+    bool timestamped;
+} BACNET_COV_REFERENCE;
+
+/* the SubscribeCOVPropertyMultiple subscriptions of a subscriber process,
+   their changes are collected and notified together */
+typedef struct BACnet_COV_Multiple_Subscription {
+    BACNET_ADDRESS dest;
+    uint32_t subscriberProcessIdentifier;
+    bool issueConfirmedNotifications;
+    uint8_t invokeID; /* of the confirmed notification in progress, 0 if none */
+    uint32_t lifetime; /* requested lifetime in seconds, 0 is indefinite */
+    uint32_t maxNotificationDelay; /* seconds changes are collected before they are notified */
+    uint16_t max_apdu; /* largest APDU the subscriber accepts */
+    /* maintained by the subscription table */
+    unsigned index;
+    uint64_t expires;
+    uint64_t due; /* when the collected changes are notified, 0 if there are none */
+} BACNET_COV_MULTIPLE_SUBSCRIPTION;
+
+/* sends a notification for a subscription, returns true once it went out */
+typedef bool (*cov_notify_function)(BACNET_COV_SUBSCRIPTION* subscription);
+typedef bool (*cov_multiple_notify_function)(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription);
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Drop all subscriptions.
+ */
+void cov_subscriptions_init(void);
+
+/**
+ * Get the number of subscriptions.
+ */
+unsigned cov_subscription_count(void);
+
+/**
+ * Get a subscription by position, 0 to cov_subscription_count() - 1.
+ * Positions change when a subscription is removed.
+ */
+BACNET_COV_SUBSCRIPTION* cov_subscription_get(unsigned index);
+
+/**
+ * Find the subscription of a subscriber process to an object or one of its properties.
+ *
+ * @param dest Address of the subscriber
+ * @param process_identifier Subscriber process identifier
+ * @param object_id Monitored object
+ * @param property Monitored property, COV_OBJECT_VALUE_LIST for the object
+ * @param array_index Monitored array element, BACNET_ARRAY_ALL for all
+ * @return The subscription, or NULL if there is none
+ */
+BACNET_COV_SUBSCRIPTION* cov_subscription_find(BACNET_ADDRESS* dest,
+    uint32_t process_identifier,
+    const BACNET_OBJECT_ID* object_id,
+    BACNET_PROPERTY_ID property,
+    uint32_t array_index);
+
+/**
+ * Add a subscription with an indefinite lifetime.
+ *
+ * @return The subscription, or NULL if MAX_COV_SUBSCRIPTIONS is reached
+ */
+BACNET_COV_SUBSCRIPTION* cov_subscription_add(BACNET_ADDRESS* dest,
+    uint32_t process_identifier,
+    const BACNET_OBJECT_ID* object_id,
+    BACNET_PROPERTY_ID property,
+    uint32_t array_index);
+
+/**
+ * Remove a subscription, freeing the invoke ID of a confirmed notification in progress.
+ */
+void cov_subscription_remove(BACNET_COV_SUBSCRIPTION* subscription);
+
+/**
+ * Set the lifetime of a subscription, starting now.
+ *
+ * @param lifetime Seconds until the subscription expires, 0 for indefinite
+ */
+void cov_subscription_set_lifetime(BACNET_COV_SUBSCRIPTION* subscription, uint32_t lifetime);
+
+/**
+ * Get the seconds until a subscription expires, 0 for indefinite.
+ */
+uint32_t cov_subscription_time_remaining(const BACNET_COV_SUBSCRIPTION* subscription);
+
+/**
+ * Queue a notification for a subscription, e.g. the initial one after subscribing.
+ */
+void cov_subscription_request_send(BACNET_COV_SUBSCRIPTION* subscription);
+
+/**
+ * Record the value sent in a notification of a SubscribeCOVProperty subscription, later
+ * changes are measured against it.
+ *
+ * @param value Application encoded value of the monitored property
+ * @param value_len Length of the value
+ */
+void cov_subscription_notified(BACNET_COV_SUBSCRIPTION* subscription, const uint8_t* value, unsigned value_len);
+
+/**
+ * Remove subscriptions whose lifetime ran out.
+ *
+ * @param elapsed_seconds Time elapsed since the last call
+ */
+void cov_subscriptions_timer(uint32_t elapsed_seconds);
+
+/**
+ * Find the SubscribeCOVPropertyMultiple subscriptions of a subscriber process.
+ *
+ * @return The subscriptions, or NULL if there are none
+ */
+BACNET_COV_MULTIPLE_SUBSCRIPTION* cov_multiple_find(BACNET_ADDRESS* dest, uint32_t process_identifier);
+
+/**
+ * Add or update the subscriptions of a subscriber process to a list of properties.
+ * Properties not subscribed before are notified as soon as possible.
+ *
+ * @param dest Address of the subscriber
+ * @param process_identifier Subscriber process identifier
+ * @param references Subscribed properties
+ * @param count Number of references
+ * @return The subscriptions of the process, or NULL if MAX_COV_SUBSCRIPTIONS would be exceeded,
+ *         in which case nothing is changed
+ */
+BACNET_COV_MULTIPLE_SUBSCRIPTION* cov_multiple_subscribe(BACNET_ADDRESS* dest,
+    uint32_t process_identifier,
+    const BACNET_COV_REFERENCE* references,
+    unsigned count);
+
+/**
+ * Cancel the subscriptions of a subscriber process to a list of properties.
+ * The process' subscriptions are removed when none are left.
+ */
+void cov_multiple_cancel(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription,
+    const BACNET_COV_REFERENCE* references,
+    unsigned count);
+
+/**
+ * Remove all subscriptions of a subscriber process.
+ */
+void cov_multiple_remove(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription);
+
+/**
+ * Set the lifetime of the subscriptions of a subscriber process, starting now.
+ *
+ * @param lifetime Seconds until the subscriptions expire, 0 for indefinite
+ */
+void cov_multiple_set_lifetime(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription, uint32_t lifetime);
+
+/**
+ * Get the seconds until the subscriptions of a subscriber process expire, 0 for indefinite.
+ */
+uint32_t cov_multiple_time_remaining(const BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription);
+
+/**
+ * Encode the listOfCOVNotifications of a COV-Multiple notification, packing as many of the
+ * collected changes as fit. A change too large for any notification is dropped.
+ *
+ * @param apdu Buffer for the encoding
+ * @param max_apdu Space left in the APDU
+ * @return Length of the encoding, 0 if there is nothing to notify
+ */
+int cov_multiple_encode_notifications(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription,
+    uint8_t* apdu,
+    unsigned max_apdu);
+
+/**
+ * Record the changes encoded by the last cov_multiple_encode_notifications() as notified.
+ */
+void cov_multiple_notified(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription);
+
+/**
+ * Handle the COV-Multiple PDUs stacks older than protocol revision 18 do not know: dispatch
+ * SubscribeCOVPropertyMultiple requests, which their confirmed service table has no slot for,
+ * and release the confirmed COV-Multiple notification an ACK or Error PDU answers, whose invoke
+ * ID would otherwise be kept until it times out. Call for every received NPDU before npdu_handler().
+ *
+ * @param src Datalink source address of the NPDU
+ * @param pdu The NPDU
+ * @param pdu_len Length of the NPDU
+ * @return true if the NPDU was consumed and must not be passed on
+ */
+bool cov_multiple_handler(BACNET_ADDRESS* src, uint8_t* pdu, uint16_t pdu_len);
+
+/**
+ * Queue notifications for the subscribers of every monitored object that changed,
+ * collect changes of properties subscribed with SubscribeCOVPropertyMultiple,
+ * release finished confirmed notifications and send what is due.
+ *
+ * @param notify Sends one notification
+ * @param notify_multiple Sends one COV-Multiple notification
+ */
+void cov_subscriptions_task(cov_notify_function notify, cov_multiple_notify_function notify_multiple);
+
+/**
+ * Check whether any COV subscription is active, i.e. whether the COV task
+ * and the subscription lifetime timer have anything to do.
+ */
+bool handler_cov_active(void);
+
+/**
+ * Handler for a SubscribeCOVProperty request.
+ */
+void handler_cov_subscribe_property(uint8_t* service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS* src,
+    BACNET_CONFIRMED_SERVICE_DATA* service_data);
+
+/**
+ * Handler for a SubscribeCOVPropertyMultiple request.
+ */
+void handler_cov_subscribe_property_multiple(uint8_t* service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS* src,
+    BACNET_CONFIRMED_SERVICE_DATA* service_data);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BACNET_COV_SUBSCRIPTIONS_H */
@@ -0,0 +1,98 @@
+#ifndef BACNET_SEGMENTATION_H
+#define BACNET_SEGMENTATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "apdu.h"
+#include "bacdef.h"
+#include "bacenum.h"
+
+/* segmented complex ACKs that can be in progress at the same time */
+#ifndef MAX_SEGMENTED_TRANSACTIONS
+#define MAX_SEGMENTED_TRANSACTIONS 4
+#endif
+
+/* window size we propose to the requester, 1..127 */
+#ifndef SEGMENTATION_WINDOW_SIZE
+#define SEGMENTATION_WINDOW_SIZE 16
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Get the buffer confirmed service handlers encode their complex ACK into.
+ * It holds MAX_SEGMENTED_APDU bytes, the unsegmented encoding of the APDU.
+ */
+uint8_t* segmentation_buffer(void);
+
+/**
+ * Get the largest complex ACK, in unsegmented encoding, that can be returned
+ * for a request. This is the requester's max APDU unless it accepts
+ * segmented responses.
+ *
+ * @param service_data Decoded header of the confirmed request
+ * @return Maximum APDU length, at most MAX_SEGMENTED_APDU
+ */
+unsigned segmentation_max_apdu(BACNET_CONFIRMED_SERVICE_DATA* service_data);
+
+/**
+ * Get the error code to abort a request with. Object handlers report a reply
+ * that runs out of room as ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED, which
+ * becomes ERROR_CODE_ABORT_BUFFER_OVERFLOW when the requester accepts a
+ * segmented response: the reply is too long even in segments.
+ *
+ * @param service_data Decoded header of the confirmed request
+ * @param error_code Error code set by the handler
+ * @return Error code for abort_convert_error_code()
+ */
+BACNET_ERROR_CODE segmentation_abort_error_code(BACNET_CONFIRMED_SERVICE_DATA* service_data,
+    BACNET_ERROR_CODE error_code);
+
+/**
+ * Send a complex ACK. If it does not fit the requester's max APDU it is
+ * sent as a segmented message, one window at a time as SegmentACKs arrive.
+ * If it cannot be sent at all an Abort is sent instead.
+ *
+ * @param dest Address of the requester
+ * @param service_data Decoded header of the confirmed request
+ * @param apdu Complex ACK in unsegmented encoding, starting with its 3 byte header
+ * @param apdu_len Length of the complex ACK
+ * @return Number of bytes sent for the first PDU, negative on failure
+ */
+int segmentation_send_complex_ack(BACNET_ADDRESS* dest,
+    BACNET_CONFIRMED_SERVICE_DATA* service_data,
+    uint8_t* apdu,
+    unsigned apdu_len);
+
+/**
+ * Handle SegmentACK and Abort PDUs that belong to a segmented complex ACK
+ * in progress. Call for every received NPDU before npdu_handler().
+ *
+ * @param src Datalink source address of the NPDU
+ * @param pdu The NPDU
+ * @param pdu_len Length of the NPDU
+ * @return true if the NPDU was consumed and must not be passed on
+ */
+bool segmentation_handler(BACNET_ADDRESS* src, uint8_t* pdu, uint16_t pdu_len);
+
+/**
+ * Retransmit unacknowledged windows and drop transactions that ran out
+ * of retries.
+ *
+ * @param milliseconds Time elapsed since the last call
+ */
+void segmentation_timer(uint32_t milliseconds);
+
+/**
+ * Check whether a segmented complex ACK is in progress.
+ */
+bool segmentation_active(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BACNET_SEGMENTATION_H */
@@ -85,7 +85,10 @@ static unsigned analog_input_read_property(const BACnetObject& object, BACNET_RE
 
     case PROP_PRESENT_VALUE: {
         float present_value = 0.0f;
-        object.read.present_value_real(rpdata->object_instance, &present_value);
+        if (object.present_value.enabled)
+            present_value = object.present_value.load<float>();
+        else
+            object.read.present_value_real(rpdata->object_instance, &present_value);
         apdu_len = encode_application_real(&apdu[0], present_value);
         break;
     }
@@ -259,7 +262,7 @@ void bacnet::init_analog_input_object_handlers(ObjectTypeHandler& handler) {
     handler.write_property = analog_input_write_property;
     handler.rpm_property_list = analog_input_rpm_property_list;
 
-    handler.intrinsic_reporting = [](const BACnetObject&) {};
+    handler.intrinsic_reporting = [](BACnetObject&) {};
 
     handler.init = [](BACnetObject&) {
 
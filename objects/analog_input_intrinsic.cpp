@@ -34,6 +34,7 @@
 
 #include "c_wrapper.h"
 #include "container.hpp"
+#include "cov_value_list.hpp"
 
 using namespace bacnet;
 
@@ -55,6 +56,7 @@ static const int AI_Properties_Optional[] = {PROP_DESCRIPTION,
                                              PROP_MIN_PRES_VALUE,
                                              PROP_MAX_PRES_VALUE,
                                              PROP_RESOLUTION,
+                                             PROP_COV_INCREMENT,
 // PROP_PROPERTY_LIST,
 #if defined(INTRINSIC_REPORTING)
                                              PROP_EVENT_DETECTION_ENABLE,
@@ -78,6 +80,68 @@ static const int AI_Properties_Optional[] = {PROP_DESCRIPTION,
 
 static const int AI_Properties_Proprietary[] = {-1};
 
+#if defined(INTRINSIC_REPORTING)
+/* The instances of an object range have no intrinsic reporting */
+static const int AI_Range_Properties_Optional[] = {PROP_DESCRIPTION,
+                                                   PROP_DEVICE_TYPE,
+                                                   PROP_MIN_PRES_VALUE,
+                                                   PROP_MAX_PRES_VALUE,
+                                                   PROP_RESOLUTION,
+                                                   PROP_COV_INCREMENT,
+                                                   -1};
+#endif
+
+#if defined(INTRINSIC_REPORTING)
+/* certified builds ask the application, otherwise it is set when the object is added */
+static bool analog_input_event_detection_enable(const BACnetObject &object, uint32_t object_instance) {
+    bool event_detection_enable = false;
+#if defined(CERTIFICATION_SOFTWARE)
+    object.read.event_detection_enable(object_instance, &event_detection_enable);
+#else
+    (void) object_instance;
+    event_detection_enable = object.ai_irp->event_detection_enable;
+#endif
+    return event_detection_enable;
+}
+
+/* Event_State and Acked_Transitions decide whether the object is in the active alarm set */
+static void analog_input_set_event_state(BACnetObject &object, uint8_t event_state) {
+    object.ai_irp->event_state = event_state;
+    container.updateActiveAlarm(&object);
+    /* Status_Flags follow the event state, COV has to look at the object again */
+    object.present_value.changes.fetch_add(1, std::memory_order_release);
+}
+
+static void analog_input_set_acked_transitions(BACnetObject &object,
+                                               const std::vector<ACKED_INFO> &acked_transitions) {
+    object.ai_irp->acked_transitions = acked_transitions;
+    container.updateActiveAlarm(&object);
+}
+#endif
+
+#if defined(INTRINSIC_REPORTING)
+/* Properties kept in ai_irp. The instances of an object range share one object, they have no intrinsic reporting
+   and none of these properties. */
+static bool analog_input_intrinsic_property(BACNET_PROPERTY_ID property) {
+    switch (property) {
+        case PROP_EVENT_DETECTION_ENABLE:
+        case PROP_TIME_DELAY:
+        case PROP_NOTIFICATION_CLASS:
+        case PROP_HIGH_LIMIT:
+        case PROP_LOW_LIMIT:
+        case PROP_DEADBAND:
+        case PROP_LIMIT_ENABLE:
+        case PROP_EVENT_ENABLE:
+        case PROP_ACKED_TRANSITIONS:
+        case PROP_NOTIFY_TYPE:
+        case PROP_EVENT_TIME_STAMPS:
+            return true;
+        default:
+            return false;
+    }
+}
+#endif
+
 static unsigned analog_input_intrinsic_read_property(const BACnetObject &object, BACNET_READ_PROPERTY_DATA *rpdata) {
     int apdu_len = 0;
     BACNET_BIT_STRING bit_string;
@@ -94,6 +158,14 @@ static unsigned analog_input_intrinsic_read_property(const BACnetObject &object,
 
     apdu = rpdata->application_data;
 
+#if defined(INTRINSIC_REPORTING)
+    if (!object.ai_irp && analog_input_intrinsic_property(rpdata->object_property)) {
+        rpdata->error_class = ERROR_CLASS_PROPERTY;
+        rpdata->error_code = ERROR_CODE_UNKNOWN_PROPERTY;
+        return BACNET_STATUS_ERROR;
+    }
+#endif
+
     switch (rpdata->object_property) {
         case PROP_OBJECT_IDENTIFIER: {
             apdu_len = encode_application_object_id(&apdu[0], object.type, rpdata->object_instance);
@@ -114,7 +186,10 @@ static unsigned analog_input_intrinsic_read_property(const BACnetObject &object,
 
         case PROP_PRESENT_VALUE: {
             float present_value = 0.0f;
-            object.read.present_value_real(rpdata->object_instance, &present_value);
+            if (object.present_value.enabled)
+                present_value = object.present_value.load<float>();
+            else
+                object.read.present_value_real(rpdata->object_instance, &present_value);
             apdu_len = encode_application_real(&apdu[0], present_value);
             break;
         }
@@ -140,6 +215,10 @@ static unsigned analog_input_intrinsic_read_property(const BACnetObject &object,
             break;
         };
 
+        case PROP_COV_INCREMENT:
+            apdu_len = encode_application_real(&apdu[0], object.cov.increment);
+            break;
+
         case PROP_STATUS_FLAGS: {
             // TOOD: read from properties
             bool out_of_service = false;
@@ -148,8 +227,9 @@ static unsigned analog_input_intrinsic_read_property(const BACnetObject &object,
 
             bitstring_init(&bit_string);
 #if defined(INTRINSIC_REPORTING)
-            uint8_t event_state;
-            object.read.event_state(rpdata->object_instance, &event_state);
+            uint8_t event_state = EVENT_STATE_NORMAL;
+            if (object.ai_irp)
+                event_state = object.ai_irp->event_state;
             bitstring_set_bit(&bit_string, STATUS_FLAG_IN_ALARM, event_state ? true : false);
 #else
             bitstring_set_bit(&bit_string, STATUS_FLAG_IN_ALARM, false);
@@ -164,8 +244,9 @@ static unsigned analog_input_intrinsic_read_property(const BACnetObject &object,
 
         case PROP_EVENT_STATE: {
 #if defined(INTRINSIC_REPORTING)
-            uint8_t event_state;
-            object.read.event_state(rpdata->object_instance, &event_state);
+            uint8_t event_state = EVENT_STATE_NORMAL;
+            if (object.ai_irp)
+                event_state = object.ai_irp->event_state;
             apdu_len = encode_application_enumerated(&apdu[0], event_state);
 #else
             // TOOD: read from properties
@@ -208,44 +289,32 @@ static unsigned analog_input_intrinsic_read_property(const BACnetObject &object,
 
 #if defined(INTRINSIC_REPORTING)
         case PROP_EVENT_DETECTION_ENABLE: {
-            bool event_detection_enable;
-            object.read.event_detection_enable(rpdata->object_instance, &event_detection_enable);
-            apdu_len = encode_application_boolean(&apdu[0], event_detection_enable);
+            apdu_len = encode_application_boolean(&apdu[0],
+                                                  analog_input_event_detection_enable(object, rpdata->object_instance));
             break;
         }
         case PROP_TIME_DELAY: {
-            unsigned time_delay;
-            object.read.time_delay(rpdata->object_instance, &time_delay);
-            apdu_len = encode_application_unsigned(&apdu[0], time_delay);
+            apdu_len = encode_application_unsigned(&apdu[0], object.ai_irp->time_delay);
             break;
         }
         case PROP_NOTIFICATION_CLASS: {
-            unsigned notification_class;
-            object.read.notification_class(rpdata->object_instance, &notification_class);
-            apdu_len = encode_application_unsigned(&apdu[0], notification_class);
+            apdu_len = encode_application_unsigned(&apdu[0], object.ai_irp->notification_class);
             break;
         }
         case PROP_HIGH_LIMIT: {
-            float high_limit;
-            object.read.high_limit(rpdata->object_instance, &high_limit);
-            apdu_len = encode_application_real(&apdu[0], high_limit);
+            apdu_len = encode_application_real(&apdu[0], object.ai_irp->high_limit);
             break;
         }
         case PROP_LOW_LIMIT: {
-            float low_limit;
-            object.read.low_limit(rpdata->object_instance, &low_limit);
-            apdu_len = encode_application_real(&apdu[0], low_limit);
+            apdu_len = encode_application_real(&apdu[0], object.ai_irp->low_limit);
             break;
         }
         case PROP_DEADBAND: {
-            float deadband;
-            object.read.deadband(rpdata->object_instance, &deadband);
-            apdu_len = encode_application_real(&apdu[0], deadband);
+            apdu_len = encode_application_real(&apdu[0], object.ai_irp->deadband);
             break;
         }
         case PROP_LIMIT_ENABLE: {
-            uint8_t limit_enable;
-            object.read.limit_enable(rpdata->object_instance, &limit_enable);
+            uint8_t limit_enable = object.ai_irp->limit_enable;
 
             bitstring_init(&bit_string);
             bitstring_set_bit(&bit_string, 0, (limit_enable & EVENT_LOW_LIMIT_ENABLE) ? true : false);
@@ -254,8 +323,7 @@ static unsigned analog_input_intrinsic_read_property(const BACnetObject &object,
             break;
         }
         case PROP_EVENT_ENABLE: {
-            uint8_t event_enable;
-            object.read.event_enable(rpdata->object_instance, &event_enable);
+            uint8_t event_enable = object.ai_irp->event_enable;
 
             bitstring_init(&bit_string);
             bitstring_set_bit(&bit_string,
@@ -269,9 +337,7 @@ static unsigned analog_input_intrinsic_read_property(const BACnetObject &object,
             break;
         }
         case PROP_ACKED_TRANSITIONS: {
-            std::vector<ACKED_INFO> acked_transitions;
-            acked_transitions.reserve(MAX_BACNET_EVENT_TRANSITION);
-            object.read.acked_transitions(rpdata->object_instance, acked_transitions);
+            const auto &acked_transitions = object.ai_irp->acked_transitions;
 
             bitstring_init(&bit_string);
             bitstring_set_bit(&bit_string, TRANSITION_TO_OFFNORMAL,
@@ -283,16 +349,13 @@ static unsigned analog_input_intrinsic_read_property(const BACnetObject &object,
             break;
         }
         case PROP_NOTIFY_TYPE: {
-            uint8_t notify_type;
-            object.read.notify_type(rpdata->object_instance, &notify_type);
+            uint8_t notify_type = object.ai_irp->notify_type;
 
             apdu_len = encode_application_enumerated(&apdu[0], notify_type ? NOTIFY_EVENT : NOTIFY_ALARM);
             break;
         }
         case PROP_EVENT_TIME_STAMPS: {
-            std::vector<BACNET_DATE_TIME> event_time_stamps;
-            event_time_stamps.reserve(MAX_BACNET_EVENT_TRANSITION);
-            object.read.event_time_stamps(rpdata->object_instance, event_time_stamps);
+            const auto &event_time_stamps = object.ai_irp->event_time_stamps;
 
             /* Array element zero is the number of elements in the array */
             if (rpdata->array_index == 0)
@@ -371,8 +434,29 @@ static bool analog_input_intrinsic_write_property(BACnetObject &object, BACNET_W
         wp_data->error_code = ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY;
         return false;
     }
+#if defined(INTRINSIC_REPORTING)
+    if (!object.ai_irp && analog_input_intrinsic_property(wp_data->object_property)) {
+        wp_data->error_class = ERROR_CLASS_PROPERTY;
+        wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
+        return false;
+    }
+#endif
 
     switch ((int) wp_data->object_property) {
+        case PROP_COV_INCREMENT:
+            status = WPValidateArgType(&value, BACNET_APPLICATION_TAG_REAL, &wp_data->error_class, &wp_data->error_code);
+
+            if (status) {
+                if (value.type.Real >= 0.0f) {
+                    object.cov.increment = value.type.Real;
+                } else {
+                    status = false;
+                    wp_data->error_class = ERROR_CLASS_PROPERTY;
+                    wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
+                }
+            }
+            break;
+
 #if defined(INTRINSIC_REPORTING)
 #if defined(CERTIFICATION_SOFTWARE)
         case PROP_TIME_DELAY:
@@ -380,12 +464,8 @@ static bool analog_input_intrinsic_write_property(BACnetObject &object, BACNET_W
                 WPValidateArgType(&value, BACNET_APPLICATION_TAG_UNSIGNED_INT, &wp_data->error_class, &wp_data->error_code);
 
             if (status) {
-                object.write.time_delay(wp_data->object_instance, value.type.Unsigned_Int);
-
-                unsigned time_delay;
-                object.read.time_delay(wp_data->object_instance, &time_delay);
-
-                object.write.remaining_time_delay(wp_data->object_instance, time_delay);
+                object.ai_irp->time_delay = value.type.Unsigned_Int;
+                object.ai_irp->remaining_time_delay = value.type.Unsigned_Int;
             }
             break;
 
@@ -394,7 +474,7 @@ static bool analog_input_intrinsic_write_property(BACnetObject &object, BACNET_W
                 WPValidateArgType(&value, BACNET_APPLICATION_TAG_UNSIGNED_INT, &wp_data->error_class, &wp_data->error_code);
 
             if (status) {
-                object.write.notification_class(wp_data->object_instance, value.type.Unsigned_Int);
+                object.ai_irp->notification_class = value.type.Unsigned_Int;
             }
             break;
 
@@ -402,7 +482,7 @@ static bool analog_input_intrinsic_write_property(BACnetObject &object, BACNET_W
             status = WPValidateArgType(&value, BACNET_APPLICATION_TAG_REAL, &wp_data->error_class, &wp_data->error_code);
 
             if (status) {
-                object.write.high_limit(wp_data->object_instance, value.type.Real);
+                object.ai_irp->high_limit = value.type.Real;
             }
             break;
 
@@ -410,7 +490,7 @@ static bool analog_input_intrinsic_write_property(BACnetObject &object, BACNET_W
             status = WPValidateArgType(&value, BACNET_APPLICATION_TAG_REAL, &wp_data->error_class, &wp_data->error_code);
 
             if (status) {
-                object.write.low_limit(wp_data->object_instance, value.type.Real);
+                object.ai_irp->low_limit = value.type.Real;
             }
             break;
 
@@ -418,7 +498,7 @@ static bool analog_input_intrinsic_write_property(BACnetObject &object, BACNET_W
             status = WPValidateArgType(&value, BACNET_APPLICATION_TAG_REAL, &wp_data->error_class, &wp_data->error_code);
 
             if (status) {
-                object.write.deadband(wp_data->object_instance, value.type.Real);
+                object.ai_irp->deadband = value.type.Real;
             }
             break;
 
@@ -428,7 +508,7 @@ static bool analog_input_intrinsic_write_property(BACnetObject &object, BACNET_W
 
             if (status) {
                 if (value.type.Bit_String.bits_used == 2) {
-                    object.write.limit_enable(wp_data->object_instance, value.type.Bit_String.value[0]);
+                    object.ai_irp->limit_enable = value.type.Bit_String.value[0];
                 } else {
                     wp_data->error_class = ERROR_CLASS_PROPERTY;
                     wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
@@ -443,7 +523,7 @@ static bool analog_input_intrinsic_write_property(BACnetObject &object, BACNET_W
 
             if (status) {
                 if (value.type.Bit_String.bits_used == 3) {
-                    object.write.event_enable(wp_data->object_instance, value.type.Bit_String.value[0]);
+                    object.ai_irp->event_enable = value.type.Bit_String.value[0];
                 } else {
                     wp_data->error_class = ERROR_CLASS_PROPERTY;
                     wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
@@ -460,10 +540,10 @@ static bool analog_input_intrinsic_write_property(BACnetObject &object, BACNET_W
             if (status) {
                 switch ((BACNET_NOTIFY_TYPE) value.type.Enumerated) {
                     case NOTIFY_EVENT:
-                        object.write.notify_type(wp_data->object_instance, 1);
+                        object.ai_irp->notify_type = 1;
                         break;
                     case NOTIFY_ALARM:
-                        object.write.notify_type(wp_data->object_instance, 0);
+                        object.ai_irp->notify_type = 0;
                         break;
                     default:
                         wp_data->error_class = ERROR_CLASS_PROPERTY;
@@ -519,10 +599,16 @@ static bool analog_input_intrinsic_write_property(BACnetObject &object, BACNET_W
             break;
     }
 
+#if defined(INTRINSIC_REPORTING)
+    /* limits, delays and enables feed intrinsic reporting */
+    if (status && object.ai_irp)
+        object.ai_irp->settled = false;
+#endif
+
     return status;
 }
 
-static void analog_input_intrinsic_reporting(const BACnetObject &object) {
+static void analog_input_intrinsic_reporting(BACnetObject &object) {
 
 #if defined(INTRINSIC_REPORTING)
     BACNET_EVENT_NOTIFICATION_DATA event_data;
@@ -535,15 +621,26 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
     uint8_t /* event_enable,*/ limit_enable, notify_type, event_state;
     uint32_t time_delay, remaining_time_delay;
 
-    object.read.limit_enable(object.instance, &limit_enable);
+    /* a pass over a store backed object repeats the last one while the present value and state stand still */
+    uint32_t changes = object.present_value.changes.load(std::memory_order_acquire);
+    if (object.ai_irp->settled && object.ai_irp->settled_changes == changes &&
+        !object.ai_irp->ack_notify_data->bSendAckNotify)
+        return;
+
+    const uint8_t previous_event_state = object.ai_irp->event_state;
+    const uint8_t previous_last_offnormal_event_state = object.ai_irp->last_offnormal_event_state;
+    const uint32_t previous_remaining_time_delay = object.ai_irp->remaining_time_delay;
+    const float previous_high_limit = object.ai_irp->high_limit;
+
+    limit_enable = object.ai_irp->limit_enable;
 
     ACK_NOTIFICATION ack_notify_data;
-    object.read.ack_notify_data(object.instance, ack_notify_data);
+    ack_notify_data = *object.ai_irp->ack_notify_data;
 
     if (ack_notify_data.bSendAckNotify) {
         /* clean bSendAckNotify flag */
         ack_notify_data.bSendAckNotify = false;
-        object.write.ack_notify_data(object.instance, ack_notify_data);
+        *object.ai_irp->ack_notify_data = ack_notify_data;
         /* copy toState */
         ToState = ack_notify_data.EventState;
 
@@ -556,9 +653,12 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
         SendNotify = true;
     } else {
         /* actual Present_Value */
-        object.read.present_value_real(object.instance, &present_val);
+        if (object.present_value.enabled)
+            present_val = object.present_value.load<float>();
+        else
+            object.read.present_value_real(object.instance, &present_val);
 
-        object.read.event_state(object.instance, &event_state);
+        event_state = object.ai_irp->event_state;
         FromState = event_state;
 
         // OUT_OF_RANGE algorithm (13.3.6 in 135-2016)
@@ -572,18 +672,18 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                    period of time, specified in the Time_Delay property, and
                    (d) OBSOLETE?: the TO-OFFNORMAL flag must be set in the Event_Enable property. */
 
-                object.read.high_limit(object.instance, &high_limit);
-                // object.read.event_enable(object.instance, &event_enable);
-                object.read.remaining_time_delay(object.instance, &remaining_time_delay);
+                high_limit = object.ai_irp->high_limit;
+                // event_enable = object.ai_irp->event_enable;
+                remaining_time_delay = object.ai_irp->remaining_time_delay;
 
                 if ((present_val > high_limit) && ((limit_enable & EVENT_HIGH_LIMIT_ENABLE) == EVENT_HIGH_LIMIT_ENABLE)/* &&
                 ((event_enable & EVENT_ENABLE_TO_OFFNORMAL) == EVENT_ENABLE_TO_OFFNORMAL)*/) {
 
                     if (!remaining_time_delay)
-                        object.write.event_state(object.instance, EVENT_STATE_HIGH_LIMIT);
+                        analog_input_set_event_state(object, EVENT_STATE_HIGH_LIMIT);
                     else {
                         remaining_time_delay--;
-                        object.write.remaining_time_delay(object.instance, remaining_time_delay);
+                        object.ai_irp->remaining_time_delay = remaining_time_delay;
                     }
                     break;
                 }
@@ -594,22 +694,22 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                    (c) the Present_Value must exceed the Low_Limit plus the Deadband
                    for a minimum period of time, specified in the Time_Delay property, and
                    (d) OBSOLETE?: the TO-NORMAL flag must be set in the Event_Enable property. */
-                object.read.low_limit(object.instance, &low_limit);
+                low_limit = object.ai_irp->low_limit;
 
                 if ((present_val < low_limit) && ((limit_enable & EVENT_LOW_LIMIT_ENABLE) == EVENT_LOW_LIMIT_ENABLE)/* &&
                 ((limit_enable & EVENT_ENABLE_TO_OFFNORMAL) == EVENT_ENABLE_TO_OFFNORMAL)*/) {
 
                     if (!remaining_time_delay)
-                        object.write.event_state(object.instance, EVENT_STATE_LOW_LIMIT);
+                        analog_input_set_event_state(object, EVENT_STATE_LOW_LIMIT);
                     else {
                         remaining_time_delay--;
-                        object.write.remaining_time_delay(object.instance, remaining_time_delay);
+                        object.ai_irp->remaining_time_delay = remaining_time_delay;
                     }
                     break;
                 }
                 /* value of the object is still in the same event state */
-                object.read.time_delay(object.instance, &time_delay);
-                object.write.remaining_time_delay(object.instance, time_delay);
+                time_delay = object.ai_irp->time_delay;
+                object.ai_irp->remaining_time_delay = time_delay;
                 break;
 
             case EVENT_STATE_HIGH_LIMIT:
@@ -621,15 +721,15 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                    (c) the HighLimitEnable flag must be set in the Limit_Enable property, and
                    (d) OBSOLETE?: the TO-NORMAL flag must be set in the Event_Enable property. */
 
-                object.read.deadband(object.instance, &deadband);
-                object.read.high_limit(object.instance, &high_limit);
-                object.read.low_limit(object.instance, &low_limit);
-                // object.read.event_enable(object.instance, &event_enable);
-                object.read.remaining_time_delay(object.instance, &remaining_time_delay);
+                deadband = object.ai_irp->deadband;
+                high_limit = object.ai_irp->high_limit;
+                low_limit = object.ai_irp->low_limit;
+                // event_enable = object.ai_irp->event_enable;
+                remaining_time_delay = object.ai_irp->remaining_time_delay;
 
                 // If High limit enable is false
                 if ((limit_enable & EVENT_HIGH_LIMIT_ENABLE) != EVENT_HIGH_LIMIT_ENABLE) {
-                    object.write.event_state(object.instance, EVENT_STATE_NORMAL);
+                    analog_input_set_event_state(object, EVENT_STATE_NORMAL);
                     break;
                 }
 
@@ -637,10 +737,10 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                 if ((present_val < low_limit) && ((limit_enable & EVENT_LOW_LIMIT_ENABLE) == EVENT_LOW_LIMIT_ENABLE)/* &&
                 ((event_enable & EVENT_ENABLE_TO_OFFNORMAL) == EVENT_ENABLE_TO_OFFNORMAL)*/) {
                     if (!remaining_time_delay)
-                        object.write.event_state(object.instance, EVENT_STATE_LOW_LIMIT);
+                        analog_input_set_event_state(object, EVENT_STATE_LOW_LIMIT);
                     else {
                         remaining_time_delay--;
-                        object.write.remaining_time_delay(object.instance, remaining_time_delay);
+                        object.ai_irp->remaining_time_delay = remaining_time_delay;
                     }
                     break;
                 }
@@ -650,18 +750,18 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                 ((limit_enable & EVENT_HIGH_LIMIT_ENABLE) == EVENT_HIGH_LIMIT_ENABLE) &&
                 ((event_enable & EVENT_ENABLE_TO_NORMAL) == EVENT_ENABLE_TO_NORMAL)*/) {
                     if (!remaining_time_delay) {
-                        object.write.event_state(object.instance, EVENT_STATE_NORMAL);
+                        analog_input_set_event_state(object, EVENT_STATE_NORMAL);
                     } else {
                         remaining_time_delay--;
-                        object.write.remaining_time_delay(object.instance, remaining_time_delay);
+                        object.ai_irp->remaining_time_delay = remaining_time_delay;
                     }
                     break;
                 }
 
                 /* value of the object is still in the same event state */
-                object.read.time_delay(object.instance, &time_delay);
-                object.write.remaining_time_delay(object.instance, time_delay);
-                object.write.last_offnormal_event_state(object.instance, event_state);
+                time_delay = object.ai_irp->time_delay;
+                object.ai_irp->remaining_time_delay = time_delay;
+                object.ai_irp->last_offnormal_event_state = event_state;
                 break;
 
             case EVENT_STATE_LOW_LIMIT:
@@ -673,15 +773,15 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                    for a minimum period of time, specified in the Time_Delay property, and
                    (c) the LowLimitEnable flag must be set in the Limit_Enable property, and
                    (d) OBSOLETE?: the TO-NORMAL flag must be set in the Event_Enable property. */
-                object.read.deadband(object.instance, &deadband);
-                object.read.high_limit(object.instance, &high_limit);
-                object.read.low_limit(object.instance, &low_limit);
-                // object.read.event_enable(object.instance, &event_enable);
-                object.read.remaining_time_delay(object.instance, &remaining_time_delay);
+                deadband = object.ai_irp->deadband;
+                high_limit = object.ai_irp->high_limit;
+                low_limit = object.ai_irp->low_limit;
+                // event_enable = object.ai_irp->event_enable;
+                remaining_time_delay = object.ai_irp->remaining_time_delay;
 
                 // If Low limit enable is false
                 if ((limit_enable & EVENT_LOW_LIMIT_ENABLE) != EVENT_LOW_LIMIT_ENABLE) {
-                    object.write.event_state(object.instance, EVENT_STATE_NORMAL);
+                    analog_input_set_event_state(object, EVENT_STATE_NORMAL);
                     break;
                 }
 
@@ -690,10 +790,10 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                 ((event_enable & EVENT_ENABLE_TO_OFFNORMAL) == EVENT_ENABLE_TO_OFFNORMAL)*/) {
 
                     if (!remaining_time_delay)
-                        object.write.event_state(object.instance, EVENT_STATE_HIGH_LIMIT);
+                        analog_input_set_event_state(object, EVENT_STATE_HIGH_LIMIT);
                     else {
                         remaining_time_delay--;
-                        object.write.remaining_time_delay(object.instance, remaining_time_delay);
+                        object.ai_irp->remaining_time_delay = remaining_time_delay;
                     }
                     break;
                 }
@@ -703,17 +803,17 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                 ((limit_enable & EVENT_LOW_LIMIT_ENABLE) == EVENT_LOW_LIMIT_ENABLE) &&
                 ((event_enable & EVENT_ENABLE_TO_NORMAL) == EVENT_ENABLE_TO_NORMAL)*/) {
                     if (!remaining_time_delay)
-                        object.write.event_state(object.instance, EVENT_STATE_NORMAL);
+                        analog_input_set_event_state(object, EVENT_STATE_NORMAL);
                     else {
                         remaining_time_delay--;
-                        object.write.remaining_time_delay(object.instance, remaining_time_delay);
+                        object.ai_irp->remaining_time_delay = remaining_time_delay;
                     }
                     break;
                 }
                 /* value of the object is still in the same event state */
-                object.read.time_delay(object.instance, &time_delay);
-                object.write.remaining_time_delay(object.instance, time_delay);
-                object.write.last_offnormal_event_state(object.instance, event_state);
+                time_delay = object.ai_irp->time_delay;
+                object.ai_irp->remaining_time_delay = time_delay;
+                object.ai_irp->last_offnormal_event_state = event_state;
                 break;
 
             default:
@@ -721,7 +821,7 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
         }           /* switch (FromState) */
 
         // Check event enable whether to send out a notification
-        object.read.event_state(object.instance, &event_state);
+        event_state = object.ai_irp->event_state;
         ToState = event_state;
 
         uint8_t event_enable_flag = EVENT_ENABLE_TO_NORMAL;
@@ -729,7 +829,7 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
             event_enable_flag = EVENT_ENABLE_TO_OFFNORMAL;
 
         uint8_t event_enable;
-        object.read.event_enable(object.instance, &event_enable);
+        event_enable = object.ai_irp->event_enable;
         bool isEventEnabled = (event_enable & event_enable_flag) == event_enable_flag;
 
         if (FromState != ToState && isEventEnabled) {
@@ -739,7 +839,7 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
 
             switch (ToState) {
                 case EVENT_STATE_HIGH_LIMIT:
-                    object.read.high_limit(object.instance, &high_limit);
+                    high_limit = object.ai_irp->high_limit;
                     ExceededLimit = high_limit;
 #if defined(CERTIFICATION_SOFTWARE)
                     characterstring_init_ansi(&msgText, "Goes to high limit");
@@ -749,18 +849,18 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                     break;
 
                 case EVENT_STATE_LOW_LIMIT:
-                    object.read.low_limit(object.instance, &low_limit);
+                    low_limit = object.ai_irp->low_limit;
                     ExceededLimit = low_limit;
                     characterstring_init_ansi(&msgText, "Goes to low limit");
                     break;
 
                 case EVENT_STATE_NORMAL:
                     if (FromState == EVENT_STATE_HIGH_LIMIT) {
-                        object.read.high_limit(object.instance, &high_limit);
+                        high_limit = object.ai_irp->high_limit;
                         ExceededLimit = high_limit;
                         characterstring_init_ansi(&msgText, "Back to normal state from high limit");
                     } else {
-                        object.read.low_limit(object.instance, &low_limit);
+                        low_limit = object.ai_irp->low_limit;
                         ExceededLimit = low_limit;
                         characterstring_init_ansi(&msgText, "Back to normal state from low limit");
                     }
@@ -772,7 +872,7 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
             } /* switch (ToState) */
 
             /* Notify Type */
-            object.read.notify_type(object.instance, &notify_type);
+            notify_type = object.ai_irp->notify_type;
             event_data.notifyType = static_cast<BACNET_NOTIFY_TYPE>(notify_type);
 
             /* Send EventNotification. */
@@ -781,9 +881,9 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
             // To return the state to normal after an alarm has been triggered
 #if !defined(CERTIFICATION_SOFTWARE)
         else {
-            object.read.high_limit(object.instance, &high_limit);
+            high_limit = object.ai_irp->high_limit;
             if (high_limit < present_val && event_state != EVENT_STATE_NORMAL) {
-                object.write.high_limit(object.instance, present_val);
+                object.ai_irp->high_limit = present_val;
             }
         }
 #endif
@@ -802,7 +902,7 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
         if (event_data.notifyType != NOTIFY_ACK_NOTIFICATION) {
             std::vector<BACNET_DATE_TIME> event_time_stamps;
             event_time_stamps.reserve(MAX_BACNET_EVENT_TRANSITION);
-            object.read.event_time_stamps(object.instance, event_time_stamps);
+            event_time_stamps = object.ai_irp->event_time_stamps;
 
             /* fill Event_Time_Stamps */
             switch (ToState) {
@@ -819,12 +919,12 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                     event_time_stamps[TRANSITION_TO_NORMAL] = event_data.timeStamp.value.dateTime;
                     break;
             }
-            object.write.event_time_stamps(object.instance, event_time_stamps);
+            object.ai_irp->event_time_stamps = event_time_stamps;
         }
 
         /* Notification Class */
         unsigned notification_class;
-        object.read.notification_class(object.instance, &notification_class);
+        notification_class = object.ai_irp->notification_class;
         event_data.notificationClass = notification_class;
 
         /* Event Type */
@@ -843,8 +943,9 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
         /* To State */
         event_data.toState = static_cast<BACNET_EVENT_STATE>(ToState);
 
-        bool out_of_service;
-        object.read.out_of_service(object.instance, &out_of_service);
+        bool out_of_service = false;
+        if (object.read.out_of_service)
+            object.read.out_of_service(object.instance, &out_of_service);
 
         /* Event Values */
         if (event_data.notifyType != NOTIFY_ACK_NOTIFICATION) {
@@ -861,7 +962,7 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                               STATUS_FLAG_OUT_OF_SERVICE,
                               out_of_service);
             /* Deadband used for limit checking. */
-            object.read.deadband(object.instance, &deadband);
+            deadband = object.ai_irp->deadband;
             event_data.notificationParams.outOfRange.deadband = deadband;
             /* Limit that was exceeded. */
             event_data.notificationParams.outOfRange.exceededLimit = ExceededLimit;
@@ -874,7 +975,7 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
         if ((event_data.notifyType != NOTIFY_ACK_NOTIFICATION) && (event_data.ackRequired == true)) {
             std::vector<ACKED_INFO> acked_transitions;
             acked_transitions.reserve(MAX_BACNET_EVENT_TRANSITION);
-            object.read.acked_transitions(object.instance, acked_transitions);
+            acked_transitions = object.ai_irp->acked_transitions;
 
             switch (event_data.toState) {
                 case EVENT_STATE_OFFNORMAL:
@@ -895,10 +996,16 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
                     break;
             }
 
-            object.write.acked_transitions(object.instance, acked_transitions);
+            analog_input_set_acked_transitions(object, acked_transitions);
         }
     }
 
+    object.ai_irp->settled = object.present_value.enabled && !SendNotify &&
+                             object.ai_irp->event_state == previous_event_state &&
+                             object.ai_irp->last_offnormal_event_state == previous_last_offnormal_event_state &&
+                             object.ai_irp->remaining_time_delay == previous_remaining_time_delay &&
+                             object.ai_irp->high_limit == previous_high_limit;
+    object.ai_irp->settled_changes = changes;
 #endif
 }
 
@@ -906,265 +1013,224 @@ static void analog_input_intrinsic_reporting(const BACnetObject &object) {
 
 int analog_input_alarm_ack(BACNET_ALARM_ACK_DATA *alarmack_data, BACNET_ERROR_CODE *error_code) {
 
-    bool found = false;
-
-    for (auto &object : container.getDeviceObject()->objects) {
-        if (object->type == OBJECT_ANALOG_INPUT && object->instance == alarmack_data->eventObjectIdentifier.instance) {
-
-            bool event_detection_enable;
-#if !defined(CERTIFICATION_SOFTWARE)
-            event_detection_enable = object->ai_irp.event_detection_enable;
-#else
-            object->read.event_detection_enable(object->instance, &event_detection_enable);
-#endif
-
-            if (!event_detection_enable) {
-                *error_code = ERROR_CODE_NO_ALARM_CONFIGURED;
-                return -2;
-            }
-
-            std::vector<ACKED_INFO> acked_transitions;
-            acked_transitions.reserve(MAX_BACNET_EVENT_TRANSITION);
-            object->read.acked_transitions(object->instance, acked_transitions);
-
-            uint8_t event_state;
-            object->read.event_state(object->instance, &event_state);
+    auto object = container.findObject(OBJECT_ANALOG_INPUT, alarmack_data->eventObjectIdentifier.instance);
+    if (object == nullptr) {
+        *error_code = ERROR_CODE_UNKNOWN_OBJECT;
+        return -2;
+    }
 
-            switch (alarmack_data->eventStateAcked) {
-                case EVENT_STATE_OFFNORMAL:
-                case EVENT_STATE_HIGH_LIMIT:
-                case EVENT_STATE_LOW_LIMIT:
+    /* the instances of an object range have no intrinsic reporting */
+    if (!object->ai_irp || !analog_input_event_detection_enable(*object, object->instance)) {
+        *error_code = ERROR_CODE_NO_ALARM_CONFIGURED;
+        return -2;
+    }
 
-                    if (alarmack_data->eventTimeStamp.tag != TIME_STAMP_DATETIME) {
-                        *error_code = ERROR_CODE_INVALID_TIME_STAMP;
-                        return -1;
-                    }
-                    if (datetime_compare(&acked_transitions[TRANSITION_TO_OFFNORMAL].Time_Stamp,
-                                         &alarmack_data->eventTimeStamp.value.dateTime) > 0) {
-                        *error_code = ERROR_CODE_INVALID_TIME_STAMP;
-                        return -1;
-                    }
+    std::vector<ACKED_INFO> acked_transitions;
+    acked_transitions.reserve(MAX_BACNET_EVENT_TRANSITION);
+    acked_transitions = object->ai_irp->acked_transitions;
 
-                    uint8_t last_offnormal_event_state;
-                    object->read.last_offnormal_event_state(object->instance, &last_offnormal_event_state);
+    uint8_t event_state;
+    event_state = object->ai_irp->event_state;
 
-                    if (alarmack_data->eventStateAcked != EVENT_STATE_OFFNORMAL) {
-                        if (alarmack_data->eventStateAcked !=
-                            static_cast<BACNET_EVENT_STATE>(last_offnormal_event_state)) {
-                            *error_code = ERROR_CODE_INVALID_EVENT_STATE;
-                            return -1;
-                        }
-                    }
+    switch (alarmack_data->eventStateAcked) {
+        case EVENT_STATE_OFFNORMAL:
+        case EVENT_STATE_HIGH_LIMIT:
+        case EVENT_STATE_LOW_LIMIT:
 
-                    /* FIXME: Send ack notification */
-                    acked_transitions[TRANSITION_TO_OFFNORMAL].bIsAcked = true;
-                    object->write.acked_transitions(object->instance, acked_transitions);
-                    break;
+            if (alarmack_data->eventTimeStamp.tag != TIME_STAMP_DATETIME) {
+                *error_code = ERROR_CODE_INVALID_TIME_STAMP;
+                return -1;
+            }
+            if (datetime_compare(&acked_transitions[TRANSITION_TO_OFFNORMAL].Time_Stamp,
+                                 &alarmack_data->eventTimeStamp.value.dateTime) > 0) {
+                *error_code = ERROR_CODE_INVALID_TIME_STAMP;
+                return -1;
+            }
 
-                case EVENT_STATE_FAULT:
-                    if (alarmack_data->eventTimeStamp.tag != TIME_STAMP_DATETIME) {
-                        *error_code = ERROR_CODE_INVALID_TIME_STAMP;
-                        return -1;
-                    }
-                    if (datetime_compare(&acked_transitions[TRANSITION_TO_FAULT].Time_Stamp,
-                                         &alarmack_data->eventTimeStamp.value.dateTime) > 0) {
-                        *error_code = ERROR_CODE_INVALID_TIME_STAMP;
-                        return -1;
-                    }
+            uint8_t last_offnormal_event_state;
+            last_offnormal_event_state = object->ai_irp->last_offnormal_event_state;
 
-                    /* FIXME: Send ack notification */
-                    acked_transitions[TRANSITION_TO_FAULT].bIsAcked = true;
-                    object->write.acked_transitions(object->instance, acked_transitions);
-                    break;
+            if (alarmack_data->eventStateAcked != EVENT_STATE_OFFNORMAL) {
+                if (alarmack_data->eventStateAcked !=
+                    static_cast<BACNET_EVENT_STATE>(last_offnormal_event_state)) {
+                    *error_code = ERROR_CODE_INVALID_EVENT_STATE;
+                    return -1;
+                }
+            }
 
-                case EVENT_STATE_NORMAL:
-                    if (alarmack_data->eventTimeStamp.tag != TIME_STAMP_DATETIME) {
-                        *error_code = ERROR_CODE_INVALID_TIME_STAMP;
-                        return -1;
-                    }
-                    if (datetime_compare(&acked_transitions[TRANSITION_TO_NORMAL].Time_Stamp,
-                                         &alarmack_data->eventTimeStamp.value.dateTime) > 0) {
-                        *error_code = ERROR_CODE_INVALID_TIME_STAMP;
-                        return -1;
-                    }
+            /* FIXME: Send ack notification */
+            acked_transitions[TRANSITION_TO_OFFNORMAL].bIsAcked = true;
+            analog_input_set_acked_transitions(*object, acked_transitions);
+            break;
 
-                    /* FIXME: Send ack notification */
-                    acked_transitions[TRANSITION_TO_NORMAL].bIsAcked = true;
-                    object->write.acked_transitions(object->instance, acked_transitions);
+        case EVENT_STATE_FAULT:
+            if (alarmack_data->eventTimeStamp.tag != TIME_STAMP_DATETIME) {
+                *error_code = ERROR_CODE_INVALID_TIME_STAMP;
+                return -1;
+            }
+            if (datetime_compare(&acked_transitions[TRANSITION_TO_FAULT].Time_Stamp,
+                                 &alarmack_data->eventTimeStamp.value.dateTime) > 0) {
+                *error_code = ERROR_CODE_INVALID_TIME_STAMP;
+                return -1;
+            }
 
-                    break;
+            /* FIXME: Send ack notification */
+            acked_transitions[TRANSITION_TO_FAULT].bIsAcked = true;
+            analog_input_set_acked_transitions(*object, acked_transitions);
+            break;
 
-                default:
-                    return -3;
+        case EVENT_STATE_NORMAL:
+            if (alarmack_data->eventTimeStamp.tag != TIME_STAMP_DATETIME) {
+                *error_code = ERROR_CODE_INVALID_TIME_STAMP;
+                return -1;
+            }
+            if (datetime_compare(&acked_transitions[TRANSITION_TO_NORMAL].Time_Stamp,
+                                 &alarmack_data->eventTimeStamp.value.dateTime) > 0) {
+                *error_code = ERROR_CODE_INVALID_TIME_STAMP;
+                return -1;
             }
 
-            ACK_NOTIFICATION ack_notify_data;
-            object->read.ack_notify_data(object->instance, ack_notify_data);
+            /* FIXME: Send ack notification */
+            acked_transitions[TRANSITION_TO_NORMAL].bIsAcked = true;
+            analog_input_set_acked_transitions(*object, acked_transitions);
 
-            ack_notify_data.bSendAckNotify = true;
-            ack_notify_data.EventState = alarmack_data->eventStateAcked;
+            break;
 
-            object->write.ack_notify_data(object->instance, ack_notify_data);
+        default:
+            return -3;
+    }
 
-            found = true;
+    ACK_NOTIFICATION ack_notify_data;
+    ack_notify_data = *object->ai_irp->ack_notify_data;
 
-            return 1;
-        }
-    }
+    ack_notify_data.bSendAckNotify = true;
+    ack_notify_data.EventState = alarmack_data->eventStateAcked;
 
-    if (!found) {
-        *error_code = ERROR_CODE_UNKNOWN_OBJECT;
-        return -2;
-    }
+    *object->ai_irp->ack_notify_data = ack_notify_data;
+
+    return 1;
 }
 
 int analog_input_alarm_summary(unsigned index, BACNET_GET_ALARM_SUMMARY_DATA *getalarm_data) {
 
-    uint32_t last_analog_input_id = 0;
-    for (auto &object : container.getDeviceObject()->objects) {
-        if (object->type == OBJECT_ANALOG_INPUT) {
-            if (last_analog_input_id < object->instance)
-                last_analog_input_id = object->instance;
-        }
-    }
-
-    if (index > last_analog_input_id)
+    /* index is the position in the active alarm set, not the object instance */
+    auto object = container.getActiveAlarm(OBJECT_ANALOG_INPUT, index);
+    if (object == nullptr)
         return -1;
 
-    for (auto &object : container.getDeviceObject()->objects) {
-        if (object->type == OBJECT_ANALOG_INPUT && object->instance == index) {
-
-            uint8_t event_state, notify_type;
-            object->read.event_state(object->instance, &event_state);
-            object->read.notify_type(object->instance, &notify_type);
-
-            std::vector<ACKED_INFO> acked_transitions;
-            acked_transitions.reserve(MAX_BACNET_EVENT_TRANSITION);
-            object->read.acked_transitions(object->instance, acked_transitions);
-
-            /* Event_State is not equal to NORMAL  and
-               Notify_Type property value is ALARM */
-            if ((static_cast<BACNET_EVENT_STATE>(event_state) != EVENT_STATE_NORMAL) &&
-                (static_cast<BACNET_NOTIFY_TYPE>(notify_type) == NOTIFY_ALARM)) {
-                /* Object Identifier */
-                getalarm_data->objectIdentifier.type = OBJECT_ANALOG_INPUT;
-                getalarm_data->objectIdentifier.instance = object->instance;
-                /* Alarm State */
-                getalarm_data->alarmState = static_cast<BACNET_EVENT_STATE>(event_state);
-                /* Acknowledged Transitions */
-                bitstring_init(&getalarm_data->acknowledgedTransitions);
-                bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
-                                  TRANSITION_TO_OFFNORMAL,
-                                  acked_transitions[TRANSITION_TO_OFFNORMAL].bIsAcked);
-                bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
-                                  TRANSITION_TO_FAULT,
-                                  acked_transitions[TRANSITION_TO_FAULT].bIsAcked);
-                bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
-                                  TRANSITION_TO_NORMAL,
-                                  acked_transitions[TRANSITION_TO_NORMAL].bIsAcked);
-
-                return 1; /* active alarm */
-            } else
-                return 0; /* no active alarm at this index */
-        }
-    }
+    uint8_t event_state, notify_type;
+    event_state = object->ai_irp->event_state;
+    notify_type = object->ai_irp->notify_type;
+
+    std::vector<ACKED_INFO> acked_transitions;
+    acked_transitions.reserve(MAX_BACNET_EVENT_TRANSITION);
+    acked_transitions = object->ai_irp->acked_transitions;
+
+    /* Event_State is not equal to NORMAL  and
+       Notify_Type property value is ALARM */
+    if ((static_cast<BACNET_EVENT_STATE>(event_state) != EVENT_STATE_NORMAL) &&
+        (static_cast<BACNET_NOTIFY_TYPE>(notify_type) == NOTIFY_ALARM)) {
+        /* Object Identifier */
+        getalarm_data->objectIdentifier.type = OBJECT_ANALOG_INPUT;
+        getalarm_data->objectIdentifier.instance = object->instance;
+        /* Alarm State */
+        getalarm_data->alarmState = static_cast<BACNET_EVENT_STATE>(event_state);
+        /* Acknowledged Transitions */
+        bitstring_init(&getalarm_data->acknowledgedTransitions);
+        bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
+                          TRANSITION_TO_OFFNORMAL,
+                          acked_transitions[TRANSITION_TO_OFFNORMAL].bIsAcked);
+        bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
+                          TRANSITION_TO_FAULT,
+                          acked_transitions[TRANSITION_TO_FAULT].bIsAcked);
+        bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
+                          TRANSITION_TO_NORMAL,
+                          acked_transitions[TRANSITION_TO_NORMAL].bIsAcked);
+
+        return 1; /* active alarm */
+    } else
+        return 0; /* no active alarm at this index */
 }
 
 int analog_input_event_information(unsigned index, BACNET_GET_EVENT_INFORMATION_DATA *getevent_data) {
 
-    uint32_t last_analog_input_id = 0;
-    for (auto &object : container.getDeviceObject()->objects) {
-        if (object->type == OBJECT_ANALOG_INPUT) {
-            if (last_analog_input_id < object->instance)
-                last_analog_input_id = object->instance;
-        }
-    }
-
-    if (index > last_analog_input_id)
+    /* index is the position in the active alarm set, not the object instance */
+    auto object = container.getActiveAlarm(OBJECT_ANALOG_INPUT, index);
+    if (object == nullptr)
         return -1;
 
-    for (auto &object : container.getDeviceObject()->objects) {
-        if (object->type == OBJECT_ANALOG_INPUT && object->instance == index) {
-
-            bool event_detection_enable;
-#if !defined(CERTIFICATION_SOFTWARE)
-            event_detection_enable = object->ai_irp.event_detection_enable;
-#else
-            object->read.event_detection_enable(object->instance, &event_detection_enable);
-#endif
-
-            if (event_detection_enable) {
-                bool IsNotAckedTransitions;
-                bool IsActiveEvent;
-                int i;
-                uint32_t notification_class;
-                uint8_t event_state, notify_type, event_enable;
-                object->read.event_state(object->instance, &event_state);
-                object->read.notify_type(object->instance, &notify_type);
-                object->read.event_enable(object->instance, &event_enable);
-                object->read.notification_class(object->instance, &notification_class);
-
-                std::vector<ACKED_INFO> acked_transitions;
-                acked_transitions.reserve(MAX_BACNET_EVENT_TRANSITION);
-                object->read.acked_transitions(object->instance, acked_transitions);
-
-                std::vector<BACNET_DATE_TIME> event_time_stamps;
-                event_time_stamps.reserve(MAX_BACNET_EVENT_TRANSITION);
-                object->read.event_time_stamps(object->instance, event_time_stamps);
-
-                /* Event_State not equal to NORMAL */
-                IsActiveEvent = (static_cast<BACNET_EVENT_STATE>(event_state) != EVENT_STATE_NORMAL);
-
-                /* Acked_Transitions property, which has at least one of the bits
-                   (TO-OFFNORMAL, TO-FAULT, TONORMAL) set to FALSE. */
-                IsNotAckedTransitions = (acked_transitions[TRANSITION_TO_OFFNORMAL].bIsAcked == false) |
-                                        (acked_transitions[TRANSITION_TO_FAULT].bIsAcked == false) |
-                                        (acked_transitions[TRANSITION_TO_NORMAL].bIsAcked == false);
-
-                if ((IsActiveEvent) || (IsNotAckedTransitions)) {
-                    /* Object Identifier */
-                    getevent_data->objectIdentifier.type = OBJECT_ANALOG_INPUT;
-                    getevent_data->objectIdentifier.instance = object->instance;
-                    /* Event State */
-                    getevent_data->eventState = static_cast<BACNET_EVENT_STATE>(event_state);
-                    /* Acknowledged Transitions */
-                    bitstring_init(&getevent_data->acknowledgedTransitions);
-                    bitstring_set_bit(&getevent_data->acknowledgedTransitions,
-                                      TRANSITION_TO_OFFNORMAL,
-                                      acked_transitions[TRANSITION_TO_OFFNORMAL].bIsAcked);
-                    bitstring_set_bit(&getevent_data->acknowledgedTransitions,
-                                      TRANSITION_TO_FAULT,
-                                      acked_transitions[TRANSITION_TO_FAULT].bIsAcked);
-                    bitstring_set_bit(&getevent_data->acknowledgedTransitions,
-                                      TRANSITION_TO_NORMAL,
-                                      acked_transitions[TRANSITION_TO_NORMAL].bIsAcked);
-                    /* Event Time Stamps */
-                    for (i = 0; i < 3; i++) {
-                        getevent_data->eventTimeStamps[i].tag = TIME_STAMP_DATETIME;
-                        getevent_data->eventTimeStamps[i].value.dateTime = event_time_stamps[i];
-                    }
-                    /* Notify Type */
-                    getevent_data->notifyType = static_cast<BACNET_NOTIFY_TYPE>(notify_type);
-                    /* Event Enable */
-                    bitstring_init(&getevent_data->eventEnable);
-                    bitstring_set_bit(&getevent_data->eventEnable,
-                                      TRANSITION_TO_OFFNORMAL,
-                                      (event_enable & EVENT_ENABLE_TO_OFFNORMAL) ? true : false);
-                    bitstring_set_bit(&getevent_data->eventEnable,
-                                      TRANSITION_TO_FAULT,
-                                      (event_enable & EVENT_ENABLE_TO_FAULT) ? true : false);
-                    bitstring_set_bit(&getevent_data->eventEnable,
-                                      TRANSITION_TO_NORMAL,
-                                      (event_enable & EVENT_ENABLE_TO_NORMAL) ? true : false);
-                    /* Event Priorities */
-                    notificationClassGetPriorities(notification_class, getevent_data->eventPriorities);
-
-                    return 1; /* active event */
-                } else
-                    return 0; /* no active event at this index */
+    if (analog_input_event_detection_enable(*object, object->instance)) {
+        bool IsNotAckedTransitions;
+        bool IsActiveEvent;
+        int i;
+        uint32_t notification_class;
+        uint8_t event_state, notify_type, event_enable;
+        event_state = object->ai_irp->event_state;
+        notify_type = object->ai_irp->notify_type;
+        event_enable = object->ai_irp->event_enable;
+        notification_class = object->ai_irp->notification_class;
+
+        std::vector<ACKED_INFO> acked_transitions;
+        acked_transitions.reserve(MAX_BACNET_EVENT_TRANSITION);
+        acked_transitions = object->ai_irp->acked_transitions;
+
+        std::vector<BACNET_DATE_TIME> event_time_stamps;
+        event_time_stamps.reserve(MAX_BACNET_EVENT_TRANSITION);
+        event_time_stamps = object->ai_irp->event_time_stamps;
+
+        /* Event_State not equal to NORMAL */
+        IsActiveEvent = (static_cast<BACNET_EVENT_STATE>(event_state) != EVENT_STATE_NORMAL);
+
+        /* Acked_Transitions property, which has at least one of the bits
+           (TO-OFFNORMAL, TO-FAULT, TONORMAL) set to FALSE. */
+        IsNotAckedTransitions = (acked_transitions[TRANSITION_TO_OFFNORMAL].bIsAcked == false) |
+                                (acked_transitions[TRANSITION_TO_FAULT].bIsAcked == false) |
+                                (acked_transitions[TRANSITION_TO_NORMAL].bIsAcked == false);
+
+        if ((IsActiveEvent) || (IsNotAckedTransitions)) {
+            /* Object Identifier */
+            getevent_data->objectIdentifier.type = OBJECT_ANALOG_INPUT;
+            getevent_data->objectIdentifier.instance = object->instance;
+            /* Event State */
+            getevent_data->eventState = static_cast<BACNET_EVENT_STATE>(event_state);
+            /* Acknowledged Transitions */
+            bitstring_init(&getevent_data->acknowledgedTransitions);
+            bitstring_set_bit(&getevent_data->acknowledgedTransitions,
+                              TRANSITION_TO_OFFNORMAL,
+                              acked_transitions[TRANSITION_TO_OFFNORMAL].bIsAcked);
+            bitstring_set_bit(&getevent_data->acknowledgedTransitions,
+                              TRANSITION_TO_FAULT,
+                              acked_transitions[TRANSITION_TO_FAULT].bIsAcked);
+            bitstring_set_bit(&getevent_data->acknowledgedTransitions,
+                              TRANSITION_TO_NORMAL,
+                              acked_transitions[TRANSITION_TO_NORMAL].bIsAcked);
+            /* Event Time Stamps */
+            for (i = 0; i < 3; i++) {
+                getevent_data->eventTimeStamps[i].tag = TIME_STAMP_DATETIME;
+                getevent_data->eventTimeStamps[i].value.dateTime = event_time_stamps[i];
             }
-        }
+            /* Notify Type */
+            getevent_data->notifyType = static_cast<BACNET_NOTIFY_TYPE>(notify_type);
+            /* Event Enable */
+            bitstring_init(&getevent_data->eventEnable);
+            bitstring_set_bit(&getevent_data->eventEnable,
+                              TRANSITION_TO_OFFNORMAL,
+                              (event_enable & EVENT_ENABLE_TO_OFFNORMAL) ? true : false);
+            bitstring_set_bit(&getevent_data->eventEnable,
+                              TRANSITION_TO_FAULT,
+                              (event_enable & EVENT_ENABLE_TO_FAULT) ? true : false);
+            bitstring_set_bit(&getevent_data->eventEnable,
+                              TRANSITION_TO_NORMAL,
+                              (event_enable & EVENT_ENABLE_TO_NORMAL) ? true : false);
+            /* Event Priorities */
+            notificationClassGetPriorities(notification_class, getevent_data->eventPriorities);
+
+            return 1; /* active event */
+        } else
+            return 0; /* no active event at this index */
     }
+
+    return 0;
 }
 
 #endif /* defined(INTRINSIC_REPORTING) */
@@ -1181,62 +1247,77 @@ analog_input_intrinsic_rpm_property_list(const int **pRequired, const int **pOpt
         *pProprietary = AI_Properties_Proprietary;
 }
 
+#if defined(INTRINSIC_REPORTING)
+static void analog_input_intrinsic_rpm_range_property_list(const int **pRequired,
+                                                           const int **pOptional,
+                                                           const int **pProprietary) {
+    if (pRequired)
+        *pRequired = AI_Properties_Required;
+
+    if (pOptional)
+        *pOptional = AI_Range_Properties_Optional;
+
+    if (pProprietary)
+        *pProprietary = AI_Properties_Proprietary;
+}
+#endif
+
 #if defined(INTRINSIC_REPORTING)
 
 static void analog_input_intrinsic_init(BACnetObject &object) {
 
     for (int i = 0; i < MAX_BACNET_EVENT_TRANSITION; i++) {
-        object.ai_irp.acked_transitions.push_back(Acked_info({.bIsAcked = true, BACNET_DATE_TIME()}));
-        object.ai_irp.event_time_stamps.push_back(BACNET_DATE_TIME());
-        datetime_wildcard_set(&object.ai_irp.event_time_stamps[i]);
+        object.ai_irp->acked_transitions.push_back(Acked_info({.bIsAcked = true, BACNET_DATE_TIME()}));
+        object.ai_irp->event_time_stamps.push_back(BACNET_DATE_TIME());
+        datetime_wildcard_set(&object.ai_irp->event_time_stamps[i]);
     }
 
 #if !defined(CERTIFICATION_SOFTWARE)
-    if (object.ai_irp.event_detection_enable) {
+    if (object.ai_irp->event_detection_enable) {
         BACNET_BIT_STRING limit_enable_bit_string_bit_string;
         bitstring_init(&limit_enable_bit_string_bit_string);
         bitstring_set_bit(&limit_enable_bit_string_bit_string, 0, 0);
         bitstring_set_bit(&limit_enable_bit_string_bit_string, 1, 1);
-        object.ai_irp.limit_enable = *limit_enable_bit_string_bit_string.value;
+        object.ai_irp->limit_enable = *limit_enable_bit_string_bit_string.value;
 
-        object.ai_irp.event_enable |= EVENT_ENABLE_TO_OFFNORMAL;
-//        object.ai_irp.event_enable |= EVENT_ENABLE_TO_NORMAL;
+        object.ai_irp->event_enable |= EVENT_ENABLE_TO_OFFNORMAL;
+//        object.ai_irp->event_enable |= EVENT_ENABLE_TO_NORMAL;
 
-        object.ai_irp.deadband = -1.0f;
+        object.ai_irp->deadband = -1.0f;
     } else {
-        object.ai_irp.limit_enable = 0;
-        object.ai_irp.event_enable = 0;
-        object.ai_irp.deadband = 0.0f;
+        object.ai_irp->limit_enable = 0;
+        object.ai_irp->event_enable = 0;
+        object.ai_irp->deadband = 0.0f;
     }
 
-    object.ai_irp.high_limit = 0.0f;
-    object.ai_irp.low_limit = 0.0f;
-    object.ai_irp.time_delay = 0;
-    object.ai_irp.notification_class = BACNET_MAX_INSTANCE;
-    object.ai_irp.notify_type = 0;
+    object.ai_irp->high_limit = 0.0f;
+    object.ai_irp->low_limit = 0.0f;
+    object.ai_irp->time_delay = 0;
+    object.ai_irp->notification_class = BACNET_MAX_INSTANCE;
+    object.ai_irp->notify_type = 0;
 #else
     BACNET_BIT_STRING limit_enable_bit_string_bit_string;
     bitstring_init(&limit_enable_bit_string_bit_string);
     bitstring_set_bit(&limit_enable_bit_string_bit_string, 0, 1);
     bitstring_set_bit(&limit_enable_bit_string_bit_string, 1, 1);
-    object.ai_irp.limit_enable = *limit_enable_bit_string_bit_string.value;
+    object.ai_irp->limit_enable = *limit_enable_bit_string_bit_string.value;
 
-    object.ai_irp.event_enable |= EVENT_ENABLE_TO_OFFNORMAL;
-    object.ai_irp.event_enable |= EVENT_ENABLE_TO_NORMAL;
+    object.ai_irp->event_enable |= EVENT_ENABLE_TO_OFFNORMAL;
+    object.ai_irp->event_enable |= EVENT_ENABLE_TO_NORMAL;
 
-    object.ai_irp.high_limit = 100.0f; // TODO: For testing purposes
-    object.ai_irp.low_limit = 20.0f;   // TODO: For testing purposes
-    object.ai_irp.time_delay = 0;
-    object.ai_irp.notification_class = 14;
-    object.ai_irp.deadband = 0.0f;
-    object.ai_irp.notify_type = 0;
+    object.ai_irp->high_limit = 100.0f; // TODO: For testing purposes
+    object.ai_irp->low_limit = 20.0f;   // TODO: For testing purposes
+    object.ai_irp->time_delay = 0;
+    object.ai_irp->notification_class = 14;
+    object.ai_irp->deadband = 0.0f;
+    object.ai_irp->notify_type = 0;
 #endif
 
-    object.ai_irp.remaining_time_delay = 0;
-    object.ai_irp.event_state = static_cast<uint8_t>(EVENT_STATE_NORMAL);
-    object.ai_irp.last_offnormal_event_state = static_cast<uint8_t>(EVENT_STATE_NORMAL);
+    object.ai_irp->remaining_time_delay = 0;
+    object.ai_irp->event_state = static_cast<uint8_t>(EVENT_STATE_NORMAL);
+    object.ai_irp->last_offnormal_event_state = static_cast<uint8_t>(EVENT_STATE_NORMAL);
 
-    object.ai_irp.ack_notify_data =
+    object.ai_irp->ack_notify_data =
             std::make_unique<Ack_Notification>(
                     Ack_Notification({.bSendAckNotify = false, static_cast<uint8_t>(EVENT_STATE_NORMAL)}));
 
@@ -1250,6 +1331,35 @@ static void analog_input_intrinsic_init(BACnetObject &object) {
 
 #endif
 
+static bool analog_input_intrinsic_encode_value_list(const BACnetObject &object,
+                                                     uint32_t object_instance,
+                                                     BACNET_PROPERTY_VALUE *value_list) {
+    float present_value = 0.0f;
+    bool in_alarm = false;
+    bool out_of_service = false;
+
+    if ((value_list == nullptr) || (value_list->next == nullptr))
+        return false;
+
+    if (object.present_value.enabled)
+        present_value = object.present_value.load<float>();
+    else
+        object.read.present_value_real(object_instance, &present_value);
+    value_list->value.tag = BACNET_APPLICATION_TAG_REAL;
+    value_list->value.type.Real = present_value;
+
+#if defined(INTRINSIC_REPORTING)
+    uint8_t event_state = EVENT_STATE_NORMAL;
+    if (object.ai_irp)
+        event_state = object.ai_irp->event_state;
+    in_alarm = event_state != EVENT_STATE_NORMAL;
+#endif
+    if (object.read.out_of_service)
+        object.read.out_of_service(object_instance, &out_of_service);
+
+    return encode_cov_value_list(value_list, in_alarm, out_of_service);
+}
+
 void bacnet::init_analog_input_intrinsic_object_handlers(ObjectTypeHandler &handler) {
 #if defined(INTRINSIC_REPORTING)
     handler.init = analog_input_intrinsic_init;
@@ -1263,14 +1373,13 @@ void bacnet::init_analog_input_intrinsic_object_handlers(ObjectTypeHandler &hand
     handler.write_property = analog_input_intrinsic_write_property;
     handler.rpm_property_list = analog_input_intrinsic_rpm_property_list;
 #if defined(INTRINSIC_REPORTING)
+    handler.rpm_range_property_list = analog_input_intrinsic_rpm_range_property_list;
     handler.intrinsic_reporting = analog_input_intrinsic_reporting;
 #else
-    handler.intrinsic_reporting = [](const BACnetObject&) {};
+    handler.intrinsic_reporting = [](BACnetObject&) {};
 #endif
 
-    handler.count = []() { return 0; };
+    handler.value_list = analog_input_intrinsic_encode_value_list;
 
-    // handler.cov = [](const BACnetObject&) { return true; };
-    // handler.cov_clear = [](const BACnetObject&) { return; };
-    // handler.value_list = [](const BACnetObject&, BACNET_PROPERTY_VALUE*) { return true; };
+    handler.count = []() { return 0; };
 }
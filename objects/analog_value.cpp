@@ -25,6 +25,7 @@
  *********************************************************************/
 
 #include "analog_value.hpp"
+#include "cov_value_list.hpp"
 #include "custom_bacnet_config.h"
 //#include "datetime.h"
 #include "bacnet.hpp"
@@ -49,6 +50,7 @@ static const int AV_Properties_Optional[] = {PROP_DESCRIPTION,
     PROP_MIN_PRES_VALUE,
     PROP_MAX_PRES_VALUE,
     PROP_RESOLUTION,
+    PROP_COV_INCREMENT,
     // PROP_PROPERTY_LIST
     -1};
 
@@ -87,7 +89,10 @@ static unsigned analog_value_read_property(const BACnetObject& object, BACNET_RE
 
     case PROP_PRESENT_VALUE: {
         float present_value = 0.0f;
-        object.read.present_value_real(rpdata->object_instance, &present_value);
+        if (object.present_value.enabled)
+            present_value = object.present_value.load<float>();
+        else
+            object.read.present_value_real(rpdata->object_instance, &present_value);
         apdu_len = encode_application_real(&apdu[0], present_value);
         break;
     }
@@ -113,6 +118,10 @@ static unsigned analog_value_read_property(const BACnetObject& object, BACNET_RE
         break;
     };
 
+    case PROP_COV_INCREMENT:
+        apdu_len = encode_application_real(&apdu[0], object.cov.increment);
+        break;
+
     case PROP_STATUS_FLAGS: {
         // TOOD: read from properties
         bool out_of_service = false;
@@ -232,10 +241,27 @@ static bool analog_value_write_property(BACnetObject& object, BACNET_WRITE_PROPE
 
                 return status;
             }
+
+            // the application accepted the value, serve it to readers right away
+            if (object.present_value.enabled)
+                object.present_value.store(value.type.Real);
         }
 
         break;
     }
+    case PROP_COV_INCREMENT: {
+        status = WPValidateArgType(&value, BACNET_APPLICATION_TAG_REAL, &wp_data->error_class, &wp_data->error_code);
+        if (status) {
+            if (value.type.Real >= 0.0f) {
+                object.cov.increment = value.type.Real;
+            } else {
+                status = false;
+                wp_data->error_class = ERROR_CLASS_PROPERTY;
+                wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
+            }
+        }
+        break;
+    }
     case PROP_OUT_OF_SERVICE:
     case PROP_MIN_PRES_VALUE:
     case PROP_MAX_PRES_VALUE:
@@ -279,12 +305,35 @@ static void analog_value_rpm_property_list(const int** pRequired, const int** pO
         *pProprietary = AV_Properties_Proprietary;
 }
 
+static bool analog_value_encode_value_list(const BACnetObject& object,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE* value_list) {
+    bool out_of_service = false;
+
+    if ((value_list == nullptr) || (value_list->next == nullptr))
+        return false;
+
+    float present_value = 0.0f;
+    if (object.present_value.enabled)
+        present_value = object.present_value.load<float>();
+    else
+        object.read.present_value_real(object_instance, &present_value);
+    value_list->value.tag = BACNET_APPLICATION_TAG_REAL;
+    value_list->value.type.Real = present_value;
+
+    if (object.read.out_of_service)
+        object.read.out_of_service(object_instance, &out_of_service);
+
+    return encode_cov_value_list(value_list, false, out_of_service);
+}
+
 void bacnet::init_analog_value_object_handlers(ObjectTypeHandler& handler) {
     handler.read_property = analog_value_read_property;
     handler.write_property = analog_value_write_property;
     handler.rpm_property_list = analog_value_rpm_property_list;
+    handler.value_list = analog_value_encode_value_list;
 
-    handler.intrinsic_reporting = [](const BACnetObject&) {
+    handler.intrinsic_reporting = [](BACnetObject&) {
 
     };
 
@@ -24,6 +24,7 @@
  *********************************************************************/
 
 #include "bitstring_value.hpp"
+#include "cov_value_list.hpp"
 #include "custom_bacnet_config.h"
 //#include "datetime.h"
 #include "bacnet.hpp"
@@ -98,16 +99,14 @@ static unsigned bitstring_value_read_property(const BACnetObject& object, BACNET
 
                 object.read.bit_text(rpdata->object_instance, i, bit_text);
                 characterstring_init_ansi(&char_string, bit_text);
-                /* FIXME: this might go beyond MAX_APDU length! */
-                len = encode_application_character_string(&apdu[apdu_len], &char_string);
-                /* add it if we have room */
-                if ((apdu_len + len) < MAX_APDU) {
-                    apdu_len += len;
-                } else {
+                /* tag, length and character set take 3 bytes, check before writing */
+                if ((apdu_len + MAX_BIT_TEXT_LENGTH + 3) > (int)rpdata->application_data_len) {
                     rpdata->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
                     apdu_len = BACNET_STATUS_ABORT;
                     break;
                 }
+                len = encode_application_character_string(&apdu[apdu_len], &char_string);
+                apdu_len += len;
             }
         } else {
             if (rpdata->array_index <= max_bits) {
@@ -206,7 +205,7 @@ static bool bitstring_value_write_property(BACnetObject& object, BACNET_WRITE_PR
 
         if (status) {
             unsigned number_of_bits;
-            object.read.number_of_bits(object.instance, &number_of_bits);
+            object.read.number_of_bits(wp_data->object_instance, &number_of_bits);
             if (value.type.Bit_String.bits_used != number_of_bits) {
                 status = false;
 
@@ -268,12 +267,31 @@ static void bitstring_value_rpm_property_list(const int** pRequired, const int**
         *pProprietary = BSV_Properties_Proprietary;
 }
 
+static bool bitstring_value_encode_value_list(const BACnetObject& object,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE* value_list) {
+    bool out_of_service = false;
+
+    if ((value_list == nullptr) || (value_list->next == nullptr))
+        return false;
+
+    value_list->value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
+    bitstring_init(&value_list->value.type.Bit_String);
+    object.read.present_value_bitstring(object_instance, &value_list->value.type.Bit_String);
+
+    if (object.read.out_of_service)
+        object.read.out_of_service(object_instance, &out_of_service);
+
+    return encode_cov_value_list(value_list, false, out_of_service);
+}
+
 void bacnet::init_bitstring_value_object_handlers(ObjectTypeHandler& handler) {
     handler.read_property = bitstring_value_read_property;
     handler.write_property = bitstring_value_write_property;
     handler.rpm_property_list = bitstring_value_rpm_property_list;
+    handler.value_list = bitstring_value_encode_value_list;
 
-    handler.intrinsic_reporting = [](const BACnetObject&) {
+    handler.intrinsic_reporting = [](BACnetObject&) {
 
     };
 
@@ -9,8 +9,10 @@
 extern "C" {
 #endif /* __cplusplus */
 
-void Device_Objects_Property_List(BACNET_OBJECT_TYPE object_type, struct special_property_list_t* pPropertyList) {
-    container.getObjectsPropertyList(object_type, pPropertyList);
+void Device_Object_Property_List(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    struct special_property_list_t* pPropertyList) {
+    container.getObjectsPropertyList(object_type, object_instance, pPropertyList);
 }
 
 uint16_t Device_Vendor_Identifier(void) {
@@ -21,23 +23,23 @@ uint32_t Device_Object_Instance_Number(void) {
     return container.getInstanceNumber();
 }
 
-// bool Device_Encode_Value_List(BACNET_OBJECT_TYPE object_type,
-//     uint32_t object_instance,
-//     BACNET_PROPERTY_VALUE* value_list) {
-//     return container.deviceEncodeValueList(object_type, object_instance, value_list);
-// }
+bool Device_Encode_Value_List(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE* value_list) {
+    return container.deviceEncodeValueList(object_type, object_instance, value_list);
+}
 
-// bool Device_Value_List_Supported(BACNET_OBJECT_TYPE object_type) {
-//     return container.deviceValueListSupported(object_type);
-// }
+bool Device_Value_List_Supported(BACNET_OBJECT_TYPE object_type) {
+    return container.deviceValueListSupported(object_type);
+}
 
-// bool Device_COV(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
-//     return container.deviceCov(object_type, object_instance);
-// }
+bool Device_COV(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+    return container.deviceCov(object_type, object_instance);
+}
 
-// void Device_COV_Clear(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
-//     return container.deviceCovClear(object_type, object_instance);
-// }
+void Device_COV_Clear(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+    return container.deviceCovClear(object_type, object_instance);
+}
 
 int Device_Read_Property(BACNET_READ_PROPERTY_DATA* rp_data) {
     // printf("Device_Read_Property type: %d of id: %d\n", rp_data->object_type, rp_data->object_instance);
@@ -62,6 +64,32 @@ bool Device_Object_Name_Copy(BACNET_OBJECT_TYPE object_type,
     return container.copyObjectName(object_type, object_instance, object_name);
 }
 
+unsigned Device_Active_Alarm_Index(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+#if defined(INTRINSIC_REPORTING)
+    return container.getActiveAlarmIndex(object_type, object_instance);
+#else
+    return 0;
+#endif
+}
+
+bool Device_Batch_Read_Enabled(void) {
+    return container.hasBatchReadHandlers();
+}
+
+void Device_Batch_Read_Queue(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property) {
+    container.queueBatchRead(object_type, object_instance, object_property);
+}
+
+void Device_Batch_Read_Flush(void) {
+    container.flushBatchRead();
+}
+
+void Device_Batch_Read_Clear(void) {
+    container.clearBatchRead();
+}
+
 void Device_getCurrentDateTime(BACNET_DATE_TIME* DateTime) {
     return container.getCurrentDateTime(DateTime);
 }
@@ -51,40 +51,40 @@ bool Device_Object_Name_Copy(BACNET_OBJECT_TYPE object_type,
     uint32_t object_instance,
     BACNET_CHARACTER_STRING* object_name);
 
-// /** Looks up the requested Object, and fills the Property Value list.
-//  * If the Object or Property can't be found, returns false.
-//  * @ingroup ObjHelpers
-//  * @param [in] The object type to be looked up.
-//  * @param [in] The object instance number to be looked up.
-//  * @param [out] The value list
-//  * @return True if the object instance supports this feature
-//  *         and was encoded correctly
-//  */
-// bool Device_Encode_Value_List(BACNET_OBJECT_TYPE object_type,
-//     uint32_t object_instance,
-//     BACNET_PROPERTY_VALUE* value_list);
-
-// /** Looks up the requested Object to see if the functionality is supported.
-//  * @ingroup ObjHelpers
-//  * @param [in] The object type to be looked up.
-//  * @return True if the object instance supports this feature.
-//  */
-// bool Device_Value_List_Supported(BACNET_OBJECT_TYPE object_type);
-
-// /** Checks the COV flag in the requested Object
-//  * @ingroup ObjHelpers
-//  * @param [in] The object type to be looked up.
-//  * @param [in] The object instance to be looked up.
-//  * @return True if the COV flag is set
-//  */
-// bool Device_COV(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
-
-// /** Clears the COV flag in the requested Object
-//  * @ingroup ObjHelpers
-//  * @param [in] The object type to be looked up.
-//  * @param [in] The object instance to be looked up.
-//  */
-// void Device_COV_Clear(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+/** Looks up the requested Object, and fills the Property Value list.
+ * If the Object or Property can't be found, returns false.
+ * @ingroup ObjHelpers
+ * @param [in] The object type to be looked up.
+ * @param [in] The object instance number to be looked up.
+ * @param [out] The value list
+ * @return True if the object instance supports this feature
+ *         and was encoded correctly
+ */
+bool Device_Encode_Value_List(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE* value_list);
+
+/** Looks up the requested Object to see if the functionality is supported.
+ * @ingroup ObjHelpers
+ * @param [in] The object type to be looked up.
+ * @return True if the object instance supports this feature.
+ */
+bool Device_Value_List_Supported(BACNET_OBJECT_TYPE object_type);
+
+/** Checks whether the requested Object changed since its last COV notification
+ * @ingroup ObjHelpers
+ * @param [in] The object type to be looked up.
+ * @param [in] The object instance to be looked up.
+ * @return True if a COV notification is due
+ */
+bool Device_COV(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+
+/** Records the current values of the requested Object as notified
+ * @ingroup ObjHelpers
+ * @param [in] The object type to be looked up.
+ * @param [in] The object instance to be looked up.
+ */
+void Device_COV_Clear(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
 
 /**
  * @brief Check whether given object id is correct
@@ -97,12 +97,57 @@ bool Device_Object_Name_Copy(BACNET_OBJECT_TYPE object_type,
 bool Device_Valid_Object_Id(int object_type, uint32_t object_instance);
 
 /**
- * Get object property list.
+ * Get the position of the first active event of the given object type
+ * that follows object_instance, in object identifier order.
+ *
+ * Used by GetEventInformation to resume after the
+ * 'Last Received Object Identifier' without rescanning.
+ *
+ * @param object_type Object type
+ * @param object_instance Last received object instance
+ * @return Index to pass to the object type's event information function
+ */
+unsigned Device_Active_Alarm_Index(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+
+/**
+ * Check whether any object type has a batch read hook.
+ */
+bool Device_Batch_Read_Enabled(void);
+
+/**
+ * Queue a property that a ReadPropertyMultiple request is about to read,
+ * so object types with a batch read hook can read all of them in one call.
+ *
+ * @param object_type Object type
+ * @param object_instance Object instance
+ * @param object_property Property identifier
+ */
+void Device_Batch_Read_Queue(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property);
+
+/**
+ * Run the batch read hooks for all queued properties. Device_Read_Property()
+ * returns their results until Device_Batch_Read_Clear() is called.
+ */
+void Device_Batch_Read_Flush(void);
+
+/**
+ * Drop the queued properties and their batch read results.
+ */
+void Device_Batch_Read_Clear(void);
+
+/**
+ * Get object property list. The instances of an object range may have fewer properties than
+ * the other objects of their type.
  *
  * @param object_type Object type identifier
+ * @param object_instance Object instance
  * @param pPropertyList Property list
  */
-void Device_Objects_Property_List(BACNET_OBJECT_TYPE object_type, struct special_property_list_t* pPropertyList);
+void Device_Object_Property_List(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    struct special_property_list_t* pPropertyList);
 
 /**
  * Execute device read property service.
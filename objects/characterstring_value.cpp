@@ -27,6 +27,7 @@
 
 #include "bacnet.hpp"
 #include "characterstring_value.hpp"
+#include "cov_value_list.hpp"
 #include "custom_bacnet_config.h"
 #include "handlers.h"
 #include "rp.h"
@@ -224,12 +225,32 @@ characterstring_value_rpm_property_list(const int** pRequired, const int** pOpti
         *pProprietary = CVS_Properties_Proprietary;
 }
 
+static bool characterstring_value_encode_value_list(const BACnetObject& object,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE* value_list) {
+    bool out_of_service = false;
+
+    if ((value_list == nullptr) || (value_list->next == nullptr))
+        return false;
+
+    char present_value[MAX_CHARACTERSTRING_LENGTH] = "";
+    object.read.present_value_characterstring(object_instance, present_value);
+    value_list->value.tag = BACNET_APPLICATION_TAG_CHARACTER_STRING;
+    characterstring_init_ansi(&value_list->value.type.Character_String, present_value);
+
+    if (object.read.out_of_service)
+        object.read.out_of_service(object_instance, &out_of_service);
+
+    return encode_cov_value_list(value_list, false, out_of_service);
+}
+
 void bacnet::init_characterstring_value_object_handlers(ObjectTypeHandler& handler) {
     handler.read_property = characterstring_value_read_property;
     handler.write_property = characterstring_value_write_property;
     handler.rpm_property_list = characterstring_value_rpm_property_list;
+    handler.value_list = characterstring_value_encode_value_list;
 
-    handler.intrinsic_reporting = [](const BACnetObject&) {
+    handler.intrinsic_reporting = [](BACnetObject&) {
 
     };
 
@@ -19,6 +19,7 @@
 #include "c_wrapper.h"
 #include "characterstring_value.hpp"
 #include "container.hpp"
+#include "cov_value_list.hpp"
 #include "date_value.hpp"
 #include "device.hpp"
 #include "multi_state_input.hpp"
@@ -29,16 +30,12 @@
 #include "Poco/Crypto/Cipher.h"
 #include "Poco/Crypto/CipherFactory.h"
 #include "Poco/Crypto/CipherKey.h"
-#include "Poco/Crypto/CryptoStream.h"
 #include "Poco/Crypto/RSAKey.h"
 #include <Poco/File.h>
-#include <Poco/FileStream.h>
-#include <Poco/JSON/Array.h>
-#include <Poco/JSON/Parser.h>
-#include <Poco/Path.h>
-#include <Poco/TemporaryFile.h>
 
+#include <algorithm>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 
 using namespace bacnet;
@@ -47,10 +44,16 @@ using namespace Poco::Crypto;
 BACNET_TIME Local_Time; /* rely on OS, if there is one */
 BACNET_DATE Local_Date; /* rely on OS, if there is one */
 // bool Daylight_Savings_Status = false;
+// JSON recipient list encrypted with the device's RSA key, only read when there is no recipient list store yet
 const std::string pathToRecipientListFile = "/root/.bacnet_recipient_list.pkg";
+const std::string pathToRecipientListStore = "/root/.bacnet_recipient_list.bin";
 
 Container::Container()
-    : instance(0) {
+    : instance(0)
+    , deferred_indexing(false)
+    , object_pool(std::make_shared<ObjectPool>())
+    , persistent_state_loaded(false)
+    , recipient_list_store(pathToRecipientListStore) {
 }
 
 uint16_t Container::getVendorIdentifier() {
@@ -65,161 +68,340 @@ uint32_t Container::getInstanceNumber() {
 
 void Container::reset() {
     instance = 0;
+    object_index.clear();
+    object_type_index.clear();
+    object_type_count.clear();
+    object_name_index.clear();
+    object_names.clear();
+    object_ranges.clear();
+    range_cov.clear();
+    stored_recipient_lists.clear();
+    persistent_state_loaded = false;
+    notificationClassForgetRecipients();
+    // a recipient list change just before the reset must not get lost
+    recipient_list_store.flush();
+    batch_read_handlers.clear();
+    clearBatchRead();
+#if defined(INTRINSIC_REPORTING)
+    active_alarms.clear();
+#endif
     if ((bool)device) {
+        // the device lists itself among its objects
+        device->objects.clear();
         device.reset();
     }
 }
 
-void Container::getObjectsPropertyList(BACNET_OBJECT_TYPE object_type, struct special_property_list_t* pPropertyList) {
+uint64_t Container::objectKey(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+    return (static_cast<uint64_t>(object_type) << 32) | object_instance;
+}
+
+uint64_t Container::propertyKey(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID property) {
+    // 10 bit type, 22 bit instance, property identifiers are below 2^32
+    return (static_cast<uint64_t>(object_type) << 54) | (static_cast<uint64_t>(property) << 22) |
+           (object_instance & BACNET_MAX_INSTANCE);
+}
+
+void Container::registerObject(const std::shared_ptr<BACnetObject>& object) {
+    device->objects.push_back(object);
+
+    // addObjects() indexes all of its objects at once when it is done
+    if (deferred_indexing)
+        return;
+
+    if (object->type != OBJECT_DEVICE)
+        object_index[objectKey(object->type, object->instance)] = object.get();
+
+    object_type_index.emplace(object->type, object.get());
+    object_type_count[object->type]++;
+
+    indexObjectName(object.get());
+
+#if defined(INTRINSIC_REPORTING)
+    // an object can be registered in an alarm state already
+    if (object->ai_irp)
+        updateActiveAlarm(object.get());
+#endif
+
+    // the device lists the supported object types
+    device->encoded_properties.stale = true;
+}
+
+std::shared_ptr<BACnetObject> Container::makeObject() {
+    return std::allocate_shared<BACnetObject>(ObjectPoolAllocator<BACnetObject>(object_pool));
+}
+
+const ObjectTypeHandler* Container::typeHandler(BACNET_OBJECT_TYPE object_type,
+    void (*init_handlers)(ObjectTypeHandler&)) {
+    auto& handler = type_handlers[object_type];
+    if (!handler) {
+        handler.reset(new ObjectTypeHandler());
+        init_handlers(*handler);
+        handler->count = [this, object_type]() -> unsigned { return getObjectCount(object_type); };
+    }
+
+    return handler.get();
+}
+
+void Container::indexObjectName(BACnetObject* object) {
+    char object_name[MAX_OBJECT_NAME_LENGTH] = "";
+    object->read.object_name(object->type == OBJECT_DEVICE ? object->read.object_identifier() : object->instance,
+        object_name);
+
+    unindexObjectName(object);
+
+    // object names should be unique within a device, if not the first registered object keeps the name
+    object_name_index.emplace(object_name, object);
+    object_names[object] = object_name;
+}
+
+void Container::unindexObjectName(const BACnetObject* object) {
+    auto name = object_names.find(object);
+    if (name == object_names.end())
+        return;
+
+    std::string previous = std::move(name->second);
+    object_names.erase(name);
+
+    auto it = object_name_index.find(previous);
+    if (it == object_name_index.end() || it->second != object)
+        return;
+
+    // hand the entry to the next registered object that still has the same name
+    object_name_index.erase(it);
+    for (const auto& other : device->objects) {
+        auto other_name = object_names.find(other.get());
+        if (other_name != object_names.end() && other_name->second == previous) {
+            object_name_index.emplace(previous, other.get());
+            break;
+        }
+    }
+}
+
+void Container::objectNameChanged(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+    auto object = findObject(object_type, object_instance);
+    if (object != nullptr && object->range_count == 0)
+        indexObjectName(object);
+}
+
+BACnetObject* Container::findObject(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+    if (!(bool)device)
+        return nullptr;
+
+    if (object_type == OBJECT_DEVICE)
+        return device->read.object_identifier() == object_instance ? device.get() : nullptr;
+
+    auto it = object_index.find(objectKey(object_type, object_instance));
+    if (it == object_index.end())
+        return findRangeObject(object_type, object_instance);
+
+    return it->second;
+}
+
+unsigned Container::getObjectCount(BACNET_OBJECT_TYPE object_type) {
+    auto it = object_type_count.find(object_type);
+    return it == object_type_count.end() ? 0 : it->second;
+}
+
+void Container::getObjectsPropertyList(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    struct special_property_list_t* pPropertyList) {
     pPropertyList->Required.pList = nullptr;
     pPropertyList->Required.count = 0;
     pPropertyList->Optional.pList = nullptr;
     pPropertyList->Optional.count = 0;
     pPropertyList->Proprietary.pList = nullptr;
     pPropertyList->Proprietary.count = 0;
-    for (auto& object : device->objects) {
-        if (object->type == object_type) {
-            if (object->handler.rpm_property_list) {
-                object->handler.rpm_property_list(&pPropertyList->Required.pList,
-                    &pPropertyList->Optional.pList,
-                    &pPropertyList->Proprietary.pList);
-
-                pPropertyList->Required.count =
-                    pPropertyList->Required.pList == nullptr ? 0 : property_list_count(pPropertyList->Required.pList);
-
-                pPropertyList->Optional.count =
-                    pPropertyList->Optional.pList == nullptr ? 0 : property_list_count(pPropertyList->Optional.pList);
-
-                pPropertyList->Proprietary.count = pPropertyList->Proprietary.pList == nullptr
-                    ? 0
-                    : property_list_count(pPropertyList->Proprietary.pList);
-            }
+
+    BACnetObject* object = findObject(object_type, object_instance);
+    if (object == nullptr) {
+        auto it = object_type_index.find(object_type);
+        if (it == object_type_index.end())
             return;
-        }
+        object = it->second;
+    }
+
+    const auto& property_list = object->range_count > 0 && object->handler->rpm_range_property_list
+        ? object->handler->rpm_range_property_list
+        : object->handler->rpm_property_list;
+    if (property_list) {
+        property_list(
+            &pPropertyList->Required.pList, &pPropertyList->Optional.pList, &pPropertyList->Proprietary.pList);
+
+        pPropertyList->Required.count =
+            pPropertyList->Required.pList == nullptr ? 0 : property_list_count(pPropertyList->Required.pList);
+
+        pPropertyList->Optional.count =
+            pPropertyList->Optional.pList == nullptr ? 0 : property_list_count(pPropertyList->Optional.pList);
+
+        pPropertyList->Proprietary.count =
+            pPropertyList->Proprietary.pList == nullptr ? 0 : property_list_count(pPropertyList->Proprietary.pList);
     }
 }
 
 bool Container::getValidObjectName(BACNET_CHARACTER_STRING* object_name1, int* object_type, uint32_t* object_instance) {
-    bool found = false;
-    uint32_t instance;
-    BACNET_CHARACTER_STRING object_name2;
-    char object_name[MAX_OBJECT_NAME_LENGTH] = "";
+    // object names are always registered as ANSI X3.4 strings
+    if (characterstring_encoding(object_name1) != CHARACTER_ANSI_X34)
+        return false;
 
-    for (const auto& object : device->objects) {
-        instance = object->instance;
-        object->read.object_name(instance, object_name);
-        characterstring_init_ansi(&object_name2, object_name);
-        if (characterstring_same(object_name1, &object_name2)) {
-            found = true;
-            *object_type = object->type;
-            *object_instance = object->read.object_identifier();
-        }
-    }
+    std::string name(characterstring_value(object_name1), characterstring_length(object_name1));
+    auto it = object_name_index.find(name);
+    if (it == object_name_index.end())
+        return findRangeObjectName(name, object_type, object_instance);
+
+    *object_type = it->second->type;
+    *object_instance = it->second->type == OBJECT_DEVICE ? it->second->read.object_identifier() : it->second->instance;
 
-    return found;
+    return true;
 }
 
 bool Container::getValidObjectId(int object_type, uint32_t object_instance) {
-    bool found = false;
-
-    for (const auto& object : device->objects) {
-        if (object_type == object->type && object_instance == object->instance) {
-            found = true;
-        }
-    }
-
-    return found;
+    return findObject(static_cast<BACNET_OBJECT_TYPE>(object_type), object_instance) != nullptr;
 }
 
 bool Container::copyObjectName(BACNET_OBJECT_TYPE object_type,
     uint32_t object_instance,
     BACNET_CHARACTER_STRING* object_name) {
-    bool found = false;
+    auto object = findObject(object_type, object_instance);
+    if (object == nullptr)
+        return false;
 
-    for (const auto& object : device->objects) {
-        if (object->type == object_type && object->read.object_identifier() == object_instance) {
-            static char _object_name[MAX_OBJECT_NAME_LENGTH] = "";
-            object->read.object_name(object_instance, _object_name);
-            characterstring_init_ansi(object_name, _object_name);
-            found = true;
-        }
+    static char _object_name[MAX_OBJECT_NAME_LENGTH] = "";
+    object->read.object_name(object_instance, _object_name);
+    characterstring_init_ansi(object_name, _object_name);
+
+    return true;
+}
+
+bool Container::deviceEncodeValueList(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE* value_list) {
+    auto object = findObject(object_type, object_instance);
+    if (object == nullptr || !object->handler->value_list)
+        return false;
+
+    return object->handler->value_list(*object, object_instance, value_list);
+}
+
+// Whether the Present_Value and Status_Flags of an object can only change with PresentValueStore::changes
+static bool covCounted(const BACnetObject* object) {
+    return object->range_count == 0 && object->present_value.enabled && !object->read.out_of_service;
+}
+
+bool Container::deviceCov(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+    BACNET_PROPERTY_VALUE value_list[2];
+
+    auto object = findObject(object_type, object_instance);
+    if (object == nullptr || !object->handler->value_list)
+        return false;
+
+    // a store backed object that was unchanged is still unchanged while its change counter stands still
+    CovState& cov = covState(object, object_instance);
+    bool counted = covCounted(object);
+    uint32_t changes = object->present_value.changes.load(std::memory_order_acquire);
+    if (counted && cov.unchanged && cov.unchanged_changes == changes &&
+        cov.unchanged_increment == object->cov.increment)
+        return false;
+
+    value_list[0].next = &value_list[1];
+    value_list[1].next = nullptr;
+    if (!object->handler->value_list(*object, object_instance, &value_list[0]))
+        return false;
+
+    bool changed = cov_value_list_changed(cov, object->cov.increment, &value_list[0]);
+    cov.unchanged = counted && !changed;
+    cov.unchanged_changes = changes;
+    cov.unchanged_increment = object->cov.increment;
+    return changed;
+}
+
+void Container::deviceCovClear(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+    BACNET_PROPERTY_VALUE value_list[2];
+
+    auto object = findObject(object_type, object_instance);
+    if (object == nullptr || !object->handler->value_list)
+        return;
+
+    // the values about to be notified become the reference for the next change
+    CovState& cov = covState(object, object_instance);
+    uint32_t changes = object->present_value.changes.load(std::memory_order_acquire);
+    value_list[0].next = &value_list[1];
+    value_list[1].next = nullptr;
+    if (object->handler->value_list(*object, object_instance, &value_list[0])) {
+        cov_value_list_store(cov, &value_list[0]);
+        cov.unchanged = covCounted(object);
+        cov.unchanged_changes = changes;
+        cov.unchanged_increment = object->cov.increment;
     }
+}
 
-    return found;
-}
-
-// bool Container::deviceEncodeValueList(BACNET_OBJECT_TYPE object_type,
-//     uint32_t object_instance,
-//     BACNET_PROPERTY_VALUE* value_list) {
-//     bool found = false; /* Ever the pessamist! */
-
-//     for (const auto& object : device->objects) {
-//         if (object_type == object->type && object_instance == object->instance) {
-//             if (object->handler.value_list) {
-//                 found = true;
-//                 object->handler.value_list(*object, value_list);
-//             }
-//         }
-//     }
-
-//     return found;
-// }
-
-// bool Container::deviceCov(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
-//     bool found = false; /* Ever the pessamist! */
-
-//     for (const auto& object : device->objects) {
-//         if (object->type == object_type && object->instance == object_instance) {
-//             if (object->handler.cov) {
-//                 found = true;
-//                 object->handler.cov(*object);
-//             }
-//         }
-//     }
-
-//     return found;
-// }
-
-// void Container::deviceCovClear(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
-//     for (const auto& object : device->objects) {
-//         if (object->type == object_type && object->instance == object_instance) {
-//             if (object->handler.cov_clear) {
-//                 object->handler.cov_clear(*object);
-//             }
-//         }
-//     }
-// }
-
-// bool Container::deviceValueListSupported(BACNET_OBJECT_TYPE object_type) {
-//     bool found = false; /* Ever the pessamist! */
-
-//     for (const auto& object : device->objects) {
-//         if (object->type == object_type) {
-//             if (object->handler.value_list) {
-//                 found = true;
-//             }
-//         }
-//     }
-
-//     return found;
-// }
+bool Container::deviceValueListSupported(BACNET_OBJECT_TYPE object_type) {
+    auto it = object_type_index.find(object_type);
+    if (it == object_type_index.end())
+        return false;
+
+    return (bool)it->second->handler->value_list;
+}
 
 #if defined(INTRINSIC_REPORTING)
 void Container::deviceLocalReporting(void) {
     for (const auto& object : device->objects) {
-        if (object->type == OBJECT_ANALOG_INPUT) {
+        // intrinsic reporting keeps state per object, which the instances of a range don't have
+        if (object->type == OBJECT_ANALOG_INPUT && object->range_count == 0) {
             bool event_detection_enable;
 #if !defined(CERTIFICATION_SOFTWARE)
-            event_detection_enable = object->ai_irp.event_detection_enable;
+            event_detection_enable = object->ai_irp->event_detection_enable;
 #else
             object->read.event_detection_enable(object->instance, &event_detection_enable);
 #endif
             if (event_detection_enable) {
-                object->handler.intrinsic_reporting(*object);
+                object->handler->intrinsic_reporting(*object);
             }
         }
     }
 }
+
+bool Container::activeAlarm(const BACnetObject* object) {
+    bool active = static_cast<BACNET_EVENT_STATE>(object->ai_irp->event_state) != EVENT_STATE_NORMAL;
+    for (const auto& acked_transition : object->ai_irp->acked_transitions) {
+        if (!acked_transition.bIsAcked)
+            active = true;
+    }
+    return active;
+}
+
+void Container::updateActiveAlarm(BACnetObject* object) {
+    bool active = activeAlarm(object);
+
+    auto key = objectKey(object->type, object->instance);
+    auto it = std::lower_bound(active_alarms.begin(), active_alarms.end(), key);
+    bool present = it != active_alarms.end() && *it == key;
+
+    if (active && !present)
+        active_alarms.insert(it, key);
+    else if (!active && present)
+        active_alarms.erase(it);
+}
+
+BACnetObject* Container::getActiveAlarm(BACNET_OBJECT_TYPE object_type, unsigned index) {
+    auto first = std::lower_bound(active_alarms.begin(), active_alarms.end(), objectKey(object_type, 0));
+    if (index >= static_cast<unsigned>(std::distance(first, active_alarms.end())))
+        return nullptr;
+
+    auto key = *(first + index);
+    if (static_cast<BACNET_OBJECT_TYPE>(key >> 32) != object_type)
+        return nullptr;
+
+    return findObject(object_type, static_cast<uint32_t>(key));
+}
+
+unsigned Container::getActiveAlarmIndex(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+    auto first = std::lower_bound(active_alarms.begin(), active_alarms.end(), objectKey(object_type, 0));
+    auto next = std::upper_bound(first, active_alarms.end(), objectKey(object_type, object_instance));
+    return static_cast<unsigned>(std::distance(first, next));
+}
 #endif
 
 static void Update_Current_Time(void) {
@@ -285,8 +467,123 @@ void Container::getCurrentDateTime(BACNET_DATE_TIME* DateTime) {
     DateTime->time = Local_Time;
 }
 
+// Properties whose value is fixed once the object has been added, see EncodedPropertyCache
+static bool isStaticProperty(BACNET_OBJECT_TYPE object_type, BACNET_PROPERTY_ID property) {
+    switch (property) {
+    case PROP_OBJECT_TYPE:
+    case PROP_UNITS:
+    case PROP_MIN_PRES_VALUE:
+    case PROP_MAX_PRES_VALUE:
+    case PROP_RESOLUTION:
+    case PROP_DEVICE_TYPE:
+    case PROP_VENDOR_NAME:
+    case PROP_VENDOR_IDENTIFIER:
+    case PROP_MODEL_NAME:
+    case PROP_FIRMWARE_REVISION:
+    case PROP_APPLICATION_SOFTWARE_VERSION:
+    case PROP_PROTOCOL_VERSION:
+    case PROP_PROTOCOL_REVISION:
+    case PROP_PROTOCOL_SERVICES_SUPPORTED:
+    case PROP_PROTOCOL_OBJECT_TYPES_SUPPORTED:
+    case PROP_MAX_APDU_LENGTH_ACCEPTED:
+    case PROP_SEGMENTATION_SUPPORTED:
+#if (BACNET_PROTOCOL_REVISION >= 14)
+    case PROP_PROPERTY_LIST:
+#endif
+        return true;
+    // the device identifier is writable and its description comes from an application callback
+    case PROP_OBJECT_IDENTIFIER:
+    case PROP_DESCRIPTION:
+        return object_type != OBJECT_DEVICE;
+    default:
+        return false;
+    }
+}
+
+int Container::readEncodedProperty(BACnetObject* object, BACNET_READ_PROPERTY_DATA* rp_data) {
+    EncodedPropertyCache& cache = object->encoded_properties;
+
+    if (cache.stale.exchange(false)) {
+        cache.entries.clear();
+        cache.arena.clear();
+    }
+
+    for (const auto& entry : cache.entries) {
+        if (entry.property == rp_data->object_property) {
+            if (entry.length > rp_data->application_data_len)
+                break;
+            memcpy(rp_data->application_data, &cache.arena[entry.offset], entry.length);
+            return entry.length;
+        }
+    }
+
+    return BACNET_STATUS_ERROR;
+}
+
+void Container::cacheEncodedProperty(BACnetObject* object, const BACNET_READ_PROPERTY_DATA* rp_data, int apdu_len) {
+    EncodedPropertyCache& cache = object->encoded_properties;
+
+    if (cache.arena.size() + apdu_len > UINT16_MAX)
+        return;
+
+    cache.entries.push_back({rp_data->object_property, (uint16_t)cache.arena.size(), (uint16_t)apdu_len});
+    cache.arena.insert(cache.arena.end(), rp_data->application_data, rp_data->application_data + apdu_len);
+}
+
+void Container::staticPropertiesChanged(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+    BACnetObject* object = findObject(object_type, object_instance);
+    if (object != nullptr)
+        object->encoded_properties.stale = true;
+}
+
+void Container::setBatchReadHandler(BACNET_OBJECT_TYPE object_type, object_batch_read_cb batch_read_cb) {
+    if (batch_read_cb)
+        batch_read_handlers[object_type] = batch_read_cb;
+    else
+        batch_read_handlers.erase(object_type);
+}
+
+bool Container::hasBatchReadHandlers() {
+    return !batch_read_handlers.empty();
+}
+
+void Container::queueBatchRead(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property) {
+    if (batch_read_handlers.find(object_type) == batch_read_handlers.end())
+        return;
+
+    if (findObject(object_type, object_instance) == nullptr)
+        return;
+
+    BatchReadItem item = {};
+    item.object_instance = object_instance;
+    item.object_property = object_property;
+    batch_read_items[object_type].push_back(item);
+}
+
+void Container::flushBatchRead() {
+    for (auto& items : batch_read_items) {
+        batch_read_handlers[items.first](items.second);
+
+        // the vectors are not touched again until clearBatchRead(), so pointers into them stay valid
+        for (const auto& item : items.second) {
+            if (item.found) {
+                batch_read_results.emplace(
+                    propertyKey((BACNET_OBJECT_TYPE)items.first, item.object_instance, item.object_property), &item);
+            }
+        }
+    }
+}
+
+void Container::clearBatchRead() {
+    batch_read_items.clear();
+    batch_read_results.clear();
+}
+
 int Container::readProperty(BACNET_READ_PROPERTY_DATA* rp_data) {
     int apdu_len = BACNET_STATUS_ERROR;
+    bool cacheable = false;
 
 #if (BACNET_PROTOCOL_REVISION >= 14)
     struct special_property_list_t property_list;
@@ -295,29 +592,50 @@ int Container::readProperty(BACNET_READ_PROPERTY_DATA* rp_data) {
     rp_data->error_class = ERROR_CLASS_OBJECT;
     rp_data->error_code = ERROR_CODE_UNKNOWN_OBJECT;
 
-    for (auto& object : device->objects) {
-        if (object->type == rp_data->object_type && object->read.object_identifier() == rp_data->object_instance) {
-            if (object->handler.read_property) {
-#if (BACNET_PROTOCOL_REVISION >= 14)
-                if ((int)rp_data->object_property == PROP_PROPERTY_LIST) {
-                    getObjectsPropertyList(rp_data->object_type, &property_list);
-                    apdu_len = property_list_encode(rp_data,
-                        property_list.Required.pList,
-                        property_list.Optional.pList,
-                        property_list.Proprietary.pList);
-                    return apdu_len;
-                } else
-#endif
-                {
-                    apdu_len = object->handler.read_property(*object.get(), rp_data);
-                    return apdu_len;
-                }
-            } else {
-                // warning, read_property not implemented
+    auto object = findObject(rp_data->object_type, rp_data->object_instance);
+    if (object == nullptr || !object->handler->read_property) {
+        // warning, read_property not implemented
+        return apdu_len;
+    }
+
+    if (!batch_read_results.empty() && rp_data->array_index == BACNET_ARRAY_ALL) {
+        auto it = batch_read_results.find(
+            propertyKey(rp_data->object_type, rp_data->object_instance, rp_data->object_property));
+        if (it != batch_read_results.end()) {
+            BACNET_APPLICATION_DATA_VALUE value = it->second->value;
+            // a value never encodes longer than it is held, plus its tag
+            uint8_t encoded[sizeof(BACNET_APPLICATION_DATA_VALUE) + 8];
+            int len = bacapp_encode_application_data(encoded, &value);
+            if (len > rp_data->application_data_len) {
+                rp_data->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
+                return BACNET_STATUS_ABORT;
             }
+            memcpy(rp_data->application_data, encoded, len);
+            return len;
         }
     }
 
+    // the encodings of an object range are shared by its instances, which differ in their identifier
+    cacheable = rp_data->array_index == BACNET_ARRAY_ALL && isStaticProperty(object->type, rp_data->object_property) &&
+        (object->range_count == 0 || rp_data->object_property != PROP_OBJECT_IDENTIFIER);
+    if (cacheable) {
+        apdu_len = readEncodedProperty(object, rp_data);
+        if (apdu_len != BACNET_STATUS_ERROR)
+            return apdu_len;
+    }
+
+#if (BACNET_PROTOCOL_REVISION >= 14)
+    if ((int)rp_data->object_property == PROP_PROPERTY_LIST) {
+        getObjectsPropertyList(rp_data->object_type, rp_data->object_instance, &property_list);
+        apdu_len = property_list_encode(
+            rp_data, property_list.Required.pList, property_list.Optional.pList, property_list.Proprietary.pList);
+    } else
+#endif
+        apdu_len = object->handler->read_property(*object, rp_data);
+
+    if (cacheable && apdu_len > 0)
+        cacheEncodedProperty(object, rp_data, apdu_len);
+
     return apdu_len;
 }
 
@@ -330,29 +648,27 @@ bool Container::writeProperty(BACNET_WRITE_PROPERTY_DATA* wp_data) {
     auto obj_instance = wp_data->object_instance;
     auto obj_type = wp_data->object_type;
 
-    for (auto& object : device->objects) {
-        if (object->type == obj_type && object->read.object_identifier() == obj_instance) {
-            if (object->handler.write_property) {
+    auto object = findObject(obj_type, obj_instance);
+    if (object == nullptr)
+        return (status);
+
+    if (object->handler->write_property) {
 #if (BACNET_PROTOCOL_REVISION >= 14)
-                if (wp_data->object_property == PROP_PROPERTY_LIST) {
-                    wp_data->error_class = ERROR_CLASS_PROPERTY;
-                    wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
-                    return (status);
-                } else
-#endif
-                {
-                    return object->handler.write_property(*object.get(), wp_data);
-                }
-            } else {
-                wp_data->error_class = ERROR_CLASS_PROPERTY;
-                wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
-                return (status);
-            }
+        if (wp_data->object_property == PROP_PROPERTY_LIST) {
+            wp_data->error_class = ERROR_CLASS_PROPERTY;
+            wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
+            return (status);
         }
+#endif
+        status = object->handler->write_property(*object, wp_data);
+        // e.g. a new device instance, encode the static properties again on the next read
+        if (status)
+            object->encoded_properties.stale = true;
+        return status;
     }
 
-    wp_data->error_class = ERROR_CLASS_OBJECT;
-    wp_data->error_code = ERROR_CODE_UNKNOWN_OBJECT;
+    wp_data->error_class = ERROR_CLASS_PROPERTY;
+    wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
 
     return (status);
 }
@@ -379,7 +695,7 @@ bool Container::addDeviceObject(read_object_name_cb object_name_cb,
         return false;
     }
 
-    device = std::make_shared<BACnetObject>();
+    device = makeObject();
 
     device->type = OBJECT_DEVICE;
     device->read.object_name = object_name_cb;
@@ -417,9 +733,9 @@ bool Container::addDeviceObject(read_object_name_cb object_name_cb,
         return true;
     };
 
-    init_device_object_handlers(device->handler);
+    device->handler = typeHandler(OBJECT_DEVICE, init_device_object_handlers);
 
-    device->objects.push_back(device);
+    registerObject(device);
 
     return true;
 }
@@ -444,27 +760,24 @@ bool Container::addAnalogInputObject(read_object_name_cb object_name_cb,
     if (!(bool)device)
         return false;
 
-    auto aii_obj = std::make_shared<BACnetObject>();
+    auto object = makeObject();
+    auto aii_obj = object.get();
 
     aii_obj->type = OBJECT_ANALOG_INPUT;
+    aii_obj->ai_irp.reset(new AiIntrinsicReportingParams());
     aii_obj->read.object_name = object_name_cb;
     aii_obj->instance = ++instance;
 
     // printf("Add: analog-input %d\n", aii_obj->instance);
-    aii_obj->read.object_identifier = [aii_obj]() { return aii_obj->instance; };
 
     aii_obj->read.present_value_real = present_value_cb;
+    aii_obj->present_value.enabled = !present_value_cb;
 
     aii_obj->read.units = [units](unsigned /*object_instance*/, BACNET_ENGINEERING_UNITS* _units) {
         *_units = units;
         return true;
     };
 
-    aii_obj->read.out_of_service = [](unsigned /*object_instance*/, bool* out_of_service) -> int {
-        *out_of_service = false;
-        return true;
-    };
-
     aii_obj->read.description = [description](unsigned /*object_instance*/, char* _description) -> int {
         strcpy(_description, description.c_str());
         return true;
@@ -489,181 +802,31 @@ bool Container::addAnalogInputObject(read_object_name_cb object_name_cb,
         *_resolution = resolution;
         return true;
     };
+    // changes below the resolution are noise, don't notify COV subscribers about them
+    aii_obj->cov.increment = resolution;
 
 #if defined(INTRINSIC_REPORTING)
 
 #if !defined(CERTIFICATION_SOFTWARE)
     // event detection enable
-    aii_obj->ai_irp.event_detection_enable = event_detection_enable;
-
-    aii_obj->read.event_detection_enable = [aii_obj](unsigned /*object_instance*/, bool* _event_detection_enable) {
-        *_event_detection_enable = aii_obj->ai_irp.event_detection_enable;
-        return true;
-    };
+    aii_obj->ai_irp->event_detection_enable = event_detection_enable;
 #else
     aii_obj->read.event_detection_enable = event_detection_enable_cb;
 #endif
 
-    aii_obj->write.event_detection_enable = [aii_obj](unsigned /*object_instance*/,
-                                                const bool _event_detection_enable) {
-        aii_obj->ai_irp.event_detection_enable = _event_detection_enable;
-        return true;
-    };
-    // event enable
-    aii_obj->read.event_enable = [aii_obj](unsigned /*object_instance*/, uint8_t* _event_enable) {
-        *_event_enable = aii_obj->ai_irp.event_enable;
-        return true;
-    };
-    aii_obj->write.event_enable = [aii_obj](unsigned /*object_instance*/, const uint8_t _event_enable) {
-        aii_obj->ai_irp.event_enable = _event_enable;
-        return true;
-    };
-    // time delay
-    aii_obj->read.time_delay = [aii_obj](unsigned /*object_instance*/, uint32_t* _time_delay) {
-        *_time_delay = aii_obj->ai_irp.time_delay;
-        return true;
-    };
-    aii_obj->write.time_delay = [aii_obj](unsigned /*object_instance*/, const uint32_t _time_delay) {
-        aii_obj->ai_irp.time_delay = _time_delay;
-        return true;
-    };
-    // notification class
-    aii_obj->read.notification_class = [aii_obj](unsigned /*object_instance*/, uint32_t* _notification_class) {
-        *_notification_class = aii_obj->ai_irp.notification_class;
-        return true;
-    };
-    aii_obj->write.notification_class = [aii_obj](unsigned /*object_instance*/, const uint32_t _notification_class) {
-        aii_obj->ai_irp.notification_class = _notification_class;
-        return true;
-    };
-    // high limit
-    aii_obj->read.high_limit = [aii_obj](unsigned /*object_instance*/, float* _high_limit) {
-        *_high_limit = aii_obj->ai_irp.high_limit;
-        return true;
-    };
-    aii_obj->write.high_limit = [aii_obj](unsigned /*object_instance*/, const float _high_limit) {
-        aii_obj->ai_irp.high_limit = _high_limit;
-        return true;
-    };
-    // low limit
-    aii_obj->read.low_limit = [aii_obj](unsigned /*object_instance*/, float* _low_limit) {
-        *_low_limit = aii_obj->ai_irp.low_limit;
-        return true;
-    };
-    aii_obj->write.low_limit = [aii_obj](unsigned /*object_instance*/, const float _low_limit) {
-        aii_obj->ai_irp.low_limit = _low_limit;
-        return true;
-    };
-    // deadband
-    aii_obj->read.deadband = [aii_obj](unsigned /*object_instance*/, float* _deadband) {
-        *_deadband = aii_obj->ai_irp.deadband;
-        return true;
-    };
-    aii_obj->write.deadband = [aii_obj](unsigned /*object_instance*/, const float _deadband) {
-        aii_obj->ai_irp.deadband = _deadband;
-        return true;
-    };
-    // limit enable
-    aii_obj->read.limit_enable = [aii_obj](unsigned /*object_instance*/, uint8_t* _limit_enable) {
-        *_limit_enable = aii_obj->ai_irp.limit_enable;
-        return true;
-    };
-    aii_obj->write.limit_enable = [aii_obj](unsigned /*object_instance*/, const uint8_t _limit_enable) {
-        aii_obj->ai_irp.limit_enable = _limit_enable;
-        return true;
-    };
-    // acked transitions
-    aii_obj->read.acked_transitions = [aii_obj](unsigned /*object_instance*/,
-                                          std::vector<ACKED_INFO>& _acked_transitions) {
-        _acked_transitions = aii_obj->ai_irp.acked_transitions;
-        return true;
-    };
-    aii_obj->write.acked_transitions = [aii_obj](unsigned /*object_instance*/,
-                                           const std::vector<ACKED_INFO>& _acked_transitions) {
-        aii_obj->ai_irp.acked_transitions = _acked_transitions;
-        return true;
-    };
-    // notify type
-    aii_obj->read.notify_type = [aii_obj](unsigned /*object_instance*/, uint8_t* _notify_type) {
-        *_notify_type = aii_obj->ai_irp.notify_type;
-        return true;
-    };
-    aii_obj->write.notify_type = [aii_obj](unsigned /*object_instance*/, const uint8_t _notify_type) {
-        aii_obj->ai_irp.notify_type = _notify_type;
-        return true;
-    };
-    // event time stamps
-    aii_obj->read.event_time_stamps = [aii_obj](unsigned /*object_instance*/,
-                                          std::vector<BACNET_DATE_TIME>& _event_time_stamps) {
-        _event_time_stamps = aii_obj->ai_irp.event_time_stamps;
-        return true;
-    };
-    aii_obj->write.event_time_stamps = [aii_obj](unsigned /*object_instance*/,
-                                           const std::vector<BACNET_DATE_TIME>& _event_time_stamps) {
-        aii_obj->ai_irp.event_time_stamps = _event_time_stamps;
-        return true;
-    };
-    // remaining time delay
-    aii_obj->read.remaining_time_delay = [aii_obj](unsigned /*object_instance*/, uint32_t* _remaining_time_delay) {
-        *_remaining_time_delay = aii_obj->ai_irp.remaining_time_delay;
-        return true;
-    };
-    aii_obj->write.remaining_time_delay = [aii_obj](unsigned /*object_instance*/,
-                                              const uint32_t _remaining_time_delay) {
-        aii_obj->ai_irp.remaining_time_delay = _remaining_time_delay;
-        return true;
-    };
-    // event state
-    aii_obj->read.event_state = [aii_obj](unsigned /*object_instance*/, uint8_t* _event_state) {
-        *_event_state = aii_obj->ai_irp.event_state;
-        return true;
-    };
-    aii_obj->write.event_state = [aii_obj](unsigned /*object_instance*/, const uint8_t _event_state) {
-        aii_obj->ai_irp.event_state = _event_state;
-        return true;
-    };
-    // last offnormal event state
-    aii_obj->read.last_offnormal_event_state = [aii_obj](unsigned /*object_instance*/,
-                                                   uint8_t* _last_offnormal_event_state) {
-        *_last_offnormal_event_state = aii_obj->ai_irp.last_offnormal_event_state;
-        return true;
-    };
-    aii_obj->write.last_offnormal_event_state = [aii_obj](unsigned /*object_instance*/,
-                                                    const uint8_t _last_offnormal_event_state) {
-        aii_obj->ai_irp.last_offnormal_event_state = _last_offnormal_event_state;
-        return true;
-    };
-    // ack notify data
-    aii_obj->read.ack_notify_data = [aii_obj](unsigned /*object_instance*/, ACK_NOTIFICATION& _ack_notify_data) {
-        _ack_notify_data = *aii_obj->ai_irp.ack_notify_data;
-        return true;
-    };
-    aii_obj->write.ack_notify_data = [aii_obj](unsigned /*object_instance*/, const ACK_NOTIFICATION& _ack_notify_data) {
-        *aii_obj->ai_irp.ack_notify_data = _ack_notify_data;
-        return true;
-    };
 #endif
 
-    init_analog_input_intrinsic_object_handlers(aii_obj->handler);
+    aii_obj->handler = typeHandler(OBJECT_ANALOG_INPUT, init_analog_input_intrinsic_object_handlers);
 
-    aii_obj->handler.count = [this]() -> unsigned {
-        unsigned count = 0;
-        for (const auto& obj : device->objects) {
-            if (obj->type == OBJECT_ANALOG_INPUT)
-                count++;
-        }
-        return count;
-    };
-
-    aii_obj->handler.init(*aii_obj);
+    aii_obj->handler->init(*aii_obj);
 
 #if defined(INTRINSIC_REPORTING)
 #if !defined(CERTIFICATION_SOFTWARE)
-    aii_obj->ai_irp.notification_class = notification_class_instance;
+    aii_obj->ai_irp->notification_class = notification_class_instance;
 #endif
 #endif
 
-    device->objects.push_back(aii_obj);
+    registerObject(object);
 
     return true;
 }
@@ -680,15 +843,16 @@ bool Container::addAnalogValueObject(read_object_name_cb object_name_cb,
     if (!(bool)device)
         return false;
 
-    auto av_obj = std::make_shared<BACnetObject>();
+    auto object = makeObject();
+    auto av_obj = object.get();
 
     av_obj->type = OBJECT_ANALOG_VALUE;
     av_obj->read.object_name = object_name_cb;
     av_obj->instance = ++instance;
     // printf("Add: analog-input %d\n", av_obj->instance);
-    av_obj->read.object_identifier = [av_obj]() { return av_obj->instance; };
 
     av_obj->read.present_value_real = read_present_value_cb;
+    av_obj->present_value.enabled = !read_present_value_cb;
     av_obj->write.present_value_real = write_present_value_cb;
 
     av_obj->read.units = [units](unsigned /*object_instance*/, BACNET_ENGINEERING_UNITS* _units) {
@@ -696,11 +860,6 @@ bool Container::addAnalogValueObject(read_object_name_cb object_name_cb,
         return true;
     };
 
-    av_obj->read.out_of_service = [](unsigned /*object_instance*/, bool* out_of_service) -> int {
-        *out_of_service = false;
-        return true;
-    };
-
     av_obj->read.description = [description](unsigned /*object_instance*/, char* _description) -> int {
         strcpy(_description, description.c_str());
         return true;
@@ -720,19 +879,12 @@ bool Container::addAnalogValueObject(read_object_name_cb object_name_cb,
         *_resolution = resolution;
         return true;
     };
+    // changes below the resolution are noise, don't notify COV subscribers about them
+    av_obj->cov.increment = resolution;
 
-    init_analog_value_object_handlers(av_obj->handler);
+    av_obj->handler = typeHandler(OBJECT_ANALOG_VALUE, init_analog_value_object_handlers);
 
-    av_obj->handler.count = [this]() -> unsigned {
-        unsigned count = 0;
-        for (const auto& obj : device->objects) {
-            if (obj->type == OBJECT_ANALOG_VALUE)
-                count++;
-        }
-        return count;
-    };
-
-    device->objects.push_back(av_obj);
+    registerObject(object);
 
     return true;
 }
@@ -745,36 +897,24 @@ bool Container::addMultiStateInputObject(read_object_name_cb object_name_cb,
     if (!(bool)device)
         return false;
 
-    auto msi_obj = std::make_shared<BACnetObject>();
+    auto object = makeObject();
+    auto msi_obj = object.get();
     msi_obj->type = OBJECT_MULTI_STATE_INPUT;
     msi_obj->read.object_name = object_name_cb;
     msi_obj->instance = ++instance;
     // printf("Add: multi-state-input %d\n", msi_obj->instance);
-    msi_obj->read.object_identifier = [msi_obj]() { return msi_obj->instance; };
     msi_obj->read.present_value_unsigned = present_value_cb;
+    msi_obj->present_value.enabled = !present_value_cb;
     msi_obj->read.number_of_states = number_of_states_cb;
     msi_obj->read.state_text = state_text_cb;
-    msi_obj->read.out_of_service = [](unsigned /*object_instance*/, bool* out_of_service) -> int {
-        *out_of_service = false;
-        return true;
-    };
     msi_obj->read.description = [description](unsigned /*object_instance*/, char* _description) -> int {
         strcpy(_description, description.c_str());
         return true;
     };
 
-    init_multi_state_input_object_handlers(msi_obj->handler);
+    msi_obj->handler = typeHandler(OBJECT_MULTI_STATE_INPUT, init_multi_state_input_object_handlers);
 
-    msi_obj->handler.count = [this]() -> unsigned {
-        unsigned count = 0;
-        for (const auto& obj : device->objects) {
-            if (obj->type == OBJECT_MULTI_STATE_INPUT)
-                count++;
-        }
-        return count;
-    };
-
-    device->objects.push_back(msi_obj);
+    registerObject(object);
 
     return true;
 }
@@ -788,37 +928,25 @@ bool Container::addMultiStateValueObject(read_object_name_cb object_name_cb,
     if (!(bool)device)
         return false;
 
-    auto msv_obj = std::make_shared<BACnetObject>();
+    auto object = makeObject();
+    auto msv_obj = object.get();
     msv_obj->type = OBJECT_MULTI_STATE_VALUE;
     msv_obj->read.object_name = object_name_cb;
     msv_obj->instance = ++instance;
     // printf("Add: multi-state-input %d\n", msv_obj->instance);
-    msv_obj->read.object_identifier = [msv_obj]() { return msv_obj->instance; };
     msv_obj->read.present_value_unsigned = read_present_value_cb;
+    msv_obj->present_value.enabled = !read_present_value_cb;
     msv_obj->write.present_value_unsigned = write_present_value_cb;
     msv_obj->read.number_of_states = number_of_states_cb;
     msv_obj->read.state_text = state_text_cb;
-    msv_obj->read.out_of_service = [](unsigned /*object_instance*/, bool* out_of_service) -> int {
-        *out_of_service = false;
-        return true;
-    };
     msv_obj->read.description = [description](unsigned /*object_instance*/, char* _description) -> int {
         strcpy(_description, description.c_str());
         return true;
     };
 
-    init_multi_state_value_object_handlers(msv_obj->handler);
-
-    msv_obj->handler.count = [this]() -> unsigned {
-        unsigned count = 0;
-        for (const auto& obj : device->objects) {
-            if (obj->type == OBJECT_MULTI_STATE_VALUE)
-                count++;
-        }
-        return count;
-    };
+    msv_obj->handler = typeHandler(OBJECT_MULTI_STATE_VALUE, init_multi_state_value_object_handlers);
 
-    device->objects.push_back(msv_obj);
+    registerObject(object);
 
     return true;
 }
@@ -830,11 +958,11 @@ bool Container::addCharacterStringValueObject(read_object_name_cb object_name_cb
     if (!(bool)device)
         return false;
 
-    auto csv_obj = std::make_shared<BACnetObject>();
+    auto object = makeObject();
+    auto csv_obj = object.get();
     csv_obj->type = OBJECT_CHARACTERSTRING_VALUE;
     csv_obj->read.object_name = object_name_cb;
     csv_obj->instance = ++instance;
-    csv_obj->read.object_identifier = [csv_obj]() { return csv_obj->instance; };
     csv_obj->read.present_value_characterstring = read_present_value_cb;
     csv_obj->write.present_value_characterstring = write_present_value_cb;
 
@@ -843,18 +971,9 @@ bool Container::addCharacterStringValueObject(read_object_name_cb object_name_cb
         return true;
     };
 
-    init_characterstring_value_object_handlers(csv_obj->handler);
+    csv_obj->handler = typeHandler(OBJECT_CHARACTERSTRING_VALUE, init_characterstring_value_object_handlers);
 
-    csv_obj->handler.count = [this]() -> unsigned {
-        unsigned count = 0;
-        for (const auto& obj : device->objects) {
-            if (obj->type == OBJECT_CHARACTERSTRING_VALUE)
-                count++;
-        }
-        return count;
-    };
-
-    device->objects.push_back(csv_obj);
+    registerObject(object);
 
     return true;
 }
@@ -866,12 +985,13 @@ bool Container::addTimeValueObject(read_object_name_cb object_name_cb,
     if (!(bool)device)
         return false;
 
-    auto tv_obj = std::make_shared<BACnetObject>();
+    auto object = makeObject();
+    auto tv_obj = object.get();
     tv_obj->type = OBJECT_TIME_VALUE;
     tv_obj->read.object_name = object_name_cb;
     tv_obj->instance = ++instance;
-    tv_obj->read.object_identifier = [tv_obj]() { return tv_obj->instance; };
     tv_obj->read.present_value_time = read_present_value_cb;
+    tv_obj->present_value.enabled = !read_present_value_cb;
     tv_obj->write.present_value_time = write_present_value_cb;
 
     tv_obj->read.description = [description](unsigned /*object_instance*/, char* _description) -> int {
@@ -879,18 +999,9 @@ bool Container::addTimeValueObject(read_object_name_cb object_name_cb,
         return true;
     };
 
-    init_time_value_object_handlers(tv_obj->handler);
-
-    tv_obj->handler.count = [this]() -> unsigned {
-        unsigned count = 0;
-        for (const auto& obj : device->objects) {
-            if (obj->type == OBJECT_TIME_VALUE)
-                count++;
-        }
-        return count;
-    };
+    tv_obj->handler = typeHandler(OBJECT_TIME_VALUE, init_time_value_object_handlers);
 
-    device->objects.push_back(tv_obj);
+    registerObject(object);
 
     return true;
 }
@@ -902,12 +1013,13 @@ bool Container::addDateValueObject(read_object_name_cb object_name_cb,
     if (!(bool)device)
         return false;
 
-    auto dv_obj = std::make_shared<BACnetObject>();
+    auto object = makeObject();
+    auto dv_obj = object.get();
     dv_obj->type = OBJECT_DATE_VALUE;
     dv_obj->read.object_name = object_name_cb;
     dv_obj->instance = ++instance;
-    dv_obj->read.object_identifier = [dv_obj]() { return dv_obj->instance; };
     dv_obj->read.present_value_date = read_present_value_cb;
+    dv_obj->present_value.enabled = !read_present_value_cb;
     dv_obj->write.present_value_date = write_present_value_cb;
 
     dv_obj->read.description = [description](unsigned /*object_instance*/, char* _description) -> int {
@@ -915,18 +1027,9 @@ bool Container::addDateValueObject(read_object_name_cb object_name_cb,
         return true;
     };
 
-    init_date_value_object_handlers(dv_obj->handler);
-
-    dv_obj->handler.count = [this]() -> unsigned {
-        unsigned count = 0;
-        for (const auto& obj : device->objects) {
-            if (obj->type == OBJECT_DATE_VALUE)
-                count++;
-        }
-        return count;
-    };
+    dv_obj->handler = typeHandler(OBJECT_DATE_VALUE, init_date_value_object_handlers);
 
-    device->objects.push_back(dv_obj);
+    registerObject(object);
 
     return true;
 }
@@ -940,11 +1043,11 @@ bool Container::addBitStringValueObject(read_object_name_cb object_name_cb,
     if (!(bool)device)
         return false;
 
-    auto bsv_obj = std::make_shared<BACnetObject>();
+    auto object = makeObject();
+    auto bsv_obj = object.get();
     bsv_obj->type = OBJECT_BITSTRING_VALUE;
     bsv_obj->read.object_name = object_name_cb;
     bsv_obj->instance = ++instance;
-    bsv_obj->read.object_identifier = [bsv_obj]() { return bsv_obj->instance; };
     bsv_obj->read.number_of_bits = number_of_bits_cb;
     bsv_obj->read.bit_text = bit_text_cb;
     bsv_obj->read.present_value_bitstring = read_present_value_cb;
@@ -955,18 +1058,9 @@ bool Container::addBitStringValueObject(read_object_name_cb object_name_cb,
         return true;
     };
 
-    init_bitstring_value_object_handlers(bsv_obj->handler);
-
-    bsv_obj->handler.count = [this]() -> unsigned {
-        unsigned count = 0;
-        for (const auto& obj : device->objects) {
-            if (obj->type == OBJECT_BITSTRING_VALUE)
-                count++;
-        }
-        return count;
-    };
+    bsv_obj->handler = typeHandler(OBJECT_BITSTRING_VALUE, init_bitstring_value_object_handlers);
 
-    device->objects.push_back(bsv_obj);
+    registerObject(object);
 
     return true;
 }
@@ -979,11 +1073,12 @@ bool Container::addNotificationClassObject(read_object_name_cb object_name_cb,
     if (!(bool)device)
         return false;
 
-    auto nc_obj = std::make_shared<BACnetObject>();
+    auto object = makeObject();
+    auto nc_obj = object.get();
     nc_obj->type = OBJECT_NOTIFICATION_CLASS;
+    nc_obj->nc_irp.reset(new NcIntrinsicReportingParams());
     nc_obj->read.object_name = object_name_cb;
     nc_obj->instance = ++instance;
-    nc_obj->read.object_identifier = [nc_obj]() { return nc_obj->instance; };
 
 #if !defined(CERTIFICATION_SOFTWARE)
     nc_instance = nc_obj->instance; // For AI to know which instance number is for which data type monitoring
@@ -994,439 +1089,434 @@ bool Container::addNotificationClassObject(read_object_name_cb object_name_cb,
         return true;
     };
 
-    // priority
-    nc_obj->read.priority = [nc_obj](unsigned /*object_instance*/, std::vector<uint8_t>& _priority) {
-        _priority = nc_obj->nc_irp.priority;
-        return true;
-    };
-    nc_obj->write.priority = [nc_obj](unsigned /*object_instance*/, const std::vector<uint8_t>& _priority) {
-        nc_obj->nc_irp.priority = _priority;
-        return true;
-    };
-
-    // ack required
-    nc_obj->read.ack_required = [nc_obj](unsigned /*object_instance*/, uint8_t* _ack_required) {
-        *_ack_required = nc_obj->nc_irp.ack_required;
-        return true;
-    };
-    nc_obj->write.ack_required = [nc_obj](unsigned /*object_instance*/, const uint8_t _ack_required) {
-        nc_obj->nc_irp.ack_required = _ack_required;
-        return true;
-    };
-
-    // recipient list
-    nc_obj->read.recipient_list = [nc_obj](unsigned /*object_instance*/,
-                                      std::vector<BACNET_DESTINATION>& _recipient_list) {
-        _recipient_list = nc_obj->nc_irp.recipient_list;
-        return true;
-    };
-    nc_obj->write.recipient_list = [nc_obj](unsigned /*object_instance*/,
-                                       const std::vector<BACNET_DESTINATION>& _recipient_list) {
-        nc_obj->nc_irp.recipient_list = _recipient_list;
-        return true;
-    };
-
-    // recipient list
-    nc_obj->read.recipient_list = [nc_obj](unsigned /*object_instance*/,
-                                      std::vector<BACNET_DESTINATION>& _recipient_list) {
-        _recipient_list = nc_obj->nc_irp.recipient_list;
-        return true;
-    };
-    nc_obj->write.recipient_list = [nc_obj](unsigned /*object_instance*/,
-                                       const std::vector<BACNET_DESTINATION>& _recipient_list) {
-        nc_obj->nc_irp.recipient_list = _recipient_list;
-        return true;
-    };
+    nc_obj->handler = typeHandler(OBJECT_NOTIFICATION_CLASS, init_notification_class_object_handlers);
 
-    init_notification_class_object_handlers(nc_obj->handler);
-
-    nc_obj->handler.count = [this]() -> unsigned {
-        unsigned count = 0;
-        for (const auto& obj : device->objects) {
-            if (obj->type == OBJECT_NOTIFICATION_CLASS)
-                count++;
-        }
-        return count;
-    };
+    nc_obj->handler->init(*nc_obj);
 
-    nc_obj->handler.init(*nc_obj);
+    registerObject(object);
 
-    device->objects.push_back(nc_obj);
+    // a notification class added after the persistent state was loaded takes its recipients from it
+    if (persistent_state_loaded)
+        applyStoredRecipientList(nc_obj);
 
-    container.ImportRecipientList();
-
-    hasRecipientListChanged = true;
+    notificationClassRecipientListChanged(nc_obj->instance);
 
     return true;
 }
 
-std::shared_ptr<BACnetObject> Container::getDeviceObject() {
-    return device;
-}
-
-void Container::ExportRecipientList() {
+bool Container::validObjectSpec(const ObjectSpec& spec) {
+    // every object is indexed by its name
+    if (!spec.object_name)
+        return false;
 
-#if PRINT_ENABLED
-    printf("Exporting recipient list to file.\n");
+    switch (spec.type) {
+    case OBJECT_ANALOG_INPUT:
+#if defined(CERTIFICATION_SOFTWARE)
+        return (bool)spec.event_detection_enable_cb;
+#else
+        return true;
 #endif
+    case OBJECT_ANALOG_VALUE:
+    case OBJECT_TIME_VALUE:
+    case OBJECT_DATE_VALUE:
+        return true;
+    case OBJECT_MULTI_STATE_INPUT:
+    case OBJECT_MULTI_STATE_VALUE:
+        return spec.number_of_states && spec.state_text;
+    // these have no present value store
+    case OBJECT_CHARACTERSTRING_VALUE:
+        return (bool)spec.read_present_value_characterstring;
+    case OBJECT_BITSTRING_VALUE:
+        return spec.read_present_value_bitstring && spec.number_of_bits && spec.bit_text;
+    default:
+        return false;
+    }
+}
 
-    try {
-        // Delete previous file if exists
-        Poco::File cryptedFile(pathToRecipientListFile);
-        if (cryptedFile.exists())
-            cryptedFile.remove();
-
-        // Fill temporary file with json content
-        Poco::TemporaryFile recipientListFile;
-        Poco::FileOutputStream recipientListFileStream(recipientListFile.path());
+void Container::indexObjects(size_t first) {
+#if defined(INTRINSIC_REPORTING)
+    std::vector<uint64_t> alarms;
+#endif
+    char object_name[MAX_OBJECT_NAME_LENGTH];
 
-        recipientListFileStream << getRecipientList();
-        recipientListFileStream.close();
+    for (size_t i = first; i < device->objects.size(); i++) {
+        BACnetObject* object = device->objects[i].get();
 
-        // Load keys
-        std::istringstream iss_priv(PRIVATE_KEY_DATA);
-        std::istream& private_key(iss_priv);
-        std::istringstream iss_pub(PUBLIC_KEY_DATA);
-        std::istream& public_key(iss_pub);
+        object_index[objectKey(object->type, object->instance)] = object;
+        object_type_index.emplace(object->type, object);
+        object_type_count[object->type]++;
 
-        CipherFactory& factory = CipherFactory::defaultFactory();
-        // Create cipher
-        Cipher* pCipher = factory.createCipher(RSAKey(&public_key, &private_key, PRIVATE_KEY_PASSWORD));
+        // a new object has no previous name to drop, unlike in indexObjectName()
+        object_name[0] = '\0';
+        object->read.object_name(object->instance, object_name);
+        object_name_index.emplace(object_name, object);
+        object_names.emplace(object, object_name);
 
-        // Encrypt data to a new file
-        Poco::FileOutputStream sink(Poco::Path(pathToRecipientListFile).toString());
-        Poco::FileInputStream source(recipientListFile.path());
-        CryptoOutputStream encryptor(sink, pCipher->createEncryptor());
-
-        Poco::StreamCopier::copyStream(source, encryptor);
-    } catch (Poco::Exception& e) {
-#if PRINT_ENABLED
-        fprintf(stderr, "Error %s; Message: %s", e.what(), e.message());
+#if defined(INTRINSIC_REPORTING)
+        if (object->ai_irp && activeAlarm(object))
+            alarms.push_back(objectKey(object->type, object->instance));
 #endif
     }
-}
-
-void Container::ImportRecipientList() {
 
-#if PRINT_ENABLED
-    printf("Importing recipient list from file.\n");
+#if defined(INTRINSIC_REPORTING)
+    std::sort(alarms.begin(), alarms.end());
+    size_t middle = active_alarms.size();
+    active_alarms.insert(active_alarms.end(), alarms.begin(), alarms.end());
+    std::inplace_merge(active_alarms.begin(), active_alarms.begin() + middle, active_alarms.end());
 #endif
 
-    std::vector<std::pair<std::string, std::vector<BACNET_DESTINATION>>> object_name_recipient_pair_list;
+    // the device lists the supported object types
+    device->encoded_properties.stale = true;
+}
 
-    try {
-        // Check whether a recipient list file exists
-        Poco::Path recipientFilePath(pathToRecipientListFile);
-        Poco::File recipientFile(recipientFilePath);
+bool Container::addObjects(const std::vector<ObjectSpec>& specs) {
+    if (!(bool)device)
+        return false;
 
-        if (!recipientFile.exists())
-            return;
+    // nothing is added unless all of them can be
+    for (const auto& spec : specs) {
+        if (!validObjectSpec(spec))
+            return false;
+    }
 
-        CipherFactory& factory = CipherFactory::defaultFactory();
+    size_t first = device->objects.size();
+    size_t total = first + specs.size();
+    device->objects.reserve(total);
+    object_index.reserve(total);
+    object_name_index.reserve(total);
+    object_names.reserve(total);
+
+    bool added = true;
+    deferred_indexing = true;
+    for (const auto& spec : specs) {
+        if (!addObject(spec)) {
+            added = false;
+            break;
+        }
+    }
+    deferred_indexing = false;
 
-        // Load keys
-        std::istringstream iss_priv(PRIVATE_KEY_DATA);
-        std::istream& private_key(iss_priv);
-        std::istringstream iss_pub(PUBLIC_KEY_DATA);
-        std::istream& public_key(iss_pub);
+    indexObjects(first);
 
-        // Create cipher
-        Cipher* pCipher = factory.createCipher(RSAKey(&public_key, &private_key, PRIVATE_KEY_PASSWORD));
+    return added;
+}
 
-        // Decrypt data to a temporary file
-        Poco::FileInputStream source(pathToRecipientListFile);
-        Poco::TemporaryFile jsonFile;
-        Poco::FileStream jsonStream(jsonFile.path());
-        pCipher->decrypt(source, jsonStream);
+bool Container::addObject(const ObjectSpec& spec) {
+    bool added = false;
+    switch (spec.type) {
+    case OBJECT_ANALOG_INPUT:
+        added = addAnalogInputObject(spec.object_name,
+            spec.read_present_value_real,
+#if defined(CERTIFICATION_SOFTWARE)
+            spec.event_detection_enable_cb,
+#endif
+            spec.units,
+            spec.description.empty() ? "Analog Input Intrinsic Object" : spec.description,
+            spec.device_type,
+            spec.max_value,
+            spec.min_value,
+            spec.resolution
+#if !defined(CERTIFICATION_SOFTWARE)
+            ,
+            spec.event_detection_enable,
+            spec.notification_class_instance
+#endif
+        );
+        break;
+    case OBJECT_ANALOG_VALUE:
+        added = addAnalogValueObject(spec.object_name,
+            spec.read_present_value_real,
+            spec.write_present_value_real,
+            spec.units,
+            spec.description.empty() ? "Analog Value Object" : spec.description,
+            spec.max_value,
+            spec.min_value,
+            spec.resolution);
+        break;
+    case OBJECT_MULTI_STATE_INPUT:
+        added = addMultiStateInputObject(spec.object_name,
+            spec.read_present_value_unsigned,
+            spec.number_of_states,
+            spec.state_text,
+            spec.description.empty() ? "Multi-State Input Object" : spec.description);
+        break;
+    case OBJECT_MULTI_STATE_VALUE:
+        added = addMultiStateValueObject(spec.object_name,
+            spec.read_present_value_unsigned,
+            spec.write_present_value_unsigned,
+            spec.number_of_states,
+            spec.state_text,
+            spec.description.empty() ? "Multi-State Value Object" : spec.description);
+        break;
+    case OBJECT_CHARACTERSTRING_VALUE:
+        added = addCharacterStringValueObject(spec.object_name,
+            spec.read_present_value_characterstring,
+            spec.write_present_value_characterstring,
+            spec.description.empty() ? "Character String Value Object" : spec.description);
+        break;
+    case OBJECT_TIME_VALUE:
+        added = addTimeValueObject(spec.object_name,
+            spec.read_present_value_time,
+            spec.write_present_value_time,
+            spec.description.empty() ? "Time Value Object" : spec.description);
+        break;
+    case OBJECT_DATE_VALUE:
+        added = addDateValueObject(spec.object_name,
+            spec.read_present_value_date,
+            spec.write_present_value_date,
+            spec.description.empty() ? "Date Value Object" : spec.description);
+        break;
+    case OBJECT_BITSTRING_VALUE:
+        added = addBitStringValueObject(spec.object_name,
+            spec.read_present_value_bitstring,
+            spec.write_present_value_bitstring,
+            spec.number_of_bits,
+            spec.bit_text,
+            spec.description.empty() ? "BitString Value Object" : spec.description);
+        break;
+    default:
+        break;
+    }
 
-        jsonStream.seekg(0, std::ios_base::beg);
+    return added;
+}
 
-        // Parse data
-        Poco::JSON::Parser parser;
-        const auto json = parser.parse(jsonStream);
-        const Poco::JSON::Object::Ptr root = json.extract<Poco::JSON::Object::Ptr>();
+bool Container::addObjectRange(const ObjectSpec& spec, unsigned count, uint32_t* first_instance) {
+    if (!(bool)device || count == 0)
+        return false;
 
-        // Notification classes
-        Poco::JSON::Array::Ptr nc_objects = root->getArray("notification_classes");
-        for (auto ncArrayIterator : *nc_objects) {
+    // the instances are instance + 1 ... instance + count, they must stay valid object identifiers
+    if ((uint64_t)instance + count >= BACNET_MAX_INSTANCE)
+        return false;
 
-            // Object name
-            auto json_object_name =
-                ncArrayIterator.extract<Poco::JSON::Object::Ptr>()->get("nc_object_name").convert<std::string>();
+    // one object serves all instances, so values must come from the callbacks which get the instance
+    bool present_value_cb = false;
+    switch (spec.type) {
+    case OBJECT_ANALOG_INPUT:
+    case OBJECT_ANALOG_VALUE:
+        present_value_cb = (bool)spec.read_present_value_real;
+        break;
+    case OBJECT_MULTI_STATE_INPUT:
+    case OBJECT_MULTI_STATE_VALUE:
+        present_value_cb = (bool)spec.read_present_value_unsigned;
+        break;
+    case OBJECT_CHARACTERSTRING_VALUE:
+        present_value_cb = (bool)spec.read_present_value_characterstring;
+        break;
+    case OBJECT_TIME_VALUE:
+        present_value_cb = (bool)spec.read_present_value_time;
+        break;
+    case OBJECT_DATE_VALUE:
+        present_value_cb = (bool)spec.read_present_value_date;
+        break;
+    case OBJECT_BITSTRING_VALUE:
+        present_value_cb = (bool)spec.read_present_value_bitstring;
+        break;
+    default:
+        break;
+    }
+    if (!present_value_cb || !validObjectSpec(spec) || !addObject(spec))
+        return false;
 
-            // Recipients
-            const auto json_recipient_list =
-                ncArrayIterator.extract<Poco::JSON::Object::Ptr>()->get("recipients").extract<Poco::JSON::Array::Ptr>();
+    BACnetObject* object = device->objects.back().get();
 
-            std::vector<BACNET_DESTINATION> recipients;
-            for (auto json_recipient : *json_recipient_list) {
+    // instances of a range are looked up in object_ranges, and by name through the name callback
+    object_index.erase(objectKey(object->type, object->instance));
+    unindexObjectName(object);
 
-                BACNET_DESTINATION recipient;
+#if defined(INTRINSIC_REPORTING)
+    // the instances share this object, they can't share its alarm state
+    if (object->ai_irp) {
+        object->ai_irp->event_state = EVENT_STATE_NORMAL;
+        object->ai_irp->acked_transitions.clear();
+        updateActiveAlarm(object);
+        object->ai_irp.reset();
+    }
+#endif
 
-                // Recipient -> Device identifier
-                auto device_identifier =
-                    json_recipient.extract<Poco::JSON::Object::Ptr>()->get("device_identifier").convert<uint32_t>();
-                recipient.Recipient._.DeviceIdentifier = device_identifier;
+    object->read.find_object_name = spec.find_object_name;
+    object->range_first = object->instance;
+    object->range_count = count;
+    object_type_count[object->type] += count - 1;
+    instance += count - 1;
 
-                // Recipient -> Recipient type
-                auto recipient_type =
-                    json_recipient.extract<Poco::JSON::Object::Ptr>()->get("recipient_type").convert<uint8_t>();
-                recipient.Recipient.RecipientType = recipient_type;
+    // instances are handed out in increasing order, so the ranges of a type stay sorted
+    object_ranges[object->type].push_back(object);
 
-                auto address_obj = json_recipient.extract<Poco::JSON::Object::Ptr>()->get("address");
+    if (first_instance != nullptr)
+        *first_instance = object->range_first;
 
-                // Recipient -> Address
-                auto address = address_obj.extract<Poco::JSON::Object::Ptr>()->get("adr").convert<std::string>();
+    return true;
+}
 
-                std::vector<std::string> addr_str;
+BACnetObject* Container::findRangeObject(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+    auto ranges = object_ranges.find(object_type);
+    if (ranges == object_ranges.end())
+        return nullptr;
 
-                std::stringstream adr_iss(address);
-                std::string addr_token;
-                while (std::getline(adr_iss, addr_token, ';'))
-                    addr_str.push_back(addr_token);
+    auto it = std::upper_bound(ranges->second.begin(),
+        ranges->second.end(),
+        object_instance,
+        [](uint32_t object_instance, const BACnetObject* range) { return object_instance < range->range_first; });
+    if (it == ranges->second.begin())
+        return nullptr;
 
-                for (unsigned i = 0; i < MAX_MAC_LEN; i++)
-                    recipient.Recipient._.Address.adr[i] = static_cast<uint8_t>(std::stoi(addr_str[i]));
+    BACnetObject* range = *(it - 1);
+    if (object_instance - range->range_first >= range->range_count)
+        return nullptr;
 
-                // Recipient -> Mac
-                auto mac_address = address_obj.extract<Poco::JSON::Object::Ptr>()->get("mac").convert<std::string>();
+    return range;
+}
 
-                std::vector<std::string> mac_str;
+bool Container::findRangeObjectName(const std::string& name, int* object_type, uint32_t* object_instance) {
+    // one call per range, ranges without a resolver aren't found by name
+    for (const auto& ranges : object_ranges) {
+        for (const BACnetObject* range : ranges.second) {
+            unsigned instance = 0;
+            if (!range->read.find_object_name || !range->read.find_object_name(name.c_str(), &instance))
+                continue;
+            if (instance < range->range_first || instance - range->range_first >= range->range_count)
+                continue;
+
+            *object_type = range->type;
+            *object_instance = instance;
+            return true;
+        }
+    }
 
-                std::stringstream mac_iss(mac_address);
-                std::string mac_token;
-                while (std::getline(mac_iss, mac_token, ';'))
-                    mac_str.push_back(mac_token);
+    return false;
+}
 
-                for (unsigned i = 0; i < MAX_MAC_LEN; i++)
-                    recipient.Recipient._.Address.mac[i] = static_cast<uint8_t>(std::stoi(mac_str[i]));
+CovState& Container::covState(BACnetObject* object, uint32_t object_instance) {
+    if (object->range_count == 0)
+        return object->cov;
 
-                // Recipient -> len
-                auto addr_len = address_obj.extract<Poco::JSON::Object::Ptr>()->get("len").convert<uint8_t>();
-                recipient.Recipient._.Address.len = addr_len;
+    // instances of a range keep their own COV state, created when they are first checked
+    return range_cov[objectKey(object->type, object_instance)];
+}
 
-                // Recipient -> mac_len
-                auto mac_len = address_obj.extract<Poco::JSON::Object::Ptr>()->get("mac_len").convert<uint8_t>();
-                recipient.Recipient._.Address.mac_len = mac_len;
+std::shared_ptr<BACnetObject> Container::getDeviceObject() {
+    return device;
+}
 
-                // Recipient -> net
-                auto net = address_obj.extract<Poco::JSON::Object::Ptr>()->get("net").convert<uint16_t>();
-                recipient.Recipient._.Address.net = net;
+void Container::ExportRecipientList() {
+    RecipientLists lists;
 
-                // Valid days
-                auto valid_days =
-                    json_recipient.extract<Poco::JSON::Object::Ptr>()->get("valid_days").convert<uint8_t>();
-                recipient.ValidDays = valid_days;
+    for (const auto& object : device->objects) {
+        if (object->type == OBJECT_NOTIFICATION_CLASS) {
+            char object_name[MAX_OBJECT_NAME_LENGTH] = "";
+            object->read.object_name(object->instance, object_name);
+            lists.emplace_back(object_name, object->nc_irp->recipient_list);
+        }
+    }
 
-                // From time
-                auto from_time_obj = json_recipient.extract<Poco::JSON::Object::Ptr>()->get("from_time");
+    // keep the loaded lists of notification classes that haven't been added yet
+    for (const auto& nc : stored_recipient_lists) {
+        auto it = object_name_index.find(nc.first);
+        if (it == object_name_index.end() || it->second->type != OBJECT_NOTIFICATION_CLASS)
+            lists.emplace_back(nc.first, nc.second);
+    }
 
-                // From time -> hour
-                auto from_hour = from_time_obj.extract<Poco::JSON::Object::Ptr>()->get("hour").convert<uint8_t>();
-                recipient.FromTime.hour = from_hour;
+    // encrypting and writing the file is left to the store's thread
+    recipient_list_store.save(std::move(lists));
+}
 
-                // From time -> min
-                auto from_min = from_time_obj.extract<Poco::JSON::Object::Ptr>()->get("min").convert<uint8_t>();
-                recipient.FromTime.min = from_min;
+void Container::loadPersistentState() {
+    if (persistent_state_loaded)
+        return;
 
-                // From time -> sec
-                auto from_sec = from_time_obj.extract<Poco::JSON::Object::Ptr>()->get("sec").convert<uint8_t>();
-                recipient.FromTime.sec = from_sec;
+    persistent_state_loaded = true;
+    ImportRecipientList();
+}
 
-                // From time -> hundredths
-                auto from_hundredths =
-                    from_time_obj.extract<Poco::JSON::Object::Ptr>()->get("hundredths").convert<uint8_t>();
-                recipient.FromTime.hundredths = from_hundredths;
+void Container::ImportRecipientList() {
 
-                // To time
-                auto to_time_obj = json_recipient.extract<Poco::JSON::Object::Ptr>()->get("to_time");
+#if PRINT_ENABLED
+    printf("Importing recipient list from file.\n");
+#endif
 
-                // To time -> hour
-                auto to_hour = to_time_obj.extract<Poco::JSON::Object::Ptr>()->get("hour").convert<uint8_t>();
-                recipient.ToTime.hour = to_hour;
+    stored_recipient_lists.clear();
+    bool imported_legacy = false;
 
-                // To time -> min
-                auto to_min = to_time_obj.extract<Poco::JSON::Object::Ptr>()->get("min").convert<uint8_t>();
-                recipient.ToTime.min = to_min;
+    if (recipient_list_store.exists()) {
+        RecipientLists lists;
+        if (recipient_list_store.load(lists)) {
+            for (auto& nc : lists)
+                stored_recipient_lists[nc.first] = std::move(nc.second);
+        } else {
+#if PRINT_ENABLED
+            fprintf(stderr, "Recipient list file can't be read or failed authentication.\n");
+#endif
+        }
+    } else {
+        imported_legacy = importLegacyRecipientList();
+    }
 
-                // To time -> sec
-                auto to_sec = to_time_obj.extract<Poco::JSON::Object::Ptr>()->get("sec").convert<uint8_t>();
-                recipient.ToTime.sec = to_sec;
+    configureNotificationClasses();
 
-                // To time -> hundredths
-                auto to_hundredths =
-                    to_time_obj.extract<Poco::JSON::Object::Ptr>()->get("hundredths").convert<uint8_t>();
-                recipient.ToTime.hundredths = to_hundredths;
+    // move the lists to the new file format, later starts no longer need the legacy file
+    if (imported_legacy)
+        ExportRecipientList();
+}
 
-                // Process identifier
-                auto process_identifier =
-                    json_recipient.extract<Poco::JSON::Object::Ptr>()->get("process_identifier").convert<uint32_t>();
-                recipient.ProcessIdentifier = process_identifier;
+bool Container::importLegacyRecipientList() {
+    try {
+        // Check whether a recipient list file exists
+        Poco::File recipientFile(pathToRecipientListFile);
+        if (!recipientFile.exists())
+            return false;
 
-                // Transitions
-                auto transitions =
-                    json_recipient.extract<Poco::JSON::Object::Ptr>()->get("transitions").convert<uint8_t>();
-                recipient.Transitions = transitions;
+        std::ifstream source(pathToRecipientListFile, std::ios::binary);
+        std::string encrypted((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
 
-                // Confirmed notify
-                auto confirmed_notify =
-                    json_recipient.extract<Poco::JSON::Object::Ptr>()->get("confirmed_notify").convert<bool>();
-                recipient.ConfirmedNotify = confirmed_notify;
+        // Load keys
+        std::istringstream private_key(PRIVATE_KEY_DATA);
+        std::istringstream public_key(PUBLIC_KEY_DATA);
 
-                recipients.push_back(recipient);
-            }
+        // Decrypt in memory and parse the document in one pass
+        Cipher::Ptr cipher =
+            CipherFactory::defaultFactory().createCipher(RSAKey(&public_key, &private_key, PRIVATE_KEY_PASSWORD));
 
-            object_name_recipient_pair_list.push_back(std::make_pair(json_object_name, recipients));
+        RecipientLists lists;
+        if (!parseRecipientListJson(cipher->decryptString(encrypted), lists)) {
+#if PRINT_ENABLED
+            fprintf(stderr, "Recipient list file is malformed.\n");
+#endif
+            return false;
         }
 
-        // Configure notification classes
-        configureNotificationClasses(object_name_recipient_pair_list);
-
+        for (auto& nc : lists)
+            stored_recipient_lists[nc.first] = std::move(nc.second);
+        return true;
     } catch (Poco::Exception& e) {
 #if PRINT_ENABLED
-        fprintf(stderr, "Error %s; Message: %s", e.what(), e.message());
+        fprintf(stderr, "Error %s; Message: %s", e.what(), e.message().c_str());
 #endif
     }
-}
-
-std::string Container::getRecipientList() {
-    Poco::JSON::Object::Ptr root = new Poco::JSON::Object();
-    Poco::JSON::Object::Ptr rootObject = new Poco::JSON::Object();
-    Poco::JSON::Array::Ptr notificationClassArray = new Poco::JSON::Array();
-
-    unsigned notification_class_cnt = 0;
-    for (const auto& object : getDeviceObject()->objects) {
-        if (object->type == OBJECT_NOTIFICATION_CLASS) {
-            Poco::JSON::Object::Ptr notificationClassObject = new Poco::JSON::Object();
-
-            auto recipient_list = object->nc_irp.recipient_list;
-            Poco::JSON::Array::Ptr recipientArray = new Poco::JSON::Array();
-
-            // Notification class object namespace
-            static char object_name[MAX_OBJECT_NAME_LENGTH] = "";
-            object->read.object_name(object->instance, object_name);
-            notificationClassObject->set("nc_object_name", std::string(object_name));
-
-            unsigned recipient_cnt = 0;
-            for (const auto& recipient : recipient_list) {
-
-                // Recipient
-                Poco::JSON::Object::Ptr recipientObject = new Poco::JSON::Object();
-
-                // Recipient -> Device identifier
-                recipientObject->set("device_identifier", recipient.Recipient._.DeviceIdentifier);
-
-                // Recipient -> Recipient_type
-                recipientObject->set("recipient_type", recipient.Recipient.RecipientType);
-
-                // Recipient -> Address
-                Poco::JSON::Object::Ptr recipientAddressObject = new Poco::JSON::Object();
-
-                std::string address;
-                for (int i = 0; i < MAX_MAC_LEN; i++) {
-                    address.append(std::to_string(recipient.Recipient._.Address.adr[i]));
-                    if (i != (MAX_MAC_LEN - 1))
-                        address.append(";");
-                }
-
-                recipientAddressObject->set("adr", address);
-                recipientAddressObject->set("len", recipient.Recipient._.Address.len);
-
-                std::string mac;
-                for (int i = 0; i < MAX_MAC_LEN; i++) {
-                    mac.append(std::to_string(recipient.Recipient._.Address.mac[i]));
-                    if (i != (MAX_MAC_LEN - 1))
-                        mac.append(";");
-                }
-
-                recipientAddressObject->set("mac", mac);
-                recipientAddressObject->set("mac_len", recipient.Recipient._.Address.mac_len);
-                recipientAddressObject->set("net", recipient.Recipient._.Address.net);
-
-                recipientObject->set("address", recipientAddressObject);
-
-                // Valid days
-                recipientObject->set("valid_days", recipient.ValidDays);
-
-                // From time
-                Poco::JSON::Object::Ptr fromTimeObject = new Poco::JSON::Object();
-                fromTimeObject->set("hour", recipient.FromTime.hour);
-                fromTimeObject->set("min", recipient.FromTime.min);
-                fromTimeObject->set("sec", recipient.FromTime.sec);
-                fromTimeObject->set("hundredths", recipient.FromTime.hundredths);
-                recipientObject->set("from_time", fromTimeObject);
-
-                // To time
-                Poco::JSON::Object::Ptr toTimeObject = new Poco::JSON::Object();
-                toTimeObject->set("hour", recipient.ToTime.hour);
-                toTimeObject->set("min", recipient.ToTime.min);
-                toTimeObject->set("sec", recipient.ToTime.sec);
-                toTimeObject->set("hundredths", recipient.ToTime.hundredths);
-                recipientObject->set("to_time", toTimeObject);
-
-                // Process id
-                recipientObject->set("process_identifier", recipient.ProcessIdentifier);
-
-                // Transitions
-                recipientObject->set("transitions", recipient.Transitions);
-
-                // Confirmed notify
-                recipientObject->set("confirmed_notify", recipient.ConfirmedNotify);
-
-                recipientArray->set(recipient_cnt, recipientObject);
-                recipient_cnt++;
-            }
-
-            notificationClassObject->set("recipients", recipientArray);
-
-            notificationClassArray->set(notification_class_cnt, notificationClassObject);
-
-            notification_class_cnt++;
-        }
-    }
-
-    rootObject->set("notification_classes", notificationClassArray);
 
-    root->set("root", rootObject);
-
-    return JsonToString(rootObject);
+    return false;
 }
 
-void Container::configureNotificationClasses(
-    std::vector<std::pair<std::string, std::vector<BACNET_DESTINATION>>>& recipient_list) {
-    auto objects = getDeviceObject()->objects;
-    for (const auto& nc : recipient_list) {
-
-        auto nc_obj_name = nc.first;
-        auto it = std::find_if(objects.begin(), objects.end(), [nc_obj_name](std::shared_ptr<BACnetObject> obj) {
-            static char object_name[MAX_OBJECT_NAME_LENGTH] = "";
-            obj->read.object_name(obj->instance, object_name);
-            std::string name(object_name);
-
-            return obj->type == OBJECT_NOTIFICATION_CLASS && name == nc_obj_name;
-        });
-
-        if (it == objects.end())
+void Container::configureNotificationClasses() {
+    for (const auto& nc : stored_recipient_lists) {
+        auto it = object_name_index.find(nc.first);
+        if (it == object_name_index.end() || it->second->type != OBJECT_NOTIFICATION_CLASS)
             continue;
 
 #if PRINT_ENABLED
-        printf("Found notification class with name %s. Setting appropriate values.\n", nc_obj_name.c_str());
+        printf("Found notification class with name %s. Setting appropriate values.\n", nc.first.c_str());
 #endif
 
-        auto nc_obj = *it;
-
-        nc_obj->write.recipient_list(nc_obj->instance, nc.second);
+        notificationClassSetRecipientList(*it->second, nc.second);
     }
 }
 
-std::string Container::JsonToString(Poco::JSON::Object::Ptr jsonObject) {
-    std::string jsonString;
-
-    try {
-        Poco::Dynamic::Var dynJson = jsonObject;
-        jsonString = dynJson.toString();
-    } catch (...) {
-    }
+void Container::applyStoredRecipientList(BACnetObject* nc_obj) {
+    auto name = object_names.find(nc_obj);
+    if (name == object_names.end())
+        return;
 
-    return jsonString;
-}
\ No newline at end of file
+    auto it = stored_recipient_lists.find(name->second);
+    if (it != stored_recipient_lists.end())
+        notificationClassSetRecipientList(*nc_obj, it->second);
+}
@@ -2,14 +2,16 @@
 #define BACNET_CONTAINER_HPP
 
 #include "callbacks.hpp"
+#include "object_pool.hpp"
+#include "recipient_list_store.hpp"
 #include "rp.h"
 #include "wp.h"
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
-#include <Poco/JSON/Object.h>
-
 namespace bacnet {
 
 class Container {
@@ -25,18 +27,100 @@ class Container {
     bool getValidObjectId(int object_type, uint32_t object_instance);
     bool copyObjectName(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, BACNET_CHARACTER_STRING* object_name);
 
-    // bool
-    // deviceEncodeValueList(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, BACNET_PROPERTY_VALUE*
-    // value_list); bool deviceCov(BACNET_OBJECT_TYPE object_type, uint32_t object_instance); void
-    // deviceCovClear(BACNET_OBJECT_TYPE object_type, uint32_t object_instance); bool
-    // deviceValueListSupported(BACNET_OBJECT_TYPE object_type);
+    bool
+    deviceEncodeValueList(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, BACNET_PROPERTY_VALUE* value_list);
+
+    /**
+     * Check whether an object's Present_Value or Status_Flags changed since its last COV notification.
+     */
+    bool deviceCov(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+
+    /**
+     * Take an object's current Present_Value and Status_Flags as the values last notified.
+     */
+    void deviceCovClear(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+    bool deviceValueListSupported(BACNET_OBJECT_TYPE object_type);
+
+    // property lists of an object, those of its type if there is no such object
+    void getObjectsPropertyList(BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        struct special_property_list_t* pPropertyList);
+
+    /**
+     * Look up an object by its identifier.
+     *
+     * @param object_type Object type
+     * @param object_instance Object instance
+     * @return Pointer to the object, or nullptr if there is no such object
+     */
+    BACnetObject* findObject(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+    unsigned getObjectCount(BACNET_OBJECT_TYPE object_type);
+
+    /**
+     * Refresh the object name index after an object name has changed.
+     *
+     * Object names are read once at registration, so this must be called
+     * whenever the application renames an object outside of a WriteProperty.
+     *
+     * @param object_type Object type
+     * @param object_instance Object instance
+     */
+    void objectNameChanged(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+
+    /**
+     * Drop the cached encodings of an object's static properties, e.g. units or description,
+     * so they are encoded again from the callbacks on the next read. Safe to call from any thread.
+     *
+     * @param object_type Object type
+     * @param object_instance Object instance
+     */
+    void staticPropertiesChanged(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+
+    /**
+     * Register a hook that reads all properties of one object type requested by a
+     * ReadPropertyMultiple at once, instead of one property callback per value.
+     */
+    void setBatchReadHandler(BACNET_OBJECT_TYPE object_type, object_batch_read_cb batch_read_cb);
+
+    bool hasBatchReadHandlers();
+
+    /**
+     * Queue a property read for the next flushBatchRead(), if its object type has a batch read hook.
+     */
+    void queueBatchRead(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, BACNET_PROPERTY_ID object_property);
+
+    /**
+     * Hand the queued property reads to the batch read hooks, one call per object type.
+     * readProperty() serves the results until clearBatchRead() is called.
+     */
+    void flushBatchRead();
+    void clearBatchRead();
 
-    void getObjectsPropertyList(BACNET_OBJECT_TYPE object_type, struct special_property_list_t* pPropertyList);
     int readProperty(::BACNET_READ_PROPERTY_DATA* rp_data);
     bool writeProperty(::BACNET_WRITE_PROPERTY_DATA* wp_data);
 
 #if defined(INTRINSIC_REPORTING)
     void deviceLocalReporting(void);
+
+    /**
+     * Re-evaluate whether an object belongs to the active alarm set, i.e. whether its
+     * event state is not NORMAL or it has unacknowledged transitions.
+     * Called on every event state or acked transitions change.
+     */
+    void updateActiveAlarm(BACnetObject* object);
+
+    /**
+     * Get the active alarm of the given type at the given position, in object identifier order.
+     *
+     * @return Pointer to the object, or nullptr when index is past the last active alarm of that type
+     */
+    BACnetObject* getActiveAlarm(BACNET_OBJECT_TYPE object_type, unsigned index);
+
+    /**
+     * Get the position of the first active alarm of the given type with an instance greater
+     * than object_instance, used to resume after a 'Last Received Object Identifier'.
+     */
+    unsigned getActiveAlarmIndex(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
 #endif
 
     /* Device */
@@ -133,21 +217,113 @@ class Container {
 #endif
         const std::string& description = "Notification Class Object");
 
+    /**
+     * Add many objects at once. Storage and indexes are sized for all of them up front, so adding
+     * tens of thousands of objects takes time linear in their number.
+     *
+     * @param specs Objects to add, in instance order. Notification classes are not supported, they are
+     *              added with addNotificationClassObject() so their instance is known to analog inputs.
+     * @return true if all objects were added, false on the first one that could not be added
+     */
+    bool addObjects(const std::vector<ObjectSpec>& specs);
+
+    /**
+     * Add count objects of one type that differ only by instance, served by a single object. The
+     * callbacks get the instance being accessed, so per instance there is nothing to store. The
+     * instances are listed in the Object_List and found by ReadProperty and COV like ordinary
+     * objects. By name, e.g. by Who-Has, they are only found through spec.find_object_name.
+     * Instances of a range have no intrinsic reporting and none of its properties, and the present
+     * value must come from the read present value callback.
+     *
+     * @param spec The objects to add, except notification classes
+     * @param count Number of instances
+     * @param first_instance Set to the first of the consecutive instances of the range
+     * @return true if the range was added, false e.g. if its instances would exceed BACNET_MAX_INSTANCE
+     */
+    bool addObjectRange(const ObjectSpec& spec, unsigned count, uint32_t* first_instance);
+
     std::shared_ptr<BACnetObject> getDeviceObject();
 
     void reset();
 
+    /**
+     * Read the recipient lists saved by ExportRecipientList() and apply them to the notification classes,
+     * looked up by object name. The file is decrypted and parsed once, notification classes added later
+     * take their recipients from what was read. Does nothing if the state was already loaded.
+     */
+    void loadPersistentState();
+
     void ExportRecipientList();
     void ImportRecipientList();
 
   private:
-    std::string JsonToString(Poco::JSON::Object::Ptr jsonObject);
-    std::string getRecipientList();
-    void configureNotificationClasses(
-        std::vector<std::pair<std::string, std::vector<BACNET_DESTINATION>>>& recipient_list);
+    static uint64_t objectKey(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+    static uint64_t propertyKey(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, BACNET_PROPERTY_ID property);
+    // objects are taken from the object pool
+    std::shared_ptr<BACnetObject> makeObject();
+    void registerObject(const std::shared_ptr<BACnetObject>& object);
+    // whether a spec sets everything the handlers of its type call, so adding it can't fail halfway
+    static bool validObjectSpec(const ObjectSpec& spec);
+    bool addObject(const ObjectSpec& spec);
+    // index the objects addObjects() added from device->objects[first] on, in one pass
+    void indexObjects(size_t first);
+#if defined(INTRINSIC_REPORTING)
+    // whether an analog input is in alarm or has unacked transitions
+    static bool activeAlarm(const BACnetObject* object);
+#endif
+    // the range holding an instance, or nullptr if there is none. The range is shared by all its instances and
+    // never changed by a lookup, as the application may look up instances from other threads.
+    BACnetObject* findRangeObject(BACNET_OBJECT_TYPE object_type, uint32_t object_instance);
+    bool findRangeObjectName(const std::string& name, int* object_type, uint32_t* object_instance);
+    // COV state of an object, or of one instance of a range
+    CovState& covState(BACnetObject* object, uint32_t object_instance);
+    // the handler table shared by all objects of a type, set up by init_handlers on first use
+    const ObjectTypeHandler* typeHandler(BACNET_OBJECT_TYPE object_type, void (*init_handlers)(ObjectTypeHandler&));
+    void indexObjectName(BACnetObject* object);
+    // drop the object's name, another object with the same name takes over its index entry
+    void unindexObjectName(const BACnetObject* object);
+    int readEncodedProperty(BACnetObject* object, ::BACNET_READ_PROPERTY_DATA* rp_data);
+    void cacheEncodedProperty(BACnetObject* object, const ::BACNET_READ_PROPERTY_DATA* rp_data, int apdu_len);
+
+    // reads the JSON recipient list file of earlier versions into stored_recipient_lists, false if there is none
+    bool importLegacyRecipientList();
+    // apply the stored recipient lists to all notification classes, or to one just added
+    void configureNotificationClasses();
+    void applyStoredRecipientList(BACnetObject* nc_obj);
 
     std::shared_ptr<BACnetObject> device;
     unsigned instance;
+    // set while addObjects() runs, see indexObjects()
+    bool deferred_indexing;
+    std::shared_ptr<ObjectPool> object_pool;
+
+    // (type, instance) -> object, the device object is looked up separately since its instance is dynamic
+    std::unordered_map<uint64_t, BACnetObject*> object_index;
+    // type -> first registered object of that type, used for per-type data such as property lists
+    std::unordered_map<int, BACnetObject*> object_type_index;
+    std::unordered_map<int, unsigned> object_type_count;
+    // type -> handlers of that type, kept across reset() so objects still referring to them stay valid
+    std::unordered_map<int, std::unique_ptr<ObjectTypeHandler>> type_handlers;
+    // object name -> object and its reverse, so a renamed object can drop its previous entry
+    std::unordered_map<std::string, BACnetObject*> object_name_index;
+    std::unordered_map<const BACnetObject*, std::string> object_names;
+    // type -> object ranges of that type sorted by first instance, and the COV state of their instances by object key
+    std::unordered_map<int, std::vector<BACnetObject*>> object_ranges;
+    std::unordered_map<uint64_t, CovState> range_cov;
+
+    // notification class name -> recipient list as read from the recipient list file
+    std::unordered_map<std::string, std::vector<BACNET_DESTINATION>> stored_recipient_lists;
+    bool persistent_state_loaded;
+    RecipientListStore recipient_list_store;
+
+    // type -> batch read hook, and the reads of the ReadPropertyMultiple being served, by type and by property key
+    std::unordered_map<int, object_batch_read_cb> batch_read_handlers;
+    std::unordered_map<int, std::vector<BatchReadItem>> batch_read_items;
+    std::unordered_map<uint64_t, const BatchReadItem*> batch_read_results;
+#if defined(INTRINSIC_REPORTING)
+    // object keys of objects in alarm or with unacked transitions, kept sorted by object identifier
+    std::vector<uint64_t> active_alarms;
+#endif
 };
 
 } // namespace bacnet
@@ -0,0 +1,86 @@
+#include <cmath>
+
+#include "bacapp.h"
+#include "bacstr.h"
+#include "datetime.h"
+
+#include "cov_value_list.hpp"
+
+using namespace bacnet;
+
+static bool same_value(BACNET_APPLICATION_DATA_VALUE* value, BACNET_APPLICATION_DATA_VALUE* reported, float increment) {
+    if (value->tag != reported->tag)
+        return false;
+
+    switch (value->tag) {
+    case BACNET_APPLICATION_TAG_NULL:
+        return true;
+    case BACNET_APPLICATION_TAG_BOOLEAN:
+        return value->type.Boolean == reported->type.Boolean;
+    case BACNET_APPLICATION_TAG_UNSIGNED_INT:
+        return value->type.Unsigned_Int == reported->type.Unsigned_Int;
+    case BACNET_APPLICATION_TAG_ENUMERATED:
+        return value->type.Enumerated == reported->type.Enumerated;
+    case BACNET_APPLICATION_TAG_REAL:
+        // Clause 13.1.3: notify when the value changed by COV_Increment or more
+        if (increment > 0.0f)
+            return std::fabs(value->type.Real - reported->type.Real) < increment;
+        return value->type.Real == reported->type.Real;
+    case BACNET_APPLICATION_TAG_CHARACTER_STRING:
+        return characterstring_same(&value->type.Character_String, &reported->type.Character_String);
+    case BACNET_APPLICATION_TAG_BIT_STRING:
+        return bitstring_same(&value->type.Bit_String, &reported->type.Bit_String);
+    case BACNET_APPLICATION_TAG_DATE:
+        return datetime_compare_date(&value->type.Date, &reported->type.Date) == 0;
+    case BACNET_APPLICATION_TAG_TIME:
+        return datetime_compare_time(&value->type.Time, &reported->type.Time) == 0;
+    default:
+        return false;
+    }
+}
+
+bool bacnet::encode_cov_value_list(BACNET_PROPERTY_VALUE* value_list, bool in_alarm, bool out_of_service) {
+    if ((value_list == nullptr) || (value_list->next == nullptr))
+        return false;
+
+    value_list->propertyIdentifier = PROP_PRESENT_VALUE;
+    value_list->propertyArrayIndex = BACNET_ARRAY_ALL;
+    value_list->value.context_specific = false;
+    value_list->value.next = nullptr;
+    value_list->priority = BACNET_NO_PRIORITY;
+
+    value_list = value_list->next;
+    value_list->propertyIdentifier = PROP_STATUS_FLAGS;
+    value_list->propertyArrayIndex = BACNET_ARRAY_ALL;
+    value_list->value.context_specific = false;
+    value_list->value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
+    value_list->value.next = nullptr;
+    bitstring_init(&value_list->value.type.Bit_String);
+    bitstring_set_bit(&value_list->value.type.Bit_String, STATUS_FLAG_IN_ALARM, in_alarm);
+    bitstring_set_bit(&value_list->value.type.Bit_String, STATUS_FLAG_FAULT, false);
+    bitstring_set_bit(&value_list->value.type.Bit_String, STATUS_FLAG_OVERRIDDEN, false);
+    bitstring_set_bit(&value_list->value.type.Bit_String, STATUS_FLAG_OUT_OF_SERVICE, out_of_service);
+    value_list->priority = BACNET_NO_PRIORITY;
+
+    return true;
+}
+
+bool bacnet::cov_value_list_changed(const CovState& cov, float increment, BACNET_PROPERTY_VALUE* value_list) {
+    // never notified, the first notification after subscribing is always sent
+    if (!cov.reported)
+        return true;
+
+    if (!same_value(&value_list->value, &cov.reported[0], increment))
+        return true;
+
+    // any change of Status_Flags is notified
+    return !same_value(&value_list->next->value, &cov.reported[1], 0.0f);
+}
+
+void bacnet::cov_value_list_store(CovState& cov, const BACNET_PROPERTY_VALUE* value_list) {
+    if (!cov.reported)
+        cov.reported.reset(new BACNET_APPLICATION_DATA_VALUE[2]);
+
+    cov.reported[0] = value_list->value;
+    cov.reported[1] = value_list->next->value;
+}
@@ -0,0 +1,37 @@
+#ifndef BACNET_COV_VALUE_LIST_HPP
+#define BACNET_COV_VALUE_LIST_HPP
+
+#include "callbacks.hpp"
+
+namespace bacnet {
+
+    /**
+     * Complete the value list of a COV notification. The object sets value_list->value to its
+     * present value, this fills in the rest of the Present_Value entry and the Status_Flags entry
+     * that follows it.
+     *
+     * @param value_list List of two entries
+     * @param in_alarm Whether the object's event state is not NORMAL
+     * @param out_of_service Out_Of_Service of the object
+     * @return true on success, false if the list is too short
+     */
+    bool encode_cov_value_list(BACNET_PROPERTY_VALUE *value_list, bool in_alarm, bool out_of_service);
+
+    /**
+     * Check whether a value list differs from the one last notified for an object.
+     *
+     * @param cov COV state of the object
+     * @param increment COV_Increment of the object, read on every check as it can be written
+     * @param value_list Present_Value and Status_Flags as encoded by encode_cov_value_list()
+     * @return true if a notification should be sent
+     */
+    bool cov_value_list_changed(const CovState &cov, float increment, BACNET_PROPERTY_VALUE *value_list);
+
+    /**
+     * Remember a value list as the one last notified for an object.
+     */
+    void cov_value_list_store(CovState &cov, const BACNET_PROPERTY_VALUE *value_list);
+
+} // namespace bacnet
+
+#endif /* BACNET_COV_VALUE_LIST_HPP */
@@ -11,7 +11,19 @@
 #define BACNET_DEVICE_DESCRIPTION "server"
 #define BACNET_DEVICE_MODEL "Hycleen Automation Master"
 
-#define BACNET_SEGMENTATION_SUPPORT SEGMENTATION_NONE
+// Complex ACKs can be sent segmented, segmented requests are still refused
+#define BACNET_SEGMENTATION_SUPPORT SEGMENTATION_TRANSMIT
+// objects the Object_List of the device must fit into a single segmented ReadProperty ACK,
+// set with the MAX_OBJECT_LIST_LENGTH cache variable; longer lists are read by array index
+#ifndef MAX_OBJECT_LIST_LENGTH
+#define MAX_OBJECT_LIST_LENGTH 2000
+#endif
+// enough segments for that Object_List, at 5 bytes per object identifier plus the ACK's own tags
+#ifndef MAX_SEGMENTS_ACCEPTED
+#define MAX_SEGMENTS_ACCEPTED ((MAX_OBJECT_LIST_LENGTH * 5 + 32 + (MAX_APDU - 5) - 1) / (MAX_APDU - 5))
+#endif
+// largest complex ACK in unsegmented encoding, 3 byte header plus every segment's payload
+#define MAX_SEGMENTED_APDU (3 + MAX_SEGMENTS_ACCEPTED * (MAX_APDU - 5))
 
 #define MAX_DESCRIPTION_LENGTH 64
 #define MAX_DEVICE_TYPE_LENGTH 32
@@ -33,6 +33,7 @@
 #endif
 #include "address.h"
 #include "apdu.h"
+#include "cov_subscriptions.h"
 #include "datetime.h"
 #include "handlers.h"
 #include "rp.h"
@@ -40,6 +41,7 @@
 
 #include "analog_input.hpp"
 #include "c_wrapper.h"
+#include "container.hpp"
 #include "device.hpp"
 
 using namespace bacnet;
@@ -63,6 +65,8 @@ static const int Device_Properties_Required[] = {PROP_OBJECT_IDENTIFIER,
     PROP_SEGMENTATION_SUPPORTED,
     PROP_APDU_TIMEOUT,
     PROP_NUMBER_OF_APDU_RETRIES,
+    PROP_MAX_SEGMENTS_ACCEPTED,
+    PROP_APDU_SEGMENT_TIMEOUT,
     PROP_DEVICE_ADDRESS_BINDING,
     PROP_DATABASE_REVISION,
     -1};
@@ -197,6 +201,8 @@ static unsigned read_property(const BACnetObject& device, BACNET_READ_PROPERTY_D
             /* automatic lookup based on handlers set */
             bitstring_set_bit(&bit_string, (uint8_t)i, apdu_service_supported((BACNET_SERVICES_SUPPORTED)i));
         }
+        /* dispatched outside of the stack's service table */
+        bitstring_set_bit(&bit_string, COV_SERVICE_SUPPORTED_SUBSCRIBE_COV_PROPERTY_MULTIPLE, true);
         apdu_len = encode_application_bitstring(&apdu[0], &bit_string);
         break;
     case PROP_PROTOCOL_OBJECT_TYPES_SUPPORTED: {
@@ -214,37 +220,52 @@ static unsigned read_property(const BACnetObject& device, BACNET_READ_PROPERTY_D
         break;
     }
     case PROP_OBJECT_LIST: {
+        /* an object range lists each of its instances */
         count = 0;
         found = false;
         for (const auto& obj : device.objects) {
-            count++;
+            count += obj->range_count > 0 ? obj->range_count : 1;
         }
         if (rpdata->array_index == 0)
             apdu_len = encode_application_unsigned(&apdu[0], count);
 
         else if (rpdata->array_index == BACNET_ARRAY_ALL) {
             for (const auto& obj : device.objects) {
-                instance = obj->read.object_identifier();
                 object_type = obj->type;
-
-                len = encode_application_object_id(&apdu[apdu_len], object_type, instance);
-                apdu_len += len;
-                if ((i != count) && (apdu_len + len) >= MAX_APDU) {
-                    /* Abort response */
-                    rpdata->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
-                    apdu_len = BACNET_STATUS_ABORT;
-                    break;
+                unsigned instances = obj->range_count > 0 ? obj->range_count : 1;
+                for (unsigned i = 0; i < instances && apdu_len >= 0; i++) {
+                    if (obj->range_count > 0)
+                        instance = obj->range_first + i;
+                    else
+                        instance = obj->type == OBJECT_DEVICE ? obj->read.object_identifier() : obj->instance;
+
+                    /* an object identifier takes at most 5 bytes, check before writing */
+                    if ((apdu_len + 5) > (int)rpdata->application_data_len) {
+                        /* Abort response */
+                        rpdata->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
+                        apdu_len = BACNET_STATUS_ABORT;
+                        break;
+                    }
+                    len = encode_application_object_id(&apdu[apdu_len], object_type, instance);
+                    apdu_len += len;
                 }
+                if (apdu_len < 0)
+                    break;
             }
         } else {
-            unsigned idx = 0;
+            unsigned idx = rpdata->array_index;
             for (const auto& obj : device.objects) {
-                if (++idx == rpdata->array_index) {
+                unsigned instances = obj->range_count > 0 ? obj->range_count : 1;
+                if (idx <= instances) {
                     found = true;
-                    instance = obj->read.object_identifier();
+                    if (obj->range_count > 0)
+                        instance = obj->range_first + idx - 1;
+                    else
+                        instance = obj->type == OBJECT_DEVICE ? obj->read.object_identifier() : obj->instance;
                     object_type = obj->type;
                     break;
                 }
+                idx -= instances;
             }
             if (found) {
                 apdu_len = encode_application_object_id(&apdu[0], object_type, instance);
@@ -269,6 +290,12 @@ static unsigned read_property(const BACnetObject& device, BACNET_READ_PROPERTY_D
     case PROP_NUMBER_OF_APDU_RETRIES:
         apdu_len = encode_application_unsigned(&apdu[0], apdu_retries());
         break;
+    case PROP_MAX_SEGMENTS_ACCEPTED:
+        apdu_len = encode_application_unsigned(&apdu[0], MAX_SEGMENTS_ACCEPTED);
+        break;
+    case PROP_APDU_SEGMENT_TIMEOUT:
+        apdu_len = encode_application_unsigned(&apdu[0], apdu_timeout());
+        break;
     case PROP_DEVICE_ADDRESS_BINDING:
         /* FIXME: the real max apdu remaining should be passed into function */
         apdu_len = address_list_encode(&apdu[0], MAX_APDU);
@@ -330,12 +357,23 @@ static bool write_property(BACnetObject& object, BACNET_WRITE_PROPERTY_DATA* wp_
         status = WPValidateString(&value, MAX_OBJECT_NAME_LENGTH, false, &wp_data->error_class, &wp_data->error_code);
         if (status) {
             /* All the object names in a device must be unique */
+            if (Device_Valid_Object_Name(&value.type.Character_String, &object_type, &object_instance) &&
+                ((object_type != OBJECT_DEVICE) || (object_instance != wp_data->object_instance))) {
+                status = false;
+                wp_data->error_class = ERROR_CLASS_PROPERTY;
+                wp_data->error_code = ERROR_CODE_DUPLICATE_NAME;
+                break;
+            }
+
             auto new_object_name = characterstring_value(&value.type.Character_String);
             len = strlen(new_object_name);
 
             if (!object.write.object_name(wp_data->object_instance, new_object_name)) {
+                status = false;
                 wp_data->error_class = ERROR_CLASS_PROPERTY;
                 wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
+            } else {
+                container.objectNameChanged(OBJECT_DEVICE, wp_data->object_instance);
             }
         }
         break;
@@ -378,6 +416,8 @@ static bool write_property(BACnetObject& object, BACNET_WRITE_PROPERTY_DATA* wp_
     case PROP_MAX_APDU_LENGTH_ACCEPTED:
     case PROP_APDU_TIMEOUT:
     case PROP_SEGMENTATION_SUPPORTED:
+    case PROP_MAX_SEGMENTS_ACCEPTED:
+    case PROP_APDU_SEGMENT_TIMEOUT:
     case PROP_DEVICE_ADDRESS_BINDING:
     case PROP_DATABASE_REVISION:
 #if (BACNET_PROTOCOL_REVISION < 14)
@@ -412,7 +452,7 @@ void bacnet::init_device_object_handlers(ObjectTypeHandler& handler) {
     handler.write_property = write_property;
     handler.rpm_property_list = rpm_property_list;
 
-    handler.intrinsic_reporting = [](const BACnetObject&) {
+    handler.intrinsic_reporting = [](BACnetObject&) {
 
     };
 
@@ -24,6 +24,7 @@
  *********************************************************************/
 
 #include "multi_state_value.hpp"
+#include "cov_value_list.hpp"
 #include "bacnet.hpp"
 #include "custom_bacnet_config.h"
 #include "handlers.h"
@@ -87,7 +88,10 @@ static unsigned multi_state_value_read_property(const BACnetObject& object, BACN
 
     case PROP_PRESENT_VALUE: {
         unsigned present_value = 1;
-        object.read.present_value_unsigned(rpdata->object_instance, &present_value);
+        if (object.present_value.enabled)
+            present_value = object.present_value.load<unsigned>();
+        else
+            object.read.present_value_unsigned(rpdata->object_instance, &present_value);
         apdu_len = encode_application_unsigned(&apdu[0], present_value);
         break;
     }
@@ -146,16 +150,14 @@ static unsigned multi_state_value_read_property(const BACnetObject& object, BACN
 
                 object.read.state_text(rpdata->object_instance, i, state_text);
                 characterstring_init_ansi(&char_string, state_text);
-                /* FIXME: this might go beyond MAX_APDU length! */
-                len = encode_application_character_string(&apdu[apdu_len], &char_string);
-                /* add it if we have room */
-                if ((apdu_len + len) < MAX_APDU) {
-                    apdu_len += len;
-                } else {
+                /* tag, length and character set take 3 bytes, check before writing */
+                if ((apdu_len + MAX_STATE_TEXT_LENGTH + 3) > (int)rpdata->application_data_len) {
                     rpdata->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
                     apdu_len = BACNET_STATUS_ABORT;
                     break;
                 }
+                len = encode_application_character_string(&apdu[apdu_len], &char_string);
+                apdu_len += len;
             }
         } else {
             if (rpdata->array_index <= max_states) {
@@ -237,6 +239,10 @@ static bool multi_state_value_write_property(BACnetObject& object, BACNET_WRITE_
 
                 return status;
             }
+
+            // the application accepted the value, serve it to readers right away
+            if (object.present_value.enabled)
+                object.present_value.store(value.type.Unsigned_Int);
         }
 
         break;
@@ -288,12 +294,35 @@ multi_state_value_rpm_property_list(const int** pRequired, const int** pOptional
         *pProprietary = MSV_Properties_Proprietary;
 }
 
+static bool multi_state_value_encode_value_list(const BACnetObject& object,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE* value_list) {
+    bool out_of_service = false;
+
+    if ((value_list == nullptr) || (value_list->next == nullptr))
+        return false;
+
+    unsigned present_value = 1;
+    if (object.present_value.enabled)
+        present_value = object.present_value.load<unsigned>();
+    else
+        object.read.present_value_unsigned(object_instance, &present_value);
+    value_list->value.tag = BACNET_APPLICATION_TAG_UNSIGNED_INT;
+    value_list->value.type.Unsigned_Int = present_value;
+
+    if (object.read.out_of_service)
+        object.read.out_of_service(object_instance, &out_of_service);
+
+    return encode_cov_value_list(value_list, false, out_of_service);
+}
+
 void bacnet::init_multi_state_value_object_handlers(ObjectTypeHandler& handler) {
     handler.read_property = multi_state_value_read_property;
     handler.write_property = multi_state_value_write_property;
     handler.rpm_property_list = multi_state_value_rpm_property_list;
+    handler.value_list = multi_state_value_encode_value_list;
 
-    handler.intrinsic_reporting = [](const BACnetObject&) {
+    handler.intrinsic_reporting = [](BACnetObject&) {
 
     };
 
@@ -28,10 +28,12 @@
  *
  *********************************************************************/
 
+#include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "address.h"
 #include "bacapp.h"
@@ -41,21 +43,70 @@
 #include "client.h"
 #include "config.h"
 #include "custom_bacnet_config.h"
+#include "datalink.h"
+#include "dcc.h"
 #include "device.hpp"
 #include "event.h"
 #include "handlers.h"
 #include "notification_class.hpp"
+#include "tsm.h"
 #include "txbuf.h"
 #include "wp.h"
 
 #include "bacnet.hpp"
+#include "bip_batch.h"
 #include "c_wrapper.h"
 #include "container.hpp"
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+
 using namespace bacnet;
 
 bool hasRecipientListChanged = false;
 
+namespace {
+
+/* Longest wait, in NC_RESCAN_RECIPIENTS_SECS periods, between Who-Is requests for a recipient that doesn't answer */
+const unsigned WHOIS_BACKOFF_MAX_PERIODS = 16;
+
+/* Recipients of one notification class whose address has to be resolved */
+struct NcRecipients {
+    std::vector<uint32_t> devices;
+    std::vector<BACNET_ADDRESS> addresses;
+};
+
+/* Who-Is requests sent to a recipient that hasn't answered yet */
+struct WhoIsBackoff {
+    unsigned requests = 0;
+    time_t next_request = 0;
+};
+
+struct RecipientResolver {
+    bool rescan_all = true;
+    std::set<uint32_t> changed; /* notification class instances */
+    std::map<uint32_t, NcRecipients> recipients;
+    std::map<uint32_t, WhoIsBackoff> device_backoff;
+    std::map<std::string, WhoIsBackoff> address_backoff;
+};
+
+RecipientResolver resolver;
+
+/* APDU headers of the event notification requests, and the longest encoding of a process identifier */
+const int UNCONFIRMED_EVENT_HEADER_LEN = 2;
+const int CONFIRMED_EVENT_HEADER_LEN = 4;
+const int PROCESS_IDENTIFIER_MAX_LEN = 5;
+
+/* Event notification service request encoded once for all recipients, without the leading process identifier */
+struct EncodedEventNotification {
+    uint8_t service_data[MAX_APDU];
+    int service_data_len;
+};
+
+} // namespace
+
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int Notification_Properties_Required[] = {PROP_OBJECT_IDENTIFIER,
     PROP_OBJECT_NAME,
@@ -72,17 +123,17 @@ static const int Notification_Properties_Proprietary[] = {-1};
 
 static void notification_class_init(BACnetObject& object) {
 
-    object.nc_irp.priority.push_back(255);
-    object.nc_irp.priority.push_back(255);
-    object.nc_irp.priority.push_back(255);
+    object.nc_irp->priority.push_back(255);
+    object.nc_irp->priority.push_back(255);
+    object.nc_irp->priority.push_back(255);
 
 #if defined(CERTIFICATION_SOFTWARE)
-    object.nc_irp.ack_required |= TRANSITION_TO_NORMAL_MASKED;
+    object.nc_irp->ack_required |= TRANSITION_TO_NORMAL_MASKED;
 #endif
-    object.nc_irp.ack_required |= TRANSITION_TO_OFFNORMAL_MASKED;
+    object.nc_irp->ack_required |= TRANSITION_TO_OFFNORMAL_MASKED;
 
-    object.nc_irp.recipient_list.reserve(NC_MAX_RECIPIENTS);
-    object.nc_irp.recipient_list = {};
+    object.nc_irp->recipient_list.reserve(NC_MAX_RECIPIENTS);
+    object.nc_irp->recipient_list = {};
 }
 
 static int notification_class_read_property(const BACnetObject& object, BACNET_READ_PROPERTY_DATA* rpdata) {
@@ -128,9 +179,7 @@ static int notification_class_read_property(const BACnetObject& object, BACNET_R
             apdu_len += encode_application_unsigned(&apdu[0], 3);
         } else {
 
-            std::vector<uint8_t> priority;
-            priority.reserve(MAX_BACNET_EVENT_TRANSITION);
-            object.read.priority(rpdata->object_instance, priority);
+            const auto& priority = object.nc_irp->priority;
 
             if (rpdata->array_index == BACNET_ARRAY_ALL) {
                 apdu_len += encode_application_unsigned(&apdu[apdu_len], priority[TRANSITION_TO_OFFNORMAL]);
@@ -147,10 +196,7 @@ static int notification_class_read_property(const BACnetObject& object, BACNET_R
         break;
 
     case PROP_ACK_REQUIRED:
-        uint8_t ack_required;
-        object.read.ack_required(rpdata->object_instance, &ack_required);
-
-        u8Val = ack_required;
+        u8Val = object.nc_irp->ack_required;
 
         bitstring_init(&bit_string);
         bitstring_set_bit(&bit_string,
@@ -164,11 +210,7 @@ static int notification_class_read_property(const BACnetObject& object, BACNET_R
 
     case PROP_RECIPIENT_LIST: {
         /* encode all entry of Recipient_List */
-        std::vector<BACNET_DESTINATION> recipient_list;
-        recipient_list.reserve(NC_MAX_RECIPIENTS);
-        object.read.recipient_list(rpdata->object_instance, recipient_list);
-
-        for (auto& recipient : recipient_list) {
+        for (const auto& recipient : object.nc_irp->recipient_list) {
 
             /* get pointer of current element for Recipient_List  - easier for use */
             // RecipientEntry = &recipient;
@@ -274,7 +316,7 @@ static int notification_class_read_property(const BACnetObject& object, BACNET_R
     return apdu_len;
 }
 
-static bool notification_class_write_property(const BACnetObject& object, BACNET_WRITE_PROPERTY_DATA* wp_data) {
+static bool notification_class_write_property(BACnetObject& object, BACNET_WRITE_PROPERTY_DATA* wp_data) {
     NOTIFICATION_CLASS_INFO TmpNotify;
     BACNET_APPLICATION_DATA_VALUE value;
     bool status = false;
@@ -303,9 +345,7 @@ static bool notification_class_write_property(const BACnetObject& object, BACNET
 
         if (status) {
 
-            std::vector<uint8_t> priority;
-            priority.reserve(MAX_BACNET_EVENT_TRANSITION);
-            object.read.priority(wp_data->object_instance, priority);
+            std::vector<uint8_t> priority = object.nc_irp->priority;
 
             if (wp_data->array_index == BACNET_ARRAY_ALL) {
                 auto element_len = len;
@@ -347,7 +387,7 @@ static bool notification_class_write_property(const BACnetObject& object, BACNET
                     return false;
                 }
 
-                object.write.priority(wp_data->object_instance, priority);
+                object.nc_irp->priority = priority;
             }
             else if (wp_data->array_index == 0) {
                 if (value.type.Unsigned_Int != 3) {
@@ -359,7 +399,7 @@ static bool notification_class_write_property(const BACnetObject& object, BACNET
             else if (wp_data->array_index > 0 && wp_data->array_index <= 3) {
 
                 priority[wp_data->array_index - 1] = value.type.Unsigned_Int;
-                object.write.priority(wp_data->object_instance, priority);
+                object.nc_irp->priority = priority;
             }
             else {
                 wp_data->error_class = ERROR_CLASS_PROPERTY;
@@ -375,7 +415,7 @@ static bool notification_class_write_property(const BACnetObject& object, BACNET
 
         if (status) {
             if (value.type.Bit_String.bits_used == 3) {
-                object.write.ack_required(wp_data->object_instance, value.type.Bit_String.value[0]);
+                object.nc_irp->ack_required = value.type.Bit_String.value[0];
             } else {
                 wp_data->error_class = ERROR_CLASS_PROPERTY;
                 wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
@@ -603,7 +643,7 @@ static bool notification_class_write_property(const BACnetObject& object, BACNET
             recipient_list.push_back(TmpNotify.Recipient_List[i]);
         }
 
-        object.write.recipient_list(wp_data->object_instance, recipient_list);
+        notificationClassSetRecipientList(object, recipient_list);
 
         for (auto& recipient : recipient_list) {
             BACNET_ADDRESS src = {0};
@@ -623,8 +663,6 @@ static bool notification_class_write_property(const BACnetObject& object, BACNET
 
         container.ExportRecipientList();
 
-        hasRecipientListChanged = true;
-
         status = true;
         break;
     }
@@ -648,18 +686,13 @@ static bool notification_class_write_property(const BACnetObject& object, BACNET
 }
 
 void bacnet::notificationClassGetPriorities(uint32_t Object_Instance, uint32_t* pPriorityArray) {
-    for (const auto& object : container.getDeviceObject()->objects) {
-        if (object->instance == Object_Instance && object->type == OBJECT_NOTIFICATION_CLASS) {
-            std::vector<uint8_t> priority;
-            priority.reserve(MAX_BACNET_EVENT_TRANSITION);
-            object->read.priority(object->instance, priority);
-
-            for (int i = 0; i < MAX_BACNET_EVENT_TRANSITION; i++)
-                pPriorityArray[i] = priority[i];
+    BACnetObject* object = container.findObject(OBJECT_NOTIFICATION_CLASS, Object_Instance);
+    if (object == nullptr)
+        return;
 
-            return;
-        }
-    }
+    const auto& priority = object->nc_irp->priority;
+    for (int i = 0; i < MAX_BACNET_EVENT_TRANSITION; i++)
+        pPriorityArray[i] = priority[i];
 }
 
 static bool IsRecipientActive(BACNET_DESTINATION* pBacDest, uint8_t EventToState) {
@@ -706,125 +739,358 @@ static bool IsRecipientActive(BACNET_DESTINATION* pBacDest, uint8_t EventToState
     return true;
 }
 
-void bacnet::notificationClassCommonReportingFunction(BACNET_EVENT_NOTIFICATION_DATA* event_data) {
+static bool encodeEventNotification(BACNET_EVENT_NOTIFICATION_DATA* event_data,
+    EncodedEventNotification& notification) {
+    uint8_t service_request[MAX_APDU];
+    uint8_t process_identifier[8];
+
+    int len = event_notify_encode_service_request(service_request, event_data);
+    /* the service request starts with the process identifier, which is encoded per recipient */
+    int process_identifier_len = encode_context_unsigned(process_identifier, 0, event_data->processIdentifier);
+    if (len <= process_identifier_len || len - process_identifier_len > (int)sizeof(notification.service_data))
+        return false;
+
+    notification.service_data_len = len - process_identifier_len;
+    memcpy(notification.service_data, &service_request[process_identifier_len], notification.service_data_len);
+    return true;
+}
 
-    for (const auto& object : container.getDeviceObject()->objects) {
-        if (object->instance == event_data->notificationClass && object->type == OBJECT_NOTIFICATION_CLASS) {
+/* Append the process identifier and the encoded service request behind an APDU header */
+static int encodeEventNotificationApdu(uint8_t* apdu,
+    int header_len,
+    uint32_t process_identifier,
+    const EncodedEventNotification& notification) {
+    int len = header_len;
+    len += encode_context_unsigned(&apdu[len], 0, process_identifier);
+    memcpy(&apdu[len], notification.service_data, notification.service_data_len);
+    return len + notification.service_data_len;
+}
 
-            /* Initiating Device Identifier */
-            event_data->initiatingObjectIdentifier.type = OBJECT_DEVICE;
-            event_data->initiatingObjectIdentifier.instance = Device_Object_Instance_Number();
+/* Send_UEvent_Notify() for an event encoded with encodeEventNotification() */
+static int sendUnconfirmedEventNotification(const EncodedEventNotification& notification,
+    uint32_t process_identifier,
+    BACNET_ADDRESS* dest) {
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_ADDRESS my_address;
+
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    int pdu_len = npdu_encode_pdu(&Handler_Transmit_Buffer[0], dest, &my_address, &npdu_data);
+    if (pdu_len + UNCONFIRMED_EVENT_HEADER_LEN + PROCESS_IDENTIFIER_MAX_LEN + notification.service_data_len > MAX_PDU)
+        return -1;
+
+    uint8_t* apdu = &Handler_Transmit_Buffer[pdu_len];
+    apdu[0] = PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+    apdu[1] = SERVICE_UNCONFIRMED_EVENT_NOTIFICATION;
+    pdu_len += encodeEventNotificationApdu(apdu, UNCONFIRMED_EVENT_HEADER_LEN, process_identifier, notification);
+
+    return datalink_send_pdu(dest, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+}
 
-            std::vector<uint8_t> priority;
-            priority.reserve(MAX_BACNET_EVENT_TRANSITION);
-            object->read.priority(object->instance, priority);
+/* Send_CEvent_Notify() for an event encoded with encodeEventNotification() */
+static uint8_t sendConfirmedEventNotification(const EncodedEventNotification& notification,
+    uint32_t process_identifier,
+    uint32_t device_id) {
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_ADDRESS dest;
+    BACNET_ADDRESS my_address;
+    unsigned max_apdu = 0;
+    uint8_t invoke_id = 0;
 
-            uint8_t ack_required;
-            object->read.ack_required(object->instance, &ack_required);
+    if (!dcc_communication_enabled())
+        return 0;
 
-            /* Priority and AckRequired */
-            switch (event_data->toState) {
-            case EVENT_STATE_NORMAL:
-                event_data->priority = priority[TRANSITION_TO_NORMAL];
-                event_data->ackRequired = (ack_required & TRANSITION_TO_NORMAL_MASKED) ? true : false;
-                break;
+    /* is the device bound and is there a tsm available? */
+    if (address_get_by_device(device_id, &max_apdu, &dest))
+        invoke_id = tsm_next_free_invokeID();
+    if (!invoke_id)
+        return 0;
 
-            case EVENT_STATE_FAULT:
-                event_data->priority = priority[TRANSITION_TO_FAULT];
-                event_data->ackRequired = (ack_required & TRANSITION_TO_FAULT_MASKED) ? true : false;
-                break;
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+    int pdu_len = npdu_encode_pdu(&Handler_Transmit_Buffer[0], &dest, &my_address, &npdu_data);
+
+    /* will it fit in the destination? */
+    int max_len = pdu_len + CONFIRMED_EVENT_HEADER_LEN + PROCESS_IDENTIFIER_MAX_LEN + notification.service_data_len;
+    if (max_len > MAX_PDU || (unsigned)max_len >= max_apdu) {
+        tsm_free_invoke_id(invoke_id);
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "Failed to Send ConfirmedEventNotification Request "
+            "(exceeds destination maximum APDU)!\n");
+#endif
+        return 0;
+    }
 
-            case EVENT_STATE_OFFNORMAL:
-            case EVENT_STATE_HIGH_LIMIT:
-            case EVENT_STATE_LOW_LIMIT:
-                event_data->priority = priority[TRANSITION_TO_OFFNORMAL];
-                event_data->ackRequired = (ack_required & TRANSITION_TO_OFFNORMAL_MASKED) ? true : false;
-                break;
+    uint8_t* apdu = &Handler_Transmit_Buffer[pdu_len];
+    apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+    apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+    apdu[2] = invoke_id;
+    apdu[3] = SERVICE_CONFIRMED_EVENT_NOTIFICATION;
+    pdu_len += encodeEventNotificationApdu(apdu, CONFIRMED_EVENT_HEADER_LEN, process_identifier, notification);
+
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, &dest, &npdu_data, &Handler_Transmit_Buffer[0],
+        (uint16_t)pdu_len);
+    if (datalink_send_pdu(&dest, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len) <= 0) {
+#if PRINT_ENABLED
+        fprintf(stderr, "Failed to Send ConfirmedEventNotification Request (%s)!\n", strerror(errno));
+#endif
+    }
+
+    return invoke_id;
+}
+
+void bacnet::notificationClassCommonReportingFunction(BACNET_EVENT_NOTIFICATION_DATA* event_data) {
+    BACnetObject* object = container.findObject(OBJECT_NOTIFICATION_CLASS, event_data->notificationClass);
+    if (object == nullptr)
+        return;
+
+    /* Initiating Device Identifier */
+    event_data->initiatingObjectIdentifier.type = OBJECT_DEVICE;
+    event_data->initiatingObjectIdentifier.instance = Device_Object_Instance_Number();
+
+    const auto& priority = object->nc_irp->priority;
+    uint8_t ack_required = object->nc_irp->ack_required;
+
+    /* Priority and AckRequired */
+    switch (event_data->toState) {
+    case EVENT_STATE_NORMAL:
+        event_data->priority = priority[TRANSITION_TO_NORMAL];
+        event_data->ackRequired = (ack_required & TRANSITION_TO_NORMAL_MASKED) ? true : false;
+        break;
+
+    case EVENT_STATE_FAULT:
+        event_data->priority = priority[TRANSITION_TO_FAULT];
+        event_data->ackRequired = (ack_required & TRANSITION_TO_FAULT_MASKED) ? true : false;
+        break;
+
+    case EVENT_STATE_OFFNORMAL:
+    case EVENT_STATE_HIGH_LIMIT:
+    case EVENT_STATE_LOW_LIMIT:
+        event_data->priority = priority[TRANSITION_TO_OFFNORMAL];
+        event_data->ackRequired = (ack_required & TRANSITION_TO_OFFNORMAL_MASKED) ? true : false;
+        break;
+
+    default: /* shouldn't happen */
+        break;
+    }
 
-            default: /* shouldn't happen */
+    /* The notification only differs by process identifier and destination between recipients */
+    EncodedEventNotification notification;
+    bool encoded = false;
+
+    /* unconfirmed notifications to all recipients go out together */
+    bip_send_batch_begin();
+
+    /* send notifications for active recipients */
+    for (const auto& recipient : object->nc_irp->recipient_list) {
+        /* check if recipient is defined */
+        if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_NOTINITIALIZED)
+            break; /* recipient doesn't defined - end of list */
+
+        BACNET_DESTINATION destination = recipient;
+        if (!IsRecipientActive(&destination, event_data->toState))
+            continue;
+
+        if (!encoded) {
+            if (!encodeEventNotification(event_data, notification)) {
+#if PRINT_ENABLED
+                fprintf(stderr,
+                    "Failed to encode EventNotification of notification class %u, no recipient is notified!\n",
+                    (unsigned)object->instance);
+#endif
                 break;
             }
+            encoded = true;
+        }
 
-            /* send notifications for active recipients */
-            /* pointer to first recipient */
-            std::vector<BACNET_DESTINATION> recipient_list;
-            recipient_list.reserve(NC_MAX_RECIPIENTS);
-            object->read.recipient_list(object->instance, recipient_list);
-
-            for (auto& recipient : recipient_list) {
-                BACNET_DESTINATION* pBacDest = &recipient;
-
-                /* check if recipient is defined */
-                if (pBacDest->Recipient.RecipientType == RECIPIENT_TYPE_NOTINITIALIZED)
-                    break; /* recipient doesn't defined - end of list */
-
-                if (IsRecipientActive(pBacDest, event_data->toState) == true) {
-                    BACNET_ADDRESS dest;
-                    uint32_t device_id;
-                    unsigned max_apdu;
-
-                    /* Process Identifier */
-                    event_data->processIdentifier = pBacDest->ProcessIdentifier;
-
-                    /* send notification */
-                    if (pBacDest->Recipient.RecipientType == RECIPIENT_TYPE_DEVICE) {
-                        /* send notification to the specified device */
-                        device_id = pBacDest->Recipient._.DeviceIdentifier;
-
-                        if (pBacDest->ConfirmedNotify == true)
-                            Send_CEvent_Notify(device_id, event_data);
-                        else if (address_get_by_device(device_id, &max_apdu, &dest))
-                            Send_UEvent_Notify(Handler_Transmit_Buffer, event_data, &dest);
-                    } else if (pBacDest->Recipient.RecipientType == RECIPIENT_TYPE_ADDRESS) {
-                        /* send notification to the address indicated */
-                        if (pBacDest->ConfirmedNotify == true) {
-                            dest = pBacDest->Recipient._.Address;
-                            if (address_get_device_id(&dest, &device_id))
-                                Send_CEvent_Notify(device_id, event_data);
-                        } else {
-                            dest = pBacDest->Recipient._.Address;
-                            Send_UEvent_Notify(Handler_Transmit_Buffer, event_data, &dest);
-                        }
-                    }
-                }
+        BACNET_ADDRESS dest;
+        uint32_t device_id;
+        unsigned max_apdu;
+
+        /* send notification */
+        if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_DEVICE) {
+            /* send notification to the specified device */
+            device_id = recipient.Recipient._.DeviceIdentifier;
+
+            if (recipient.ConfirmedNotify == true)
+                sendConfirmedEventNotification(notification, recipient.ProcessIdentifier, device_id);
+            else if (address_get_by_device(device_id, &max_apdu, &dest))
+                sendUnconfirmedEventNotification(notification, recipient.ProcessIdentifier, &dest);
+        } else if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_ADDRESS) {
+            /* send notification to the address indicated */
+            dest = recipient.Recipient._.Address;
+            if (recipient.ConfirmedNotify == true) {
+                if (address_get_device_id(&dest, &device_id))
+                    sendConfirmedEventNotification(notification, recipient.ProcessIdentifier, device_id);
+            } else {
+                sendUnconfirmedEventNotification(notification, recipient.ProcessIdentifier, &dest);
             }
+        }
+    }
+
+    bip_send_batch_end();
+}
 
+/* The significant bytes of an address, so equal addresses compare equal whatever the unused bytes hold */
+static std::string addressKey(const BACNET_ADDRESS& address) {
+    std::string key;
+    key.push_back((char)(address.net >> 8));
+    key.push_back((char)(address.net & 0xFF));
+    key.push_back((char)address.mac_len);
+    key.append((const char*)address.mac, std::min<size_t>(address.mac_len, MAX_MAC_LEN));
+    key.push_back((char)address.len);
+    key.append((const char*)address.adr, std::min<size_t>(address.len, MAX_MAC_LEN));
+    return key;
+}
+
+static void readRecipients(const BACnetObject& object) {
+    const auto& recipient_list = object.nc_irp->recipient_list;
+
+    NcRecipients& recipients = resolver.recipients[object.instance];
+    NcRecipients previous;
+    std::swap(previous, recipients);
+
+    for (const auto& recipient : recipient_list) {
+        if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_DEVICE) {
+            uint32_t device_id = recipient.Recipient._.DeviceIdentifier;
+            recipients.devices.push_back(device_id);
+
+            /* a recipient that was just added is asked for right away */
+            if (std::find(previous.devices.begin(), previous.devices.end(), device_id) == previous.devices.end())
+                resolver.device_backoff.erase(device_id);
+        } else if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_ADDRESS && recipient.ConfirmedNotify) {
+            /* confirmed notifications need the device identifier behind the address */
+            std::string key = addressKey(recipient.Recipient._.Address);
+            recipients.addresses.push_back(recipient.Recipient._.Address);
+
+            bool added = std::none_of(previous.addresses.begin(),
+                previous.addresses.end(),
+                [&key](const BACNET_ADDRESS& address) { return addressKey(address) == key; });
+            if (added)
+                resolver.address_backoff.erase(key);
+        }
+    }
+}
+
+static void updateRecipients(void) {
+    if (resolver.rescan_all) {
+        auto device = container.getDeviceObject();
+        if (!device)
             return;
+
+        resolver.recipients.clear();
+        for (const auto& object : device->objects) {
+            if (object->type == OBJECT_NOTIFICATION_CLASS)
+                readRecipients(*object);
         }
+
+        resolver.rescan_all = false;
+        resolver.changed.clear();
+        return;
+    }
+
+    for (auto instance : resolver.changed) {
+        BACnetObject* object = container.findObject(OBJECT_NOTIFICATION_CLASS, instance);
+        if (object != nullptr)
+            readRecipients(*object);
+        else
+            resolver.recipients.erase(instance);
     }
+    resolver.changed.clear();
+}
+
+/* Whether to send a Who-Is now: a recipient that doesn't answer is asked again after 1, 2, 4, ... */
+/* NC_RESCAN_RECIPIENTS_SECS periods. It goes by the time elapsed, so the extra rescans run when a */
+/* recipient list changes don't shorten the wait. */
+static bool whoIsDue(WhoIsBackoff& backoff, time_t now) {
+    if (now < backoff.next_request)
+        return false;
+
+    unsigned periods = std::min(1u << std::min(backoff.requests, 4u), WHOIS_BACKOFF_MAX_PERIODS);
+    backoff.next_request = now + (time_t)periods * NC_RESCAN_RECIPIENTS_SECS;
+    backoff.requests++;
+    return true;
+}
+
+void bacnet::notificationClassRecipientListChanged(uint32_t object_instance) {
+    resolver.changed.insert(object_instance);
+    hasRecipientListChanged = true;
+}
+
+void bacnet::notificationClassSetRecipientList(BACnetObject& object,
+                                               const std::vector<BACNET_DESTINATION>& recipient_list) {
+    object.nc_irp->recipient_list = recipient_list;
+    notificationClassRecipientListChanged(object.instance);
+}
+
+void bacnet::notificationClassForgetRecipients(void) {
+    resolver = RecipientResolver();
 }
 
 /* This function tries to find the addresses of the defined devices. */
 /* It should be called periodically (example once per minute). */
+/* Only notification classes that changed since the last call are read again. The unresolved devices of all */
+/* notification classes are asked for with as few Who-Is requests as possible, one per run of consecutive */
+/* device identifiers. */
 void bacnet::notificationClassFindRecipient(void) {
     BACNET_ADDRESS src = {0};
     unsigned max_apdu = 0;
-    uint32_t DeviceID;
+    time_t now = time(nullptr);
 
-    for (const auto& object : container.getDeviceObject()->objects) {
-        if (object->type == OBJECT_NOTIFICATION_CLASS) {
-            std::vector<BACNET_DESTINATION> recipient_list;
-            recipient_list.reserve(NC_MAX_RECIPIENTS);
-            object->read.recipient_list(object->instance, recipient_list);
+    updateRecipients();
 
-            for (auto& recipient : recipient_list) {
-                if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_DEVICE) {
-                    /* Device ID */
-                    DeviceID = recipient.Recipient._.DeviceIdentifier;
-                    /* Send who_ is request only when address of device is unknown. */
-                    if (!address_bind_request(DeviceID, &max_apdu, &src))
-                        Send_WhoIs(DeviceID, DeviceID);
-                } else if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_ADDRESS) {
-                    if (recipient.ConfirmedNotify) {
-                        auto addr = recipient.Recipient._.Address;
-                        if (!address_bind_request(DeviceID, &max_apdu, &addr)) {
-                            if (!address_get_device_id(&addr, &DeviceID))
-                                Send_WhoIs(DeviceID, DeviceID);
-                        }
-                    }
-                }
-            }
+    std::set<uint32_t> devices;
+    std::map<std::string, BACNET_ADDRESS> addresses;
+    for (const auto& nc : resolver.recipients) {
+        devices.insert(nc.second.devices.begin(), nc.second.devices.end());
+        for (const auto& address : nc.second.addresses)
+            addresses.emplace(addressKey(address), address);
+    }
+
+    /* Devices: request a binding and ask for those that are still unknown */
+    std::vector<uint32_t> unresolved;
+    for (auto DeviceID : devices) {
+        if (address_bind_request(DeviceID, &max_apdu, &src)) {
+            resolver.device_backoff.erase(DeviceID);
+            continue;
         }
+        if (whoIsDue(resolver.device_backoff[DeviceID], now))
+            unresolved.push_back(DeviceID);
+    }
+
+    for (size_t first = 0; first < unresolved.size();) {
+        size_t last = first;
+        while (last + 1 < unresolved.size() && unresolved[last + 1] == unresolved[last] + 1)
+            last++;
+
+        Send_WhoIs(unresolved[first], unresolved[last]);
+        first = last + 1;
+    }
+
+    /* Addresses: ask the address itself for its device identifier */
+    for (auto& address : addresses) {
+        uint32_t DeviceID;
+        if (address_get_device_id(&address.second, &DeviceID)) {
+            resolver.address_backoff.erase(address.first);
+            continue;
+        }
+        if (whoIsDue(resolver.address_backoff[address.first], now))
+            Send_WhoIs_To_Network(&address.second, -1, -1);
+    }
+
+    /* Forget recipients that were removed from every notification class */
+    for (auto it = resolver.device_backoff.begin(); it != resolver.device_backoff.end();) {
+        if (devices.count(it->first) == 0)
+            it = resolver.device_backoff.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = resolver.address_backoff.begin(); it != resolver.address_backoff.end();) {
+        if (addresses.count(it->first) == 0)
+            it = resolver.address_backoff.erase(it);
+        else
+            ++it;
     }
 }
 
@@ -851,7 +1117,7 @@ void bacnet::init_notification_class_object_handlers(ObjectTypeHandler& handler)
     handler.write_property = notification_class_write_property;
     handler.rpm_property_list = notification_class_property_lists;
 
-    handler.intrinsic_reporting = [](const BACnetObject&) {
+    handler.intrinsic_reporting = [](BACnetObject&) {
 
     };
 
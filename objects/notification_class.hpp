@@ -94,6 +94,15 @@ void notificationClassCommonReportingFunction(BACNET_EVENT_NOTIFICATION_DATA* ev
 
 void notificationClassFindRecipient(void);
 
+/* Have notificationClassFindRecipient() read the recipient list of the notification class again */
+void notificationClassRecipientListChanged(uint32_t object_instance);
+
+/* Replace the recipient list of a notification class */
+void notificationClassSetRecipientList(BACnetObject& object, const std::vector<BACNET_DESTINATION>& recipient_list);
+
+/* Drop everything known about the recipients, after the objects were reset */
+void notificationClassForgetRecipients(void);
+
 void init_notification_class_object_handlers(ObjectTypeHandler& handler);
 
 } // namespace bacnet
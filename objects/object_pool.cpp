@@ -0,0 +1,69 @@
+#include "object_pool.hpp"
+#include "callbacks.hpp"
+
+#include <algorithm>
+
+using namespace bacnet;
+
+static_assert(sizeof(void*) <= ObjectPool::alignment, "a block must be able to hold a free list link");
+
+ObjectPool::ObjectPool(size_t blocks_per_chunk)
+    : blocks_per_chunk(blocks_per_chunk)
+    , free_blocks() {
+}
+
+void* ObjectPool::allocate(size_t size) {
+    if (size > max_block_size)
+        return ::operator new(size);
+
+    size_t size_class = (std::max<size_t>(size, 1) - 1) / alignment;
+    size_t block_size = (size_class + 1) * alignment;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (free_blocks[size_class] == nullptr) {
+        std::unique_ptr<unsigned char[]> chunk(new unsigned char[block_size * blocks_per_chunk]);
+        for (size_t i = blocks_per_chunk; i-- > 0;) {
+            auto block = reinterpret_cast<FreeBlock*>(&chunk[i * block_size]);
+            block->next = free_blocks[size_class];
+            free_blocks[size_class] = block;
+        }
+        chunks.push_back(std::move(chunk));
+    }
+
+    FreeBlock* block = free_blocks[size_class];
+    free_blocks[size_class] = block->next;
+    return block;
+}
+
+void ObjectPool::deallocate(void* block, size_t size) {
+    if (block == nullptr)
+        return;
+
+    if (size > max_block_size) {
+        ::operator delete(block);
+        return;
+    }
+
+    size_t size_class = (std::max<size_t>(size, 1) - 1) / alignment;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto free_block = static_cast<FreeBlock*>(block);
+    free_block->next = free_blocks[size_class];
+    free_blocks[size_class] = free_block;
+}
+
+// Never destroyed, objects held by a static BACnet instance release their callbacks after main() returned
+static ObjectPool& callbackPool() {
+    static ObjectPool* pool = new ObjectPool(256);
+    return *pool;
+}
+
+void* bacnet::allocateCallbackBlock(size_t size) {
+    return callbackPool().allocate(size);
+}
+
+void bacnet::releaseCallbackBlock(void* block, size_t size) {
+    callbackPool().deallocate(block, size);
+}
@@ -0,0 +1,97 @@
+#ifndef BACNET_OBJECT_POOL_HPP
+#define BACNET_OBJECT_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace bacnet {
+
+    /**
+     * Blocks carved out of large chunks, one chunk list per size class. Freed blocks are kept for the next
+     * allocation of their size class, so objects added again after a reset reuse the memory of the previous
+     * ones instead of fragmenting the heap. Safe to use from any thread.
+     */
+    class ObjectPool {
+      public:
+        explicit ObjectPool(size_t blocks_per_chunk = 1024);
+        ObjectPool(const ObjectPool &) = delete;
+        ObjectPool &operator=(const ObjectPool &) = delete;
+
+        /**
+         * Allocate a block of at least size bytes. Sizes are rounded up to a multiple of the maximum
+         * alignment, requests larger than max_block_size fall back to operator new.
+         */
+        void *allocate(size_t size);
+
+        /**
+         * Return a block to the pool.
+         *
+         * @param size The size passed to allocate()
+         */
+        void deallocate(void *block, size_t size);
+
+        static const size_t alignment = alignof(std::max_align_t);
+        static const size_t max_block_size = 2048;
+
+      private:
+        struct FreeBlock {
+            FreeBlock *next;
+        };
+
+        std::mutex mutex;
+        const size_t blocks_per_chunk;
+        std::vector<std::unique_ptr<unsigned char[]>> chunks;
+        // free list of every size class, blocks of class i are (i + 1) * alignment bytes
+        FreeBlock *free_blocks[max_block_size / alignment];
+    };
+
+    /**
+     * Allocator for std::allocate_shared() that takes single objects from an ObjectPool.
+     * The pool is shared, so it stays alive for as long as any object allocated from it.
+     */
+    template <typename T>
+    class ObjectPoolAllocator {
+      public:
+        typedef T value_type;
+
+        explicit ObjectPoolAllocator(std::shared_ptr<ObjectPool> pool) : pool(std::move(pool)) {}
+
+        template <typename U>
+        ObjectPoolAllocator(const ObjectPoolAllocator<U> &other) : pool(other.pool) {}
+
+        T *allocate(size_t n) {
+            if (n != 1)
+                return static_cast<T *>(::operator new(n * sizeof(T)));
+            return static_cast<T *>(pool->allocate(sizeof(T)));
+        }
+
+        void deallocate(T *p, size_t n) {
+            if (n != 1)
+                ::operator delete(p);
+            else
+                pool->deallocate(p, sizeof(T));
+        }
+
+        template <typename U>
+        bool operator==(const ObjectPoolAllocator<U> &other) const {
+            return pool == other.pool;
+        }
+
+        template <typename U>
+        bool operator!=(const ObjectPoolAllocator<U> &other) const {
+            return pool != other.pool;
+        }
+
+      private:
+        template <typename U>
+        friend class ObjectPoolAllocator;
+
+        std::shared_ptr<ObjectPool> pool;
+    };
+
+} // namespace bacnet
+
+#endif /* BACNET_OBJECT_POOL_HPP */
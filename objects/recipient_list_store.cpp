@@ -0,0 +1,860 @@
+#include "recipient_list_store.hpp"
+#include "keys.h"
+
+#include "Poco/Crypto/Cipher.h"
+#include "Poco/Crypto/CipherFactory.h"
+#include "Poco/Crypto/CipherKey.h"
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/HMACEngine.h>
+#include <Poco/RandomStream.h>
+#include <Poco/SHA2Engine.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+/* secret the file keys are derived from, defaults to the password of the device key */
+#ifndef RECIPIENT_LIST_KEY
+#define RECIPIENT_LIST_KEY PRIVATE_KEY_PASSWORD
+#endif
+
+using namespace bacnet;
+using namespace Poco::Crypto;
+
+namespace {
+
+// File layout, all integers little endian:
+//   magic "BRLS", format version (u8), IV (16 bytes), ciphertext length (u32), ciphertext,
+//   HMAC-SHA256 of everything before it (32 bytes)
+// Plaintext: notification class count (u16), then per notification class its name length (u16), name,
+// recipient count (u16) and recipients, see encodeRecipient()
+const char FILE_MAGIC[4] = {'B', 'R', 'L', 'S'};
+const uint8_t FILE_VERSION = 1;
+const size_t IV_SIZE = 16;
+const size_t MAC_SIZE = 32;
+const size_t HEADER_SIZE = sizeof(FILE_MAGIC) + 1 + IV_SIZE + 4;
+
+// bursts of changes within this time are written once
+const std::chrono::milliseconds COALESCE_DELAY(200);
+// a snapshot that failed to be written is tried again after this time
+const std::chrono::milliseconds RETRY_DELAY(5000);
+
+const std::string CIPHER_NAME = "aes-256-cbc";
+
+void putU8(std::string& out, uint8_t value) {
+    out.push_back((char)value);
+}
+
+void putU16(std::string& out, uint16_t value) {
+    out.push_back((char)(value & 0xFF));
+    out.push_back((char)(value >> 8));
+}
+
+void putU32(std::string& out, uint32_t value) {
+    putU16(out, (uint16_t)(value & 0xFFFF));
+    putU16(out, (uint16_t)(value >> 16));
+}
+
+// reads from a buffer, once a read runs past its end all further reads fail
+struct Reader {
+    const std::string& in;
+    size_t pos;
+    bool ok;
+
+    explicit Reader(const std::string& in, size_t pos = 0) : in(in), pos(pos), ok(true) {}
+
+    bool take(size_t count) {
+        ok = ok && count <= in.size() - pos;
+        return ok;
+    }
+
+    uint8_t u8() {
+        if (!take(1))
+            return 0;
+        return (uint8_t)in[pos++];
+    }
+
+    uint16_t u16() {
+        uint16_t low = u8();
+        return (uint16_t)(low | (u8() << 8));
+    }
+
+    uint32_t u32() {
+        uint32_t low = u16();
+        return low | ((uint32_t)u16() << 16);
+    }
+
+    std::string bytes(size_t count) {
+        if (!take(count))
+            return std::string();
+        pos += count;
+        return in.substr(pos - count, count);
+    }
+};
+
+void encodeTime(std::string& out, const BACNET_TIME& time) {
+    putU8(out, time.hour);
+    putU8(out, time.min);
+    putU8(out, time.sec);
+    putU8(out, time.hundredths);
+}
+
+void decodeTime(Reader& in, BACNET_TIME& time) {
+    time.hour = in.u8();
+    time.min = in.u8();
+    time.sec = in.u8();
+    time.hundredths = in.u8();
+}
+
+// an address field is stored as its length followed by that many bytes
+void encodeAddressField(std::string& out, const uint8_t* field, uint8_t length) {
+    length = std::min<uint8_t>(length, MAX_MAC_LEN);
+    putU8(out, length);
+    out.append((const char*)field, length);
+}
+
+uint8_t decodeAddressField(Reader& in, uint8_t* field) {
+    uint8_t length = in.u8();
+    std::string bytes = in.bytes(length);
+    if (length > MAX_MAC_LEN) {
+        in.ok = false;
+        return 0;
+    }
+    memcpy(field, bytes.data(), bytes.size());
+    return length;
+}
+
+void encodeRecipient(std::string& out, const BACNET_DESTINATION& recipient) {
+    putU8(out, recipient.ValidDays);
+    encodeTime(out, recipient.FromTime);
+    encodeTime(out, recipient.ToTime);
+    putU32(out, recipient.ProcessIdentifier);
+    putU8(out, recipient.Transitions);
+    putU8(out, recipient.ConfirmedNotify ? 1 : 0);
+    putU8(out, recipient.Recipient.RecipientType);
+    if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_DEVICE) {
+        putU32(out, recipient.Recipient._.DeviceIdentifier);
+    } else if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_ADDRESS) {
+        const BACNET_ADDRESS& address = recipient.Recipient._.Address;
+        encodeAddressField(out, address.mac, address.mac_len);
+        putU16(out, address.net);
+        encodeAddressField(out, address.adr, address.len);
+    }
+}
+
+void decodeRecipient(Reader& in, BACNET_DESTINATION& recipient) {
+    memset(&recipient, 0, sizeof(recipient));
+    recipient.ValidDays = in.u8();
+    decodeTime(in, recipient.FromTime);
+    decodeTime(in, recipient.ToTime);
+    recipient.ProcessIdentifier = in.u32();
+    recipient.Transitions = in.u8();
+    recipient.ConfirmedNotify = in.u8() != 0;
+    recipient.Recipient.RecipientType = in.u8();
+    if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_DEVICE) {
+        recipient.Recipient._.DeviceIdentifier = in.u32();
+    } else if (recipient.Recipient.RecipientType == RECIPIENT_TYPE_ADDRESS) {
+        BACNET_ADDRESS& address = recipient.Recipient._.Address;
+        address.mac_len = decodeAddressField(in, address.mac);
+        address.net = in.u16();
+        address.len = decodeAddressField(in, address.adr);
+    }
+}
+
+std::string encodeLists(const RecipientLists& lists) {
+    std::string out;
+
+    putU16(out, (uint16_t)lists.size());
+    for (const auto& nc : lists) {
+        putU16(out, (uint16_t)nc.first.size());
+        out.append(nc.first);
+        putU16(out, (uint16_t)nc.second.size());
+        for (const auto& recipient : nc.second)
+            encodeRecipient(out, recipient);
+    }
+
+    return out;
+}
+
+bool decodeLists(const std::string& in, RecipientLists& lists) {
+    Reader reader(in);
+
+    lists.clear();
+    unsigned nc_count = reader.u16();
+    for (unsigned i = 0; i < nc_count && reader.ok; i++) {
+        std::string name = reader.bytes(reader.u16());
+        std::vector<BACNET_DESTINATION> recipients(reader.u16());
+        for (auto& recipient : recipients)
+            decodeRecipient(reader, recipient);
+        lists.emplace_back(std::move(name), std::move(recipients));
+    }
+
+    return reader.ok && reader.pos == in.size();
+}
+
+// the encryption and MAC keys are derived from the secret once, key derivation is slow on purpose
+const CipherKey::ByteVec& encryptionKey() {
+    static const CipherKey::ByteVec key =
+        CipherKey(CIPHER_NAME, RECIPIENT_LIST_KEY, "recipient list cipher", 10000, "sha256").getKey();
+    return key;
+}
+
+const CipherKey::ByteVec& macKey() {
+    static const CipherKey::ByteVec key =
+        CipherKey(CIPHER_NAME, RECIPIENT_LIST_KEY, "recipient list mac", 10000, "sha256").getKey();
+    return key;
+}
+
+std::string hmacSha256(const std::string& data) {
+    const CipherKey::ByteVec& key = macKey();
+
+    Poco::HMACEngine<Poco::SHA2Engine> hmac(reinterpret_cast<const char*>(key.data()), key.size());
+    hmac.update(data);
+    const auto& digest = hmac.digest();
+
+    return std::string(digest.begin(), digest.end());
+}
+
+// compares in constant time, so a forged MAC can't be found byte by byte
+bool macEqual(const std::string& a, const std::string& b) {
+    if (a.size() != b.size())
+        return false;
+
+    unsigned char difference = 0;
+    for (size_t i = 0; i < a.size(); i++)
+        difference |= (unsigned char)(a[i] ^ b[i]);
+
+    return difference == 0;
+}
+
+Cipher::Ptr createCipher(const std::string& iv) {
+    CipherKey key(CIPHER_NAME, encryptionKey(), CipherKey::ByteVec(iv.begin(), iv.end()));
+    return CipherFactory::defaultFactory().createCipher(key);
+}
+
+// moves a file that failed authentication out of the way, so the next save doesn't overwrite it unnoticed
+void setAside(const std::string& path) {
+    std::string corrupt_path = path + ".corrupt";
+    if (::rename(path.c_str(), corrupt_path.c_str()) != 0) {
+#if PRINT_ENABLED
+        fprintf(stderr, "Recipient list %s: can't rename to %s: %s\n", path.c_str(), corrupt_path.c_str(),
+            strerror(errno));
+#endif
+        return;
+    }
+
+#if PRINT_ENABLED
+    fprintf(stderr, "Recipient list %s failed authentication, kept as %s\n", path.c_str(), corrupt_path.c_str());
+#endif
+}
+
+bool writeFully(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t len = ::write(fd, data.data() + written, data.size() - written);
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        written += (size_t)len;
+    }
+
+    return true;
+}
+
+} // namespace
+
+RecipientListStore::RecipientListStore(const std::string& path)
+    : path(path)
+    , has_pending(false)
+    , writing(false)
+    , flushing(false)
+    , stopping(false)
+    , failed(false)
+    , attempts(0) {
+}
+
+RecipientListStore::~RecipientListStore() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+
+    // the thread writes a queued snapshot before it exits
+    if (thread.joinable())
+        thread.join();
+}
+
+bool RecipientListStore::exists() const {
+    return Poco::File(path).exists();
+}
+
+bool RecipientListStore::load(RecipientLists& lists) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (content.size() < HEADER_SIZE + MAC_SIZE)
+        return false;
+
+    if (memcmp(content.data(), FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || (uint8_t)content[4] != FILE_VERSION)
+        return false;
+
+    try {
+        // authenticate before decrypting anything
+        std::string authenticated = content.substr(0, content.size() - MAC_SIZE);
+        if (!macEqual(hmacSha256(authenticated), content.substr(content.size() - MAC_SIZE))) {
+            setAside(path);
+            return false;
+        }
+
+        Reader header(authenticated, sizeof(FILE_MAGIC) + 1);
+        std::string iv = header.bytes(IV_SIZE);
+        uint32_t ciphertext_len = header.u32();
+        if (!header.ok || ciphertext_len != authenticated.size() - HEADER_SIZE)
+            return false;
+
+        std::string plaintext = createCipher(iv)->decryptString(authenticated.substr(HEADER_SIZE));
+        return decodeLists(plaintext, lists);
+    } catch (Poco::Exception& e) {
+#if PRINT_ENABLED
+        fprintf(stderr, "Error %s; Message: %s\n", e.what(), e.message().c_str());
+#endif
+        return false;
+    }
+}
+
+void RecipientListStore::save(RecipientLists lists) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = std::move(lists);
+        has_pending = true;
+        if (!thread.joinable())
+            thread = std::thread(&RecipientListStore::run, this);
+    }
+    changed.notify_all();
+}
+
+void RecipientListStore::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!thread.joinable())
+        return;
+
+    // a snapshot that can't be written stays queued, so give up after the next attempt at it
+    unsigned last_attempt = attempts + (writing ? 1 : 0);
+    flushing = true;
+    changed.notify_all();
+    changed.wait(lock, [this, last_attempt]() { return (!has_pending && !writing) || attempts > last_attempt; });
+    flushing = false;
+}
+
+void RecipientListStore::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        changed.wait(lock, [this]() { return has_pending || stopping; });
+        if (!has_pending)
+            break;
+
+        // let a burst of changes settle, later snapshots replace the pending one meanwhile
+        changed.wait_for(lock, failed ? RETRY_DELAY : COALESCE_DELAY, [this]() { return flushing || stopping; });
+
+        RecipientLists lists = std::move(pending);
+        has_pending = false;
+        writing = true;
+
+        lock.unlock();
+        bool written = write(lists);
+        lock.lock();
+
+        writing = false;
+        failed = !written;
+        attempts++;
+        if (!written) {
+#if PRINT_ENABLED
+            fprintf(stderr, "Recipient list file %s can't be written.\n", path.c_str());
+#endif
+            // keep the snapshot for a retry, unless a newer one replaced it or the store is closing
+            if (!has_pending && !stopping) {
+                pending = std::move(lists);
+                has_pending = true;
+            }
+        }
+        changed.notify_all();
+    }
+}
+
+bool RecipientListStore::write(const RecipientLists& lists) {
+    std::string file;
+
+    try {
+        std::string iv(IV_SIZE, '\0');
+        Poco::RandomInputStream().read(&iv[0], IV_SIZE);
+
+        std::string ciphertext = createCipher(iv)->encryptString(encodeLists(lists));
+
+        file.append(FILE_MAGIC, sizeof(FILE_MAGIC));
+        putU8(file, FILE_VERSION);
+        file.append(iv);
+        putU32(file, (uint32_t)ciphertext.size());
+        file.append(ciphertext);
+        file.append(hmacSha256(file));
+    } catch (Poco::Exception& e) {
+#if PRINT_ENABLED
+        fprintf(stderr, "Error %s; Message: %s\n", e.what(), e.message().c_str());
+#endif
+        return false;
+    }
+
+    // write a temporary file next to the target and rename it over the target once it is on disk
+    std::string temporary_path = path + ".tmp";
+    int fd = ::open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0)
+        return false;
+
+    bool written = writeFully(fd, file) && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!written || ::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary_path.c_str());
+        return false;
+    }
+
+    // make the rename itself durable
+    std::string directory = path.substr(0, path.find_last_of('/') + 1);
+    int dir_fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+
+    return true;
+}
+
+namespace {
+
+// Single pass parser for the JSON recipient list of earlier versions:
+// {"notification_classes": [{"nc_object_name": "...", "recipients": [{...}, ...]}, ...]}
+class RecipientListJsonParser {
+  public:
+    explicit RecipientListJsonParser(const std::string& json) : it(json.data()), end(json.data() + json.size()) {}
+
+    bool parse(RecipientLists& lists) {
+        bool ok = object([&](const std::string& key) {
+            if (key != "notification_classes")
+                return skipValue();
+            return array([&]() { return notificationClass(lists); });
+        });
+
+        skipWhitespace();
+        return ok && it == end;
+    }
+
+  private:
+    const char* it;
+    const char* end;
+
+    // a recipient as read, its address fields only apply to the recipient type they belong to
+    struct Recipient {
+        BACNET_DESTINATION destination;
+        uint32_t device_identifier;
+        BACNET_ADDRESS address;
+    };
+
+    void skipWhitespace() {
+        while (it != end && (*it == ' ' || *it == '\t' || *it == '\n' || *it == '\r'))
+            ++it;
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (it == end || *it != c)
+            return false;
+        ++it;
+        return true;
+    }
+
+    bool peek(char c) {
+        skipWhitespace();
+        return it != end && *it == c;
+    }
+
+    // calls member(key) for every member, which must consume the value
+    template <typename Member>
+    bool object(Member member) {
+        if (!consume('{'))
+            return false;
+        if (consume('}'))
+            return true;
+
+        do {
+            std::string key;
+            if (!string(key) || !consume(':') || !member(key))
+                return false;
+        } while (consume(','));
+
+        return consume('}');
+    }
+
+    // calls element() for every element, which must consume it
+    template <typename Element>
+    bool array(Element element) {
+        if (!consume('['))
+            return false;
+        if (consume(']'))
+            return true;
+
+        do {
+            if (!element())
+                return false;
+        } while (consume(','));
+
+        return consume(']');
+    }
+
+    bool string(std::string& value) {
+        if (!consume('"'))
+            return false;
+
+        value.clear();
+        while (it != end && *it != '"') {
+            char c = *it++;
+            if ((unsigned char)c < 0x20)
+                return false;
+            if (c != '\\') {
+                value.push_back(c);
+                continue;
+            }
+            if (it == end)
+                return false;
+
+            c = *it++;
+            switch (c) {
+            case '"':
+            case '\\':
+            case '/':
+                value.push_back(c);
+                break;
+            case 'b':
+                value.push_back('\b');
+                break;
+            case 'f':
+                value.push_back('\f');
+                break;
+            case 'n':
+                value.push_back('\n');
+                break;
+            case 'r':
+                value.push_back('\r');
+                break;
+            case 't':
+                value.push_back('\t');
+                break;
+            case 'u': {
+                unsigned code;
+                if (!hex4(code) || (code >= 0xDC00 && code <= 0xDFFF))
+                    return false;
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    // a high surrogate must be followed by the escaped low surrogate of the pair
+                    unsigned low;
+                    if (end - it < 2 || it[0] != '\\' || it[1] != 'u')
+                        return false;
+                    it += 2;
+                    if (!hex4(low) || low < 0xDC00 || low > 0xDFFF)
+                        return false;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                // object names are ANSI X3.4, anything else is kept as UTF-8
+                utf8(code, value);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+
+        return it++ != end;
+    }
+
+    // the four hex digits of a \u escape
+    bool hex4(unsigned& code) {
+        if (end - it < 4)
+            return false;
+
+        code = 0;
+        for (int i = 0; i < 4; i++, ++it) {
+            char c = *it;
+            if (!isxdigit((unsigned char)c))
+                return false;
+            unsigned digit = isdigit((unsigned char)c) ? c - '0' : tolower((unsigned char)c) - 'a' + 10;
+            code = (code << 4) | digit;
+        }
+        return true;
+    }
+
+    static void utf8(unsigned code, std::string& value) {
+        if (code < 0x80) {
+            value.push_back((char)code);
+        } else if (code < 0x800) {
+            value.push_back((char)(0xC0 | (code >> 6)));
+            value.push_back((char)(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            value.push_back((char)(0xE0 | (code >> 12)));
+            value.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+            value.push_back((char)(0x80 | (code & 0x3F)));
+        } else {
+            value.push_back((char)(0xF0 | (code >> 18)));
+            value.push_back((char)(0x80 | ((code >> 12) & 0x3F)));
+            value.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+            value.push_back((char)(0x80 | (code & 0x3F)));
+        }
+    }
+
+    bool digits() {
+        const char* start = it;
+        while (it != end && isdigit((unsigned char)*it))
+            ++it;
+        return it != start;
+    }
+
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool number(double& value) {
+        skipWhitespace();
+
+        const char* start = it;
+        if (it != end && *it == '-')
+            ++it;
+        if (it != end && *it == '0')
+            ++it;
+        else if (!digits())
+            return false;
+        if (it != end && *it == '.') {
+            ++it;
+            if (!digits())
+                return false;
+        }
+        if (it != end && (*it == 'e' || *it == 'E')) {
+            ++it;
+            if (it != end && (*it == '+' || *it == '-'))
+                ++it;
+            if (!digits())
+                return false;
+        }
+
+        std::string text(start, it);
+        char* text_end = nullptr;
+        errno = 0;
+        value = strtod(text.c_str(), &text_end);
+        return text_end == text.c_str() + text.size() && !(errno == ERANGE && std::fabs(value) == HUGE_VAL);
+    }
+
+    // the integer type a field is stored in, enums by their underlying type
+    template <typename T, bool = std::is_enum<T>::value>
+    struct Integer {
+        using type = T;
+    };
+    template <typename T>
+    struct Integer<T, true> {
+        using type = typename std::underlying_type<T>::type;
+    };
+
+    // integral fields only take whole numbers that fit them
+    template <typename T>
+    bool number(T& value) {
+        using Limits = std::numeric_limits<typename Integer<T>::type>;
+        static_assert(Limits::is_integer, "number() is for integral fields");
+
+        double parsed;
+        if (!number(parsed))
+            return false;
+        if (parsed != std::floor(parsed) || parsed < (double)Limits::min() || parsed > (double)Limits::max())
+            return false;
+
+        value = (T)(typename Integer<T>::type)parsed;
+        return true;
+    }
+
+    bool boolean(bool& value) {
+        skipWhitespace();
+        if (end - it >= 4 && strncmp(it, "true", 4) == 0) {
+            value = true;
+            it += 4;
+            return true;
+        }
+        if (end - it >= 5 && strncmp(it, "false", 5) == 0) {
+            value = false;
+            it += 5;
+            return true;
+        }
+
+        // stored as a number by some writers
+        unsigned number_value = 0;
+        if (!number(number_value))
+            return false;
+        value = number_value != 0;
+        return true;
+    }
+
+    bool skipValue() {
+        skipWhitespace();
+        if (it == end)
+            return false;
+
+        switch (*it) {
+        case '{':
+            return object([&](const std::string&) { return skipValue(); });
+        case '[':
+            return array([&]() { return skipValue(); });
+        case '"': {
+            std::string ignored;
+            return string(ignored);
+        }
+        case 't':
+        case 'f': {
+            bool ignored;
+            return boolean(ignored);
+        }
+        case 'n':
+            if (end - it < 4 || strncmp(it, "null", 4) != 0)
+                return false;
+            it += 4;
+            return true;
+        default: {
+            double ignored;
+            return number(ignored);
+        }
+        }
+    }
+
+    // "a;b;c" with one decimal number per byte, at most MAX_MAC_LEN of them and an optional trailing ';'
+    bool addressBytes(uint8_t* bytes) {
+        std::string value;
+        if (!string(value))
+            return false;
+
+        const char* p = value.c_str();
+        for (unsigned i = 0; *p != '\0'; i++) {
+            if (i == MAX_MAC_LEN || !isdigit((unsigned char)*p))
+                return false;
+
+            char* next = nullptr;
+            errno = 0;
+            unsigned long byte = strtoul(p, &next, 10);
+            if (errno == ERANGE || byte > 0xFF || (*next != ';' && *next != '\0'))
+                return false;
+
+            bytes[i] = (uint8_t)byte;
+            p = *next == ';' ? next + 1 : next;
+        }
+
+        return true;
+    }
+
+    bool time(BACNET_TIME& time) {
+        return object([&](const std::string& key) {
+            if (key == "hour")
+                return number(time.hour);
+            if (key == "min")
+                return number(time.min);
+            if (key == "sec")
+                return number(time.sec);
+            if (key == "hundredths")
+                return number(time.hundredths);
+            return skipValue();
+        });
+    }
+
+    bool address(BACNET_ADDRESS& address) {
+        return object([&](const std::string& key) {
+            if (key == "adr")
+                return addressBytes(address.adr);
+            if (key == "len")
+                return number(address.len);
+            if (key == "mac")
+                return addressBytes(address.mac);
+            if (key == "mac_len")
+                return number(address.mac_len);
+            if (key == "net")
+                return number(address.net);
+            return skipValue();
+        });
+    }
+
+    bool recipient(std::vector<BACNET_DESTINATION>& recipients) {
+        Recipient recipient;
+        memset(&recipient, 0, sizeof(recipient));
+
+        BACNET_DESTINATION& destination = recipient.destination;
+        bool ok = object([&](const std::string& key) {
+            if (key == "device_identifier")
+                return number(recipient.device_identifier);
+            if (key == "recipient_type")
+                return number(destination.Recipient.RecipientType);
+            if (key == "address")
+                return address(recipient.address);
+            if (key == "valid_days")
+                return number(destination.ValidDays);
+            if (key == "from_time")
+                return time(destination.FromTime);
+            if (key == "to_time")
+                return time(destination.ToTime);
+            if (key == "process_identifier")
+                return number(destination.ProcessIdentifier);
+            if (key == "transitions")
+                return number(destination.Transitions);
+            if (key == "confirmed_notify")
+                return boolean(destination.ConfirmedNotify);
+            return skipValue();
+        });
+        if (!ok)
+            return false;
+
+        if (destination.Recipient.RecipientType == RECIPIENT_TYPE_DEVICE)
+            destination.Recipient._.DeviceIdentifier = recipient.device_identifier;
+        else if (destination.Recipient.RecipientType == RECIPIENT_TYPE_ADDRESS)
+            destination.Recipient._.Address = recipient.address;
+
+        recipients.push_back(destination);
+        return true;
+    }
+
+    bool notificationClass(RecipientLists& lists) {
+        std::string name;
+        std::vector<BACNET_DESTINATION> recipients;
+
+        bool ok = object([&](const std::string& key) {
+            if (key == "nc_object_name")
+                return string(name);
+            if (key == "recipients")
+                return array([&]() { return recipient(recipients); });
+            return skipValue();
+        });
+        if (!ok)
+            return false;
+
+        lists.emplace_back(std::move(name), std::move(recipients));
+        return true;
+    }
+};
+
+} // namespace
+
+bool bacnet::parseRecipientListJson(const std::string& json, RecipientLists& lists) {
+    lists.clear();
+    return RecipientListJsonParser(json).parse(lists);
+}
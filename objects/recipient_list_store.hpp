@@ -0,0 +1,78 @@
+#ifndef BACNET_RECIPIENT_LIST_STORE_HPP
+#define BACNET_RECIPIENT_LIST_STORE_HPP
+
+#include "notification_class.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bacnet {
+
+// Recipient lists of the notification classes by object name
+typedef std::vector<std::pair<std::string, std::vector<BACNET_DESTINATION>>> RecipientLists;
+
+// Saves recipient lists in a versioned binary file, encrypted with AES-256-CBC and authenticated with
+// HMAC-SHA256. Saving happens on a background thread: the file is replaced atomically with the latest
+// snapshot, so a burst of changes is written once and a crash leaves either the old or the new file.
+class RecipientListStore {
+  public:
+    explicit RecipientListStore(const std::string& path);
+    ~RecipientListStore();
+
+    RecipientListStore(const RecipientListStore&) = delete;
+    RecipientListStore& operator=(const RecipientListStore&) = delete;
+
+    /**
+     * Read the recipient lists from the file. A file that fails authentication is renamed to
+     * <path>.corrupt, so it is kept for inspection instead of being replaced by the next save.
+     *
+     * @return false if there is no file, or it can't be read, decrypted or authenticated
+     */
+    bool load(RecipientLists& lists);
+
+    /**
+     * Queue recipient lists to be written, replacing any snapshot that is still queued.
+     * Returns right away, the file is written on the background thread.
+     */
+    void save(RecipientLists lists);
+
+    /**
+     * Wait until a queued snapshot has been written, or one more attempt to write it failed.
+     */
+    void flush();
+
+    bool exists() const;
+
+  private:
+    void run();
+    bool write(const RecipientLists& lists);
+
+    const std::string path;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread thread;
+    RecipientLists pending;
+    bool has_pending;
+    bool writing;
+    bool flushing;
+    bool stopping;
+    // the last write failed, its snapshot is queued again for a retry
+    bool failed;
+    unsigned attempts;
+};
+
+/**
+ * Parse the JSON recipient list written by earlier versions in a single pass, straight into the
+ * recipient lists. Unknown members are skipped.
+ *
+ * @return false if the document is malformed, or a value doesn't fit the field it is read into
+ */
+bool parseRecipientListJson(const std::string& json, RecipientLists& lists);
+
+} // namespace bacnet
+
+#endif /* BACNET_RECIPIENT_LIST_STORE_HPP */
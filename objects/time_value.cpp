@@ -24,6 +24,7 @@
  *********************************************************************/
 
 #include "time_value.hpp"
+#include "cov_value_list.hpp"
 #include "bacnet.hpp"
 #include "custom_bacnet_config.h"
 #include "handlers.h"
@@ -76,7 +77,10 @@ static unsigned time_value_read_property(const BACnetObject& object, BACNET_READ
 
     case PROP_PRESENT_VALUE: {
         BACNET_TIME present_value;
-        object.read.present_value_time(rpdata->object_instance, &present_value);
+        if (object.present_value.enabled)
+            present_value = object.present_value.load<BACNET_TIME>();
+        else
+            object.read.present_value_time(rpdata->object_instance, &present_value);
         apdu_len = encode_application_time(&apdu[0], &present_value);
         break;
     }
@@ -189,6 +193,10 @@ static bool time_value_write_property(BACnetObject& object, BACNET_WRITE_PROPERT
 
                 return status;
             }
+
+            // the application accepted the value, serve it to readers right away
+            if (object.present_value.enabled)
+                object.present_value.store(value.type.Time);
         }
 
         break;
@@ -224,12 +232,35 @@ static void time_value_rpm_property_list(const int** pRequired, const int** pOpt
         *pProprietary = TV_Properties_Proprietary;
 }
 
+static bool time_value_encode_value_list(const BACnetObject& object,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE* value_list) {
+    bool out_of_service = false;
+
+    if ((value_list == nullptr) || (value_list->next == nullptr))
+        return false;
+
+    BACNET_TIME present_value;
+    if (object.present_value.enabled)
+        present_value = object.present_value.load<BACNET_TIME>();
+    else
+        object.read.present_value_time(object_instance, &present_value);
+    value_list->value.tag = BACNET_APPLICATION_TAG_TIME;
+    value_list->value.type.Time = present_value;
+
+    if (object.read.out_of_service)
+        object.read.out_of_service(object_instance, &out_of_service);
+
+    return encode_cov_value_list(value_list, false, out_of_service);
+}
+
 void bacnet::init_time_value_object_handlers(ObjectTypeHandler& handler) {
     handler.read_property = time_value_read_property;
     handler.write_property = time_value_write_property;
     handler.rpm_property_list = time_value_rpm_property_list;
+    handler.value_list = time_value_encode_value_list;
 
-    handler.intrinsic_reporting = [](const BACnetObject&) {
+    handler.intrinsic_reporting = [](BACnetObject&) {
 
     };
 
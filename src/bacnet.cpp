@@ -4,13 +4,20 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "address.h"
 #include "bip.h"
+#include "bip_batch.h"
 #include "bvlc.h"
 #include "client.h"
 #include "config.h"
+#include "cov_subscriptions.h"
 #include "custom_bacnet_config.h"
 #include "datalink.h"
 #include "dlenv.h"
@@ -20,6 +27,7 @@
 #include "dcc.h"
 #include "getevent.h"
 #include "notification_class.hpp"
+#include "segmentation.h"
 #include "tsm.h"
 #include "txbuf.h"
 
@@ -32,11 +40,30 @@
 
 #define REGISTRATION_RENEWAL_SAFE_TIME_SECS 30
 #define ADDRESS_BINDING_TIME_SECS 60
+#define SERVICE_THREAD_PACKET_BUDGET 64
+#define SERVICE_THREAD_TIME_BUDGET_MS 50
 
 bacnet::Container container;
 
 namespace bacnet {
 
+    static bool datalink_pending() {
+        struct pollfd pfd = {bip_socket(), POLLIN, 0};
+
+        // datagrams already pulled in by the last recvmmsg()
+        if (bip_receive_queued() > 0)
+            return true;
+
+        return poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN);
+    }
+
+    static uint64_t monotonic_milliseconds() {
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    }
+
     BACnet::BACnet(const std::string &_vendor_name,
                    uint16_t _vendor_identifier,
                    const std::string &_model_name,
@@ -45,10 +72,13 @@ namespace bacnet {
                    unsigned _port)
             : vendor_name(_vendor_name), vendor_identifier(_vendor_identifier), model_name(_model_name),
               firmware_revision(_firmware_revision), application_software_revision(_application_software_revision),
-              database_revision(1), port(_port), _bbmd_addr(0), _bbmd_port(0), _bbmd_ttl(0) {
+              database_revision(1), port(_port), _bbmd_addr(0), _bbmd_port(0), _bbmd_ttl(0),
+              service_running(false), epoll_fd(-1), timer_fd(-1), wakeup_fd(-1),
+              receive_buffer(new uint8_t[MAX_MPDU]) {
     }
 
     BACnet::~BACnet() {
+        stop();
         container.reset();
     }
 
@@ -88,7 +118,10 @@ namespace bacnet {
         // apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_UTC_TIME_SYNCHRONIZATION, handler_timesync_utc);
         // apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_TIME_SYNCHRONIZATION, handler_timesync);
 
-        // apdu_set_confirmed_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV, handler_cov_subscribe);
+        handler_cov_init();
+        apdu_set_confirmed_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV, handler_cov_subscribe);
+        apdu_set_confirmed_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY, handler_cov_subscribe_property);
+        // SubscribeCOVPropertyMultiple is dispatched by cov_multiple_handler()
         // apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_COV_NOTIFICATION, handler_ucov_notification);
 
         // Handle communication so we can shutup when asked
@@ -103,6 +136,9 @@ namespace bacnet {
         apdu_set_confirmed_handler(SERVICE_CONFIRMED_GET_ALARM_SUMMARY, handler_get_alarm_summary);
 #endif /* defined(INTRINSIC_REPORTING) */
 
+        // recipient lists saved before the restart, unless the application loaded them already
+        container.loadPersistentState();
+
         last_seconds = time(NULL);
         address_binding_tmr = 0;
         recipient_scan_tmr = 0;
@@ -141,19 +177,70 @@ namespace bacnet {
         BACNET_ADDRESS src = {0}; // Address where message came from
         uint16_t pdu_len = 0;
         unsigned timeout = 1; // Milliseconds
-        uint8_t Rx_Buf[MAX_MPDU] = {0};
+        uint8_t *pdu = receive_buffer.get();
+
+        pdu_len = datalink_receive(&src, pdu, MAX_MPDU, timeout); // 0 bytes on timeout
+
+        if (pdu_len && !segmentation_handler(&src, pdu, pdu_len) && !cov_multiple_handler(&src, pdu, pdu_len)) {
+            npdu_handler(&src, pdu, pdu_len);
+        }
+
+        processTimers();
+    }
+
+    ExecuteResult BACnet::execute(unsigned max_packets, unsigned max_milliseconds) {
+        ExecuteResult result = {0, false};
+
+        result.handled = receivePackets(max_packets, max_milliseconds, &result.pending);
+
+        processTimers();
+
+        return result;
+    }
+
+    unsigned BACnet::receivePackets(unsigned max_packets, unsigned max_milliseconds, bool *pending) {
+        BACNET_ADDRESS src = {0};
+        uint16_t pdu_len = 0;
+        uint8_t *pdu = receive_buffer.get();
+        unsigned handled = 0;
+        unsigned skipped = 0; // datagrams without a PDU for us
+        uint64_t deadline = monotonic_milliseconds() + max_milliseconds;
+
+        // Replies produced while handling this burst go out together with one sendmmsg()
+        bip_send_batch_begin();
+
+        // datalink_receive() also returns 0 for datagrams it consumes itself (BVLC control
+        // messages, our own broadcasts), so readiness of the socket decides when it is empty
+        while ((*pending = datalink_pending())) {
+            if (handled >= max_packets || skipped >= max_packets || monotonic_milliseconds() >= deadline)
+                break;
+
+            pdu_len = datalink_receive(&src, pdu, MAX_MPDU, 0);
+            if (pdu_len == 0) {
+                skipped++;
+            } else {
+                if (!segmentation_handler(&src, pdu, pdu_len) && !cov_multiple_handler(&src, pdu, pdu_len))
+                    npdu_handler(&src, pdu, pdu_len);
+                handled++;
+            }
+
+            // keep the one second timers on cadence during long bursts
+            if (time(nullptr) != last_seconds)
+                processTimers();
+        }
+
+        bip_send_batch_end();
+
+        return handled;
+    }
+
+    void BACnet::processTimers() {
         uint32_t elapsed_seconds = 0;
         uint32_t elapsed_milliseconds = 0;
         time_t current_seconds = 0;
 
         current_seconds = time(nullptr);
 
-        pdu_len = datalink_receive(&src, &Rx_Buf[0], MAX_MPDU, timeout); // 0 bytes on timeout
-
-        if (pdu_len) {
-            npdu_handler(&src, &Rx_Buf[0], pdu_len);
-        }
-
         elapsed_seconds = (uint32_t) (current_seconds - last_seconds);
         if (elapsed_seconds) {
             last_seconds = current_seconds;
@@ -161,6 +248,13 @@ namespace bacnet {
             // dlenv_maintenance_timer(elapsed_seconds);
             elapsed_milliseconds = elapsed_seconds * 1000;
             tsm_timer_milliseconds(elapsed_milliseconds);
+            segmentation_timer(elapsed_milliseconds);
+            handler_cov_timer_seconds(elapsed_seconds);
+
+            // One pass of the COV task: check each monitored object once, then notify its subscribers
+            if (handler_cov_active()) {
+                handler_cov_task();
+            }
 
 #if defined(INTRINSIC_REPORTING)
             container.deviceLocalReporting();
@@ -220,6 +314,117 @@ namespace bacnet {
         }
     }
 
+    uint32_t BACnet::secondsUntilNextDeadline() {
+        // All stack timers have one second granularity. Tick every second while anything
+        // counts down per second, otherwise sleep until the closest periodic job.
+        if (tsm_transaction_idle_count() < MAX_TSM_TRANSACTIONS || dcc_duration_seconds() > 0 ||
+            segmentation_active() || handler_cov_active())
+            return 1;
+
+#if defined(INTRINSIC_REPORTING)
+        if (container.getObjectCount(OBJECT_ANALOG_INPUT) > 0 || hasRecipientListChanged)
+            return 1;
+#endif
+
+        uint32_t seconds = ADDRESS_BINDING_TIME_SECS - address_binding_tmr;
+
+#if defined(INTRINSIC_REPORTING)
+        if (NC_RESCAN_RECIPIENTS_SECS - recipient_scan_tmr < seconds)
+            seconds = NC_RESCAN_RECIPIENTS_SECS - recipient_scan_tmr;
+#endif
+
+        if (bvlc_get_last_registration_status() == SUCCESS) {
+            long renew = _bbmd_ttl - REGISTRATION_RENEWAL_SAFE_TIME_SECS - (long) foreign_device_renew_tmr;
+            if (renew < (long) seconds)
+                seconds = renew > 0 ? (uint32_t) renew : 0;
+        }
+
+        return seconds > 0 ? seconds : 1;
+    }
+
+    bool BACnet::start() {
+        struct epoll_event event = {0};
+
+        if (service_running || bip_socket() < 0)
+            return false;
+
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        timer_fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+        wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epoll_fd < 0 || timer_fd < 0 || wakeup_fd < 0) {
+            fprintf(stderr, "Failed to create service thread descriptors\n");
+            stop();
+            return false;
+        }
+
+        event.events = EPOLLIN;
+        event.data.fd = bip_socket();
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, bip_socket(), &event);
+        event.data.fd = timer_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event);
+        event.data.fd = wakeup_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &event);
+
+        service_running = true;
+        service_thread = std::thread(&BACnet::serviceLoop, this);
+
+        return true;
+    }
+
+    void BACnet::stop() {
+        if (service_running) {
+            uint64_t one = 1;
+            service_running = false;
+            if (write(wakeup_fd, &one, sizeof(one)) < 0) {
+                // the thread still exits on its next deadline
+            }
+        }
+
+        if (service_thread.joinable())
+            service_thread.join();
+
+        for (int *fd : {&epoll_fd, &timer_fd, &wakeup_fd}) {
+            if (*fd >= 0) {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+
+    void BACnet::serviceLoop() {
+        struct epoll_event events[3];
+        struct itimerspec deadline = {0};
+        uint64_t expirations = 0;
+        bool pending = false;
+
+        while (service_running) {
+            // Arm the timer on the same wall clock second boundaries that processTimers() counts
+            deadline.it_value.tv_sec = last_seconds + secondsUntilNextDeadline();
+            timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &deadline, nullptr);
+
+            // Datagrams left in the receive batch are invisible to epoll, so only peek at the fds
+            int count = epoll_wait(epoll_fd, events, 3, bip_receive_queued() > 0 ? 0 : -1);
+            if (count == 0 && bip_receive_queued() > 0)
+                receivePackets(SERVICE_THREAD_PACKET_BUDGET, SERVICE_THREAD_TIME_BUDGET_MS, &pending);
+            for (int i = 0; i < count; i++) {
+                if (events[i].data.fd == bip_socket()) {
+                    // Level triggered, so anything left over the budget wakes us up again
+                    receivePackets(SERVICE_THREAD_PACKET_BUDGET, SERVICE_THREAD_TIME_BUDGET_MS, &pending);
+                } else if (events[i].data.fd == timer_fd) {
+                    if (read(timer_fd, &expirations, sizeof(expirations)) < 0) {
+                        // spurious wakeup, nothing to consume
+                    }
+                } else if (events[i].data.fd == wakeup_fd) {
+                    if (read(wakeup_fd, &expirations, sizeof(expirations)) < 0) {
+                        // spurious wakeup, nothing to consume
+                    }
+                }
+            }
+
+            processTimers();
+        }
+    }
+
     bool BACnet::registerForeign(const char *address, long port, long ttl) {
         long bbmd_address = bip_getaddrbyname(address);
         struct in_addr addr;
@@ -401,10 +606,82 @@ namespace bacnet {
                                                     description);
     }
 
+    void BACnet::loadPersistentState() {
+        container.loadPersistentState();
+    }
+
+    bool BACnet::addObjects(const std::vector<ObjectSpec> &specs) {
+        return container.addObjects(specs);
+    }
+
+    bool BACnet::addObjectRange(const ObjectSpec &spec, unsigned count, uint32_t *first_instance) {
+        return container.addObjectRange(spec, count, first_instance);
+    }
+
+    DatalinkStatistics BACnet::getDatalinkStatistics() {
+        BIP_BATCH_STATS stats;
+
+        bip_batch_stats(&stats);
+
+        return {stats.rx_calls, stats.rx_packets, stats.rx_max_batch,
+                stats.tx_calls, stats.tx_packets, stats.tx_max_batch};
+    }
+
     std::shared_ptr<BACnetObject> BACnet::getDeviceObject() {
         return container.getDeviceObject();
     }
 
+    void BACnet::objectNameChanged(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+        container.objectNameChanged(object_type, object_instance);
+    }
+
+    void BACnet::staticPropertiesChanged(BACNET_OBJECT_TYPE object_type, uint32_t object_instance) {
+        container.staticPropertiesChanged(object_type, object_instance);
+    }
+
+    void BACnet::setBatchReadHandler(BACNET_OBJECT_TYPE object_type, object_batch_read_cb batch_read_cb) {
+        container.setBatchReadHandler(object_type, batch_read_cb);
+    }
+
+    template <typename T>
+    static bool update_present_value(BACnetObject *object,
+                                     std::initializer_list<BACNET_OBJECT_TYPE> types,
+                                     const T &value) {
+        if (!object || !object->present_value.enabled)
+            return false;
+
+        for (BACNET_OBJECT_TYPE type : types) {
+            if (object->type == type) {
+                object->present_value.store(value);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool BACnet::updatePresentValue(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, float value) {
+        return update_present_value(container.findObject(object_type, object_instance),
+                                    {OBJECT_ANALOG_INPUT, OBJECT_ANALOG_VALUE}, value);
+    }
+
+    bool BACnet::updatePresentValue(BACNET_OBJECT_TYPE object_type, uint32_t object_instance, unsigned value) {
+        return update_present_value(container.findObject(object_type, object_instance),
+                                    {OBJECT_MULTI_STATE_INPUT, OBJECT_MULTI_STATE_VALUE}, value);
+    }
+
+    bool BACnet::updatePresentValue(BACNET_OBJECT_TYPE object_type,
+                                    uint32_t object_instance,
+                                    const BACNET_TIME &value) {
+        return update_present_value(container.findObject(object_type, object_instance), {OBJECT_TIME_VALUE}, value);
+    }
+
+    bool BACnet::updatePresentValue(BACNET_OBJECT_TYPE object_type,
+                                    uint32_t object_instance,
+                                    const BACNET_DATE &value) {
+        return update_present_value(container.findObject(object_type, object_instance), {OBJECT_DATE_VALUE}, value);
+    }
+
     unsigned BACnet::getDatabaseRevision() {
         return database_revision;
     }
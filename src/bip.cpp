@@ -38,6 +38,7 @@
 #include "bacint.h"
 #include "bip.h"
 #include "bvlc.h"
+#include "bip_batch.h"
 #include "net.h"        /* custom per port */
 
 #if PRINT_ENABLED
@@ -54,6 +55,26 @@ static struct in_addr BIP_Address;
 /* Broadcast Address - stored in network byte order */
 static struct in_addr BIP_Broadcast_Address;
 
+/* datagrams read by the last recvmmsg() that were not handed out yet */
+static struct {
+    uint8_t mtu[BIP_RX_BATCH_SIZE][MAX_MPDU];
+    struct sockaddr_in addr[BIP_RX_BATCH_SIZE];
+    unsigned len[BIP_RX_BATCH_SIZE];
+    unsigned count;
+    unsigned next;
+} BIP_Rx_Batch;
+
+/* datagrams waiting for the next sendmmsg() */
+static struct {
+    uint8_t mtu[BIP_TX_BATCH_SIZE][MAX_MPDU];
+    struct sockaddr_in addr[BIP_TX_BATCH_SIZE];
+    unsigned len[BIP_TX_BATCH_SIZE];
+    unsigned count;
+    unsigned open; /* nesting depth of bip_send_batch_begin() */
+} BIP_Tx_Batch;
+
+static BIP_BATCH_STATS BIP_Stats;
+
 /** Setter for the BACnet/IP socket handle.
  *
  * @param sock_fd [in] Handle for the BACnet/IP socket.
@@ -111,6 +132,202 @@ uint16_t bip_get_port(
     return BIP_Port;
 }
 
+/** Read as many datagrams as are waiting on the socket, up to
+ * BIP_RX_BATCH_SIZE, with a single recvmmsg().
+ *
+ * @param timeout [in] The number of milliseconds to wait for a packet.
+ * @return Number of datagrams read, negative number on failure.
+ */
+static int bip_receive_batch(
+        unsigned timeout) {
+    struct mmsghdr msgs[BIP_RX_BATCH_SIZE];
+    struct iovec iovecs[BIP_RX_BATCH_SIZE];
+    fd_set read_fds;
+    struct timeval select_timeout;
+    int received = 0;
+    unsigned i = 0;
+
+    /* we could just use a non-blocking socket, but that consumes all
+       the CPU time.  We can use a timeout; it is only supported as
+       a select. */
+    select_timeout.tv_sec = timeout / 1000;
+    select_timeout.tv_usec = 1000 * (timeout % 1000);
+    FD_ZERO(&read_fds);
+    FD_SET(BIP_Socket, &read_fds);
+    if (select(BIP_Socket + 1, &read_fds, NULL, NULL, &select_timeout) <= 0)
+        return 0;
+
+    memset(msgs, 0, sizeof(msgs));
+    for (i = 0; i < BIP_RX_BATCH_SIZE; i++) {
+        iovecs[i].iov_base = BIP_Rx_Batch.mtu[i];
+        iovecs[i].iov_len = MAX_MPDU;
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &BIP_Rx_Batch.addr[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    }
+    received =
+            recvmmsg(BIP_Socket, msgs, BIP_RX_BATCH_SIZE, MSG_DONTWAIT, NULL);
+    if (received <= 0)
+        return received;
+
+    for (i = 0; i < (unsigned) received; i++) {
+        BIP_Rx_Batch.len[i] = msgs[i].msg_len;
+    }
+    BIP_Rx_Batch.count = (unsigned) received;
+    BIP_Rx_Batch.next = 0;
+
+    BIP_Stats.rx_calls++;
+    BIP_Stats.rx_packets += (unsigned) received;
+    if ((unsigned) received > BIP_Stats.rx_max_batch)
+        BIP_Stats.rx_max_batch = (unsigned) received;
+
+    return received;
+}
+
+int bip_receive_mpdu(
+        struct sockaddr_in *sin,
+        uint8_t **mtu,
+        unsigned timeout) {
+    unsigned slot = 0;
+
+    if (BIP_Socket < 0)
+        return -1;
+
+    if (BIP_Rx_Batch.next >= BIP_Rx_Batch.count) {
+        BIP_Rx_Batch.count = 0;
+        BIP_Rx_Batch.next = 0;
+        if (bip_receive_batch(timeout) <= 0)
+            return 0;
+    }
+
+    slot = BIP_Rx_Batch.next++;
+    *sin = BIP_Rx_Batch.addr[slot];
+    *mtu = BIP_Rx_Batch.mtu[slot];
+
+    return (int) BIP_Rx_Batch.len[slot];
+}
+
+unsigned bip_receive_queued(
+        void) {
+    return BIP_Rx_Batch.count - BIP_Rx_Batch.next;
+}
+
+/** Send everything in the transmit batch with as few sendmmsg() calls
+ * as the kernel allows. A datagram the kernel refuses is dropped, the
+ * same as a failed sendto() would have dropped it.
+ */
+static void bip_send_batch_flush(
+        void) {
+    struct mmsghdr msgs[BIP_TX_BATCH_SIZE];
+    struct iovec iovecs[BIP_TX_BATCH_SIZE];
+    unsigned sent = 0;
+    unsigned i = 0;
+    int result = 0;
+
+    if (BIP_Tx_Batch.count == 0)
+        return;
+
+    memset(msgs, 0, sizeof(msgs));
+    for (i = 0; i < BIP_Tx_Batch.count; i++) {
+        iovecs[i].iov_base = BIP_Tx_Batch.mtu[i];
+        iovecs[i].iov_len = BIP_Tx_Batch.len[i];
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &BIP_Tx_Batch.addr[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    }
+
+    while (sent < BIP_Tx_Batch.count) {
+        result = sendmmsg(BIP_Socket, &msgs[sent],
+                          BIP_Tx_Batch.count - sent, 0);
+        BIP_Stats.tx_calls++;
+        if (result <= 0) {
+#if PRINT_ENABLED
+            fprintf(stderr, "BIP: sendmmsg failed. Datagram dropped!\n");
+#endif
+            sent++;
+            continue;
+        }
+        BIP_Stats.tx_packets += (unsigned) result;
+        if ((unsigned) result > BIP_Stats.tx_max_batch)
+            BIP_Stats.tx_max_batch = (unsigned) result;
+        sent += (unsigned) result;
+    }
+    BIP_Tx_Batch.count = 0;
+}
+
+int bip_send_mpdu_iov(
+        struct sockaddr_in *dest,
+        const struct iovec *iov,
+        unsigned iov_count) {
+    struct msghdr msg;
+    unsigned slot = 0;
+    unsigned len = 0;
+    unsigned i = 0;
+
+    if (BIP_Socket < 0)
+        return BIP_Socket;
+
+    if (!BIP_Tx_Batch.open) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = dest;
+        msg.msg_namelen = sizeof(struct sockaddr_in);
+        msg.msg_iov = (struct iovec *) iov;
+        msg.msg_iovlen = iov_count;
+        return sendmsg(BIP_Socket, &msg, 0);
+    }
+
+    for (i = 0; i < iov_count; i++) {
+        len += iov[i].iov_len;
+    }
+    if (len > MAX_MPDU)
+        return -1;
+
+    /* the caller reuses its buffers as soon as we return, so keep a copy */
+    if (BIP_Tx_Batch.count == BIP_TX_BATCH_SIZE)
+        bip_send_batch_flush();
+    slot = BIP_Tx_Batch.count++;
+    len = 0;
+    for (i = 0; i < iov_count; i++) {
+        memcpy(&BIP_Tx_Batch.mtu[slot][len], iov[i].iov_base, iov[i].iov_len);
+        len += iov[i].iov_len;
+    }
+    BIP_Tx_Batch.addr[slot] = *dest;
+    BIP_Tx_Batch.len[slot] = len;
+
+    return (int) len;
+}
+
+int bip_send_mpdu(
+        struct sockaddr_in *dest,
+        uint8_t *mtu,
+        uint16_t mtu_len) {
+    struct iovec iov;
+
+    iov.iov_base = mtu;
+    iov.iov_len = mtu_len;
+
+    return bip_send_mpdu_iov(dest, &iov, 1);
+}
+
+void bip_send_batch_begin(
+        void) {
+    BIP_Tx_Batch.open++;
+}
+
+void bip_send_batch_end(
+        void) {
+    if (BIP_Tx_Batch.open == 0 || --BIP_Tx_Batch.open > 0)
+        return;
+    bip_send_batch_flush();
+}
+
+void bip_batch_stats(
+        BIP_BATCH_STATS *stats) {
+    *stats = BIP_Stats;
+}
+
 static int bip_decode_bip_address(
         BACNET_ADDRESS *bac_addr,
         struct in_addr *address,    /* in network format */
@@ -141,7 +358,8 @@ int bip_send_pdu(
         uint8_t *pdu,      /* any data to be sent - may be null */
         unsigned pdu_len) {       /* number of bytes of data */
     struct sockaddr_in bip_dest;
-    uint8_t mtu[MAX_MPDU] = {0};
+    uint8_t mtu[4];
+    struct iovec iov[2];
     int mtu_len = 0;
     int bytes_sent = 0;
     /* addr and port in host format */
@@ -201,13 +419,13 @@ int bip_send_pdu(
     mtu_len +=
             encode_unsigned16(&mtu[mtu_len],
                               (uint16_t) (pdu_len + 4 /*inclusive */ ));
-    memcpy(&mtu[mtu_len], pdu, pdu_len);
-    mtu_len += pdu_len;
 
-    /* Send the packet */
-    bytes_sent =
-            sendto(BIP_Socket, (char *) mtu, mtu_len, 0,
-                   (struct sockaddr *) &bip_dest, sizeof(struct sockaddr));
+    /* Send the BVLC header and the NPDU straight from the caller's buffer */
+    iov[0].iov_base = mtu;
+    iov[0].iov_len = mtu_len;
+    iov[1].iov_base = pdu;
+    iov[1].iov_len = pdu_len;
+    bytes_sent = bip_send_mpdu_iov(&bip_dest, iov, 2);
 
     return bytes_sent;
 }
@@ -230,39 +448,16 @@ uint16_t bip_receive(
         unsigned timeout) {
     int received_bytes = 0;
     uint16_t pdu_len = 0;       /* return value */
-    fd_set read_fds;
-    int max = 0;
-    struct timeval select_timeout;
     struct sockaddr_in sin = {0};
-    socklen_t sin_len = sizeof(sin);
-    uint16_t i = 0;
+    uint8_t *mtu = NULL;
     int function = 0;
 
     /* Make sure the socket is open */
     if (BIP_Socket < 0)
         return 0;
 
-    /* we could just use a non-blocking socket, but that consumes all
-       the CPU time.  We can use a timeout; it is only supported as
-       a select. */
-    if (timeout >= 1000) {
-        select_timeout.tv_sec = timeout / 1000;
-        select_timeout.tv_usec =
-                1000 * (timeout - select_timeout.tv_sec * 1000);
-    } else {
-        select_timeout.tv_sec = 0;
-        select_timeout.tv_usec = 1000 * timeout;
-    }
-    FD_ZERO(&read_fds);
-    FD_SET(BIP_Socket, &read_fds);
-    max = BIP_Socket;
     /* see if there is a packet for us */
-    if (select(max + 1, &read_fds, NULL, NULL, &select_timeout) > 0)
-        received_bytes =
-                recvfrom(BIP_Socket, (char *) &pdu[0], max_pdu, 0,
-                         (struct sockaddr *) &sin, &sin_len);
-    else
-        return 0;
+    received_bytes = bip_receive_mpdu(&sin, &mtu, timeout);
 
     /* See if there is a problem */
     if (received_bytes < 0) {
@@ -274,10 +469,10 @@ uint16_t bip_receive(
         return 0;
 
     /* the signature of a BACnet/IP packet */
-    if (pdu[0] != BVLL_TYPE_BACNET_IP)
+    if (mtu[0] != BVLL_TYPE_BACNET_IP)
         return 0;
 
-    if (bvlc_for_non_bbmd(&sin, pdu, received_bytes) > 0) {
+    if (bvlc_for_non_bbmd(&sin, mtu, received_bytes) > 0) {
         /* Handled, usually with a NACK. */
 #if PRINT_ENABLED
         fprintf(stderr, "BIP: BVLC discarded!\n");
@@ -303,23 +498,15 @@ uint16_t bip_receive(
             /* FIXME: check destination address */
             /* see if it is broadcast or for us */
             /* decode the length of the PDU - length is inclusive of BVLC */
-            (void) decode_unsigned16(&pdu[2], &pdu_len);
+            (void) decode_unsigned16(&mtu[2], &pdu_len);
             /* subtract off the BVLC header */
             pdu_len -= 4;
             if (pdu_len < max_pdu) {
 #if 0
                 fprintf(stderr, "BIP: NPDU[%hu]:", pdu_len);
 #endif
-                /* shift the buffer to return a valid PDU */
-                for (i = 0; i < pdu_len; i++) {
-                    pdu[i] = pdu[4 + i];
-#if 0
-                    fprintf(stderr, "%02X ", pdu[i]);
-#endif
-                }
-#if 0
-                fprintf(stderr, "\n");
-#endif
+                /* copy the NPDU out of the receive slot */
+                memcpy(pdu, &mtu[4], pdu_len);
             }
                 /* ignore packets that are too large */
                 /* clients should check my max-apdu first */
@@ -331,8 +518,8 @@ uint16_t bip_receive(
             }
         }
     } else if (function == BVLC_FORWARDED_NPDU) {
-        memcpy(&sin.sin_addr.s_addr, &pdu[4], 4);
-        memcpy(&sin.sin_port, &pdu[8], 2);
+        memcpy(&sin.sin_addr.s_addr, &mtu[4], 4);
+        memcpy(&sin.sin_port, &mtu[8], 2);
         if ((sin.sin_addr.s_addr == BIP_Address.s_addr) &&
             (sin.sin_port == BIP_Port)) {
             /* ignore messages from me */
@@ -345,14 +532,12 @@ uint16_t bip_receive(
             /* FIXME: check destination address */
             /* see if it is broadcast or for us */
             /* decode the length of the PDU - length is inclusive of BVLC */
-            (void) decode_unsigned16(&pdu[2], &pdu_len);
+            (void) decode_unsigned16(&mtu[2], &pdu_len);
             /* subtract off the BVLC header */
             pdu_len -= 10;
             if (pdu_len < max_pdu) {
-                /* shift the buffer to return a valid PDU */
-                for (i = 0; i < pdu_len; i++) {
-                    pdu[i] = pdu[4 + 6 + i];
-                }
+                /* copy the NPDU out of the receive slot */
+                memcpy(pdu, &mtu[4 + 6], pdu_len);
             } else {
                 /* ignore packets that are too large */
                 /* clients should check my max-apdu first */
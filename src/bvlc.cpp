@@ -37,6 +37,7 @@
 #include "bacdcode.h"
 #include "bacenum.h"
 #include "bacint.h"
+#include "bip_batch.h"
 #include "bvlc.h"
 #include <stdbool.h> /* for the standard bool type. */
 #include <stdint.h>  /* for standard integer types uint8_t etc. */
@@ -445,27 +446,20 @@ static int bvlc_encode_read_bdt_ack(uint8_t* pdu, uint16_t max_pdu) {
     return pdu_len;
 }
 
-/** Encode a Forwarded NPDU message
+/** Encode the BVLL header of a Forwarded-NPDU message. The NPDU itself
+ * is not copied; it is sent right behind the header.
  *
- * @param pdu - buffer to store the encoding
+ * @param pdu - buffer to store the header, at least 10 bytes
  * @param sin - source address in network order
- * @param npdu - NPDU to forward
- * @param max_npdu - amount of space available in the NPDU
  * @param npdu_length - size of the NPDU to forward
  *
- * @return number of bytes encoded
+ * @return number of bytes encoded, 0 if the NPDU is too large to forward
  */
-static int bvlc_encode_forwarded_npdu(uint8_t* pdu,
-    uint16_t max_pdu,
-    struct sockaddr_in* sin,
-    uint8_t* npdu,
-    unsigned npdu_length) {
+static int bvlc_encode_forwarded_npdu_header(uint8_t* pdu, struct sockaddr_in* sin, unsigned npdu_length) {
     int len = 0;
 
-    unsigned i; /* for loop counter */
-
-    if (pdu && sin && npdu) {
-        if ((npdu_length + 4 + 6) <= max_pdu) {
+    if (pdu && sin) {
+        if ((npdu_length + 4 + 6) <= MAX_MPDU) {
             pdu[0] = BVLL_TYPE_BACNET_IP;
             pdu[1] = BVLC_FORWARDED_NPDU;
             /* The 2-octet BVLC Length field is the length, in octets,
@@ -475,10 +469,6 @@ static int bvlc_encode_forwarded_npdu(uint8_t* pdu,
             len = 4;
             /* 6-octet address encoding */
             len += bvlc_encode_bip_address(&pdu[len], &sin->sin_addr, sin->sin_port);
-            for (i = 0; i < npdu_length; i++) {
-                pdu[len] = npdu[i];
-                len++;
-            }
         }
     }
 
@@ -784,20 +774,24 @@ static bool bvlc_delete_foreign_device(uint8_t* pdu, uint16_t pdu_len) {
 }
 #endif
 
-/**
- * The common send function for bvlc functions, using b/ip.
+/** Send a BVLL header followed by an NPDU in a single datagram, without
+ * copying the NPDU behind the header first.
  *
- * @param dest - Points to a sockaddr_in structure containing the
- *  destination address. The length and format of the address depend
- *  on the address family of the socket (AF_INET).
- *  The address is in network byte order.
- * @param mtu - the bytes of data to send
- * @param mtu_len - the number of bytes of data to send
+ * @param dest - destination address in network byte order
+ * @param header - the BVLL header bytes
+ * @param header_len - the number of header bytes
+ * @param npdu - the NPDU to send behind the header, may be NULL
+ * @param npdu_len - the number of NPDU bytes
  * @return Upon successful completion, returns the number of bytes sent.
  *  Otherwise, -1 shall be returned and errno set to indicate the error.
  */
-int bvlc_send_mpdu(struct sockaddr_in* dest, uint8_t* mtu, uint16_t mtu_len) {
+static int bvlc_send_mpdu_npdu(struct sockaddr_in* dest,
+    uint8_t* header,
+    uint16_t header_len,
+    uint8_t* npdu,
+    uint16_t npdu_len) {
     struct sockaddr_in bvlc_dest = {0};
+    struct iovec iov[2];
 
     /* assumes that the driver has already been initialized */
     if (bip_socket() < 0) {
@@ -808,8 +802,28 @@ int bvlc_send_mpdu(struct sockaddr_in* dest, uint8_t* mtu, uint16_t mtu_len) {
     bvlc_dest.sin_addr.s_addr = dest->sin_addr.s_addr;
     bvlc_dest.sin_port = dest->sin_port;
     memset(&(bvlc_dest.sin_zero), '\0', 8);
+    iov[0].iov_base = header;
+    iov[0].iov_len = header_len;
+    iov[1].iov_base = npdu;
+    iov[1].iov_len = npdu_len;
     /* Send the packet */
-    return sendto(bip_socket(), (char*)mtu, mtu_len, 0, (struct sockaddr*)&bvlc_dest, sizeof(struct sockaddr));
+    return bip_send_mpdu_iov(&bvlc_dest, iov, npdu_len ? 2 : 1);
+}
+
+/**
+ * The common send function for bvlc functions, using b/ip.
+ *
+ * @param dest - Points to a sockaddr_in structure containing the
+ *  destination address. The length and format of the address depend
+ *  on the address family of the socket (AF_INET).
+ *  The address is in network byte order.
+ * @param mtu - the bytes of data to send
+ * @param mtu_len - the number of bytes of data to send
+ * @return Upon successful completion, returns the number of bytes sent.
+ *  Otherwise, -1 shall be returned and errno set to indicate the error.
+ */
+int bvlc_send_mpdu(struct sockaddr_in* dest, uint8_t* mtu, uint16_t mtu_len) {
+    return bvlc_send_mpdu_npdu(dest, mtu, mtu_len, NULL, 0);
 }
 
 #if defined(BBMD_ENABLED) && BBMD_ENABLED
@@ -822,7 +836,7 @@ int bvlc_send_mpdu(struct sockaddr_in* dest, uint8_t* mtu, uint16_t mtu_len) {
  * @param original - was the message an original (not forwarded)
  */
 static void bvlc_bdt_forward_npdu(struct sockaddr_in* sin, uint8_t* npdu, uint16_t npdu_length, bool original) {
-    uint8_t mtu[MAX_MPDU] = {0};
+    uint8_t mtu[4 + 6];
     uint16_t mtu_len = 0;
     unsigned i = 0; /* loop counter */
     struct sockaddr_in bip_dest = {0};
@@ -838,9 +852,12 @@ static void bvlc_bdt_forward_npdu(struct sockaddr_in* sin, uint8_t* npdu, uint16
     if (BVLC_NAT_Handling && original) {
         struct sockaddr_in nat_addr = *sin;
         nat_addr.sin_addr = BVLC_Global_Address;
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(&mtu[0], (uint16_t)sizeof(mtu), &nat_addr, npdu, npdu_length);
+        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu_header(&mtu[0], &nat_addr, npdu_length);
     } else {
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(&mtu[0], (uint16_t)sizeof(mtu), sin, npdu, npdu_length);
+        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu_header(&mtu[0], sin, npdu_length);
+    }
+    if (mtu_len == 0) {
+        return;
     }
     /* loop through the BDT and send one to each entry, except us */
     for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
@@ -867,7 +884,7 @@ static void bvlc_bdt_forward_npdu(struct sockaddr_in* sin, uint8_t* npdu, uint16
                 (bip_dest.sin_port == bip_get_port())) {
                 continue;
             }
-            bvlc_send_mpdu(&bip_dest, mtu, mtu_len);
+            bvlc_send_mpdu_npdu(&bip_dest, mtu, mtu_len, npdu, npdu_length);
             debug_printf("BVLC: BDT Sent Forwarded-NPDU to %s:%04X\n",
                 inet_ntoa(bip_dest.sin_addr),
                 ntohs(bip_dest.sin_port));
@@ -886,14 +903,17 @@ static void bvlc_bdt_forward_npdu(struct sockaddr_in* sin, uint8_t* npdu, uint16
  * @param npdu_length - reported length of the NPDU
  */
 static void bvlc_forward_npdu(struct sockaddr_in* sin, uint8_t* npdu, uint16_t npdu_length) {
-    uint8_t mtu[MAX_MPDU] = {0};
+    uint8_t mtu[4 + 6];
     uint16_t mtu_len = 0;
     struct sockaddr_in bip_dest = {0};
 
-    mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(&mtu[0], (uint16_t)sizeof(mtu), sin, npdu, npdu_length);
+    mtu_len = (uint16_t)bvlc_encode_forwarded_npdu_header(&mtu[0], sin, npdu_length);
+    if (mtu_len == 0) {
+        return;
+    }
     bip_dest.sin_addr.s_addr = bip_get_broadcast_addr();
     bip_dest.sin_port = bip_get_port();
-    bvlc_send_mpdu(&bip_dest, mtu, mtu_len);
+    bvlc_send_mpdu_npdu(&bip_dest, mtu, mtu_len, npdu, npdu_length);
     debug_printf("BVLC: Sent Forwarded-NPDU as local broadcast.\n");
 }
 
@@ -906,7 +926,7 @@ static void bvlc_forward_npdu(struct sockaddr_in* sin, uint8_t* npdu, uint16_t n
  * @param original - was the message an original (not forwarded)
  */
 static void bvlc_fdt_forward_npdu(struct sockaddr_in* sin, uint8_t* npdu, uint16_t npdu_length, bool original) {
-    uint8_t mtu[MAX_MPDU] = {0};
+    uint8_t mtu[4 + 6];
     uint16_t mtu_len = 0;
     unsigned i = 0; /* loop counter */
     struct sockaddr_in bip_dest = {0};
@@ -922,9 +942,12 @@ static void bvlc_fdt_forward_npdu(struct sockaddr_in* sin, uint8_t* npdu, uint16
     if (BVLC_NAT_Handling && original) {
         struct sockaddr_in nat_addr = *sin;
         nat_addr.sin_addr = BVLC_Global_Address;
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(&mtu[0], (uint16_t)sizeof(mtu), &nat_addr, npdu, npdu_length);
+        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu_header(&mtu[0], &nat_addr, npdu_length);
     } else {
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(&mtu[0], (uint16_t)sizeof(mtu), sin, npdu, npdu_length);
+        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu_header(&mtu[0], sin, npdu_length);
+    }
+    if (mtu_len == 0) {
+        return;
     }
 
     /* loop through the FDT and send one to each entry */
@@ -948,7 +971,7 @@ static void bvlc_fdt_forward_npdu(struct sockaddr_in* sin, uint8_t* npdu, uint16
                 (bip_dest.sin_port == bip_get_port())) {
                 continue;
             }
-            bvlc_send_mpdu(&bip_dest, mtu, mtu_len);
+            bvlc_send_mpdu_npdu(&bip_dest, mtu, mtu_len, npdu, npdu_length);
             debug_printf("BVLC: FDT Sent Forwarded-NPDU to %s:%04X\n",
                 inet_ntoa(bip_dest.sin_addr),
                 ntohs(bip_dest.sin_port));
@@ -1060,13 +1083,10 @@ static bool bvlc_bdt_member_mask_is_unicast(struct sockaddr_in* sin) {
  */
 uint16_t bvlc_receive(BACNET_ADDRESS* src, uint8_t* npdu, uint16_t max_npdu, unsigned timeout) {
     uint16_t npdu_len = 0; /* return value */
-    fd_set read_fds;
-    int max = 0;
-    struct timeval select_timeout;
     struct sockaddr_in sin = {0};
     struct sockaddr_in original_sin = {0};
     struct sockaddr_in dest = {0};
-    socklen_t sin_len = sizeof(sin);
+    uint8_t* mtu = NULL;
     int received_bytes = 0;
     uint16_t result_code = 0;
     uint16_t i = 0;
@@ -1078,24 +1098,13 @@ uint16_t bvlc_receive(BACNET_ADDRESS* src, uint8_t* npdu, uint16_t max_npdu, uns
         return 0;
     }
 
-    /* we could just use a non-blocking socket, but that consumes all
-       the CPU time.  We can use a timeout; it is only supported as
-       a select. */
-    if (timeout >= 1000) {
-        select_timeout.tv_sec = timeout / 1000;
-        select_timeout.tv_usec = 1000 * (timeout - select_timeout.tv_sec * 1000);
-    } else {
-        select_timeout.tv_sec = 0;
-        select_timeout.tv_usec = 1000 * timeout;
-    }
-    FD_ZERO(&read_fds);
-    FD_SET(bip_socket(), &read_fds);
-    max = bip_socket();
     /* see if there is a packet for us */
-    if (select(max + 1, &read_fds, NULL, NULL, &select_timeout) > 0) {
-        received_bytes = recvfrom(bip_socket(), (char*)&npdu[0], max_npdu, 0, (struct sockaddr*)&sin, &sin_len);
-    } else {
-        return 0;
+    received_bytes = bip_receive_mpdu(&sin, &mtu, timeout);
+    if (received_bytes > max_npdu) {
+        received_bytes = max_npdu;
+    }
+    if (received_bytes > 0) {
+        memcpy(npdu, mtu, received_bytes);
     }
     /* See if there is a problem */
     if (received_bytes < 0) {
@@ -1383,7 +1392,7 @@ uint16_t bvlc_receive(BACNET_ADDRESS* src, uint8_t* npdu, uint16_t max_npdu, uns
  */
 int bvlc_send_pdu(BACNET_ADDRESS* dest, BACNET_NPDU_DATA* npdu_data, uint8_t* pdu, unsigned pdu_len) {
     struct sockaddr_in bvlc_dest = {0};
-    uint8_t mtu[MAX_MPDU] = {0};
+    uint8_t mtu[4];
     uint16_t mtu_len = 0;
     /* addr and port in network format */
     struct in_addr address;
@@ -1434,9 +1443,8 @@ int bvlc_send_pdu(BACNET_ADDRESS* dest, BACNET_NPDU_DATA* npdu_data, uint8_t* pd
     BVLC_length = (uint16_t)pdu_len + 4 /*inclusive */;
     mtu_len = 2;
     mtu_len += (uint16_t)encode_unsigned16(&mtu[mtu_len], BVLC_length);
-    memcpy(&mtu[mtu_len], pdu, pdu_len);
-    mtu_len += (uint16_t)pdu_len;
-    return bvlc_send_mpdu(&bvlc_dest, mtu, mtu_len);
+    /* the NPDU goes out straight from the caller's buffer */
+    return bvlc_send_mpdu_npdu(&bvlc_dest, mtu, mtu_len, pdu, (uint16_t)pdu_len);
 }
 #endif
 
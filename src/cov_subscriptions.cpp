@@ -0,0 +1,802 @@
+/** @file cov_subscriptions.cpp  COV subscription table, indexed by monitored object */
+
+#include <stdbool.h> /* for the standard bool type. */
+#include <stdint.h>  /* for standard integer types uint8_t etc. */
+#include <stdio.h>
+#include <string.h>
+
+#include "apdu.h"
+#include "bacaddr.h"
+#include "bacapp.h"
+#include "bacdcode.h"
+#include "bacdef.h"
+#include "c_wrapper.h"
+#include "config.h"
+#include "cov_subscriptions.h"
+#include "dcc.h"
+#include "npdu.h"
+#include "tsm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/* a SubscribeCOV or SubscribeCOVProperty subscription */
+struct CovSubscription {
+    BACNET_COV_SUBSCRIPTION subscription;
+    /* SubscribeCOVProperty: encoding of the value last notified, empty before the first notification */
+    std::vector<uint8_t> reported;
+};
+
+/* all subscriptions, in no particular order, each knows its own position */
+static std::vector<std::unique_ptr<CovSubscription>> COV_Subscriptions;
+/* monitored object -> its subscriptions */
+static std::unordered_map<uint64_t, std::vector<BACNET_COV_SUBSCRIPTION*>> COV_Object_Index;
+/* expiry time -> subscription, only for subscriptions with a definite lifetime */
+static std::multimap<uint64_t, BACNET_COV_SUBSCRIPTION*> COV_Expiries;
+/* subscriptions with a notification queued, and those with a confirmed notification in progress */
+static std::vector<BACNET_COV_SUBSCRIPTION*> COV_Pending;
+static std::vector<BACNET_COV_SUBSCRIPTION*> COV_Confirmed;
+/* seconds counted by cov_subscriptions_timer() */
+static uint64_t COV_Seconds;
+
+/* a property subscribed with SubscribeCOVPropertyMultiple and its change state */
+struct CovReference {
+    BACNET_COV_REFERENCE reference;
+    /* encoding of the value last notified, empty before the first notification */
+    std::vector<uint8_t> reported;
+    /* encoding of a change waiting to be notified, empty until the property was read */
+    std::vector<uint8_t> value;
+    BACNET_TIME time_of_change;
+    bool pending;
+    /* packed into the notification being sent */
+    bool encoded;
+};
+
+struct CovMultiple {
+    BACNET_COV_MULTIPLE_SUBSCRIPTION subscription;
+    /* ordered by object, then property, so the changes of an object are notified together */
+    std::vector<CovReference> references;
+    unsigned pending;
+};
+
+/* SubscribeCOVPropertyMultiple subscriptions, one entry per subscriber process */
+static std::vector<std::unique_ptr<CovMultiple>> COV_Multiple;
+static std::multimap<uint64_t, BACNET_COV_MULTIPLE_SUBSCRIPTION*> COV_Multiple_Expiries;
+/* properties subscribed in COV_Multiple, they count against MAX_COV_SUBSCRIPTIONS */
+static unsigned COV_Reference_Count;
+/* (object, property, array index) -> its encoded value, read once per cov_subscriptions_task() pass however many
+   subscribers monitor it, empty when the property can't be read */
+static std::map<std::tuple<uint64_t, uint32_t, uint32_t>, std::vector<uint8_t>> COV_Reads;
+
+static uint64_t cov_object_key(const BACNET_OBJECT_ID* object_id) {
+    return ((uint64_t)object_id->type << 32) | object_id->instance;
+}
+
+static void cov_list_erase(std::vector<BACNET_COV_SUBSCRIPTION*>& list, BACNET_COV_SUBSCRIPTION* subscription) {
+    auto it = std::find(list.begin(), list.end(), subscription);
+    if (it != list.end()) {
+        *it = list.back();
+        list.pop_back();
+    }
+}
+
+static void cov_expiry_erase(BACNET_COV_SUBSCRIPTION* subscription) {
+    if (subscription->expires == 0) {
+        return;
+    }
+    auto range = COV_Expiries.equal_range(subscription->expires);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == subscription) {
+            COV_Expiries.erase(it);
+            break;
+        }
+    }
+    subscription->expires = 0;
+}
+
+static bool cov_reference_less(const BACNET_COV_REFERENCE& a, const BACNET_COV_REFERENCE& b) {
+    uint64_t key_a = cov_object_key(&a.monitoredObjectIdentifier);
+    uint64_t key_b = cov_object_key(&b.monitoredObjectIdentifier);
+
+    if (key_a != key_b) {
+        return key_a < key_b;
+    }
+    if (a.monitoredProperty != b.monitoredProperty) {
+        return a.monitoredProperty < b.monitoredProperty;
+    }
+    return a.propertyArrayIndex < b.propertyArrayIndex;
+}
+
+static std::vector<CovReference>::iterator cov_reference_find(CovMultiple* multiple,
+    const BACNET_COV_REFERENCE* reference) {
+    auto it = std::lower_bound(multiple->references.begin(), multiple->references.end(), *reference,
+        [](const CovReference& entry, const BACNET_COV_REFERENCE& key) {
+            return cov_reference_less(entry.reference, key);
+        });
+    if ((it != multiple->references.end()) && !cov_reference_less(*reference, it->reference)) {
+        return it;
+    }
+
+    return multiple->references.end();
+}
+
+static void cov_reference_set_pending(CovMultiple* multiple, CovReference& entry) {
+    if (entry.pending) {
+        return;
+    }
+    entry.pending = true;
+    /* the delay starts with the first change collected */
+    if (multiple->pending++ == 0) {
+        multiple->subscription.due = COV_Seconds + multiple->subscription.maxNotificationDelay;
+    }
+}
+
+static void cov_reference_clear_pending(CovMultiple* multiple, CovReference& entry) {
+    if (entry.pending) {
+        entry.pending = false;
+        multiple->pending--;
+    }
+    entry.encoded = false;
+}
+
+static void cov_multiple_expiry_erase(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription) {
+    if (subscription->expires == 0) {
+        return;
+    }
+    auto range = COV_Multiple_Expiries.equal_range(subscription->expires);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == subscription) {
+            COV_Multiple_Expiries.erase(it);
+            break;
+        }
+    }
+    subscription->expires = 0;
+}
+
+/* whether a property value differs from the one last notified, by the COV increment or more if there is one;
+   the increment is ignored unless both values are REAL, as the standard has it for other datatypes */
+static bool cov_value_changed(bool increment_present,
+    float increment,
+    std::vector<uint8_t>& reported,
+    const uint8_t* value,
+    unsigned value_len) {
+    BACNET_APPLICATION_DATA_VALUE current;
+    BACNET_APPLICATION_DATA_VALUE previous;
+
+    if (reported.empty()) {
+        return true;
+    }
+    if (increment_present &&
+        (bacapp_decode_application_data((uint8_t*)value, value_len, &current) == (int)value_len) &&
+        (bacapp_decode_application_data(reported.data(), (unsigned)reported.size(), &previous) ==
+            (int)reported.size()) &&
+        (current.tag == BACNET_APPLICATION_TAG_REAL) && (previous.tag == BACNET_APPLICATION_TAG_REAL)) {
+        return std::fabs(current.type.Real - previous.type.Real) >= increment;
+    }
+
+    return (reported.size() != value_len) || (memcmp(reported.data(), value, value_len) != 0);
+}
+
+void cov_subscriptions_init(void) {
+    COV_Reads.clear();
+    COV_Multiple_Expiries.clear();
+    COV_Multiple.clear();
+    COV_Reference_Count = 0;
+    COV_Pending.clear();
+    COV_Confirmed.clear();
+    COV_Expiries.clear();
+    COV_Object_Index.clear();
+    COV_Subscriptions.clear();
+}
+
+unsigned cov_subscription_count(void) {
+    return (unsigned)COV_Subscriptions.size();
+}
+
+BACNET_COV_SUBSCRIPTION* cov_subscription_get(unsigned index) {
+    if (index >= COV_Subscriptions.size()) {
+        return NULL;
+    }
+
+    return &COV_Subscriptions[index]->subscription;
+}
+
+BACNET_COV_SUBSCRIPTION* cov_subscription_find(BACNET_ADDRESS* dest,
+    uint32_t process_identifier,
+    const BACNET_OBJECT_ID* object_id,
+    BACNET_PROPERTY_ID property,
+    uint32_t array_index) {
+    auto it = COV_Object_Index.find(cov_object_key(object_id));
+    if (it == COV_Object_Index.end()) {
+        return NULL;
+    }
+    for (auto subscription : it->second) {
+        if ((subscription->subscriberProcessIdentifier == process_identifier) &&
+            (subscription->monitoredProperty == property) && (subscription->propertyArrayIndex == array_index) &&
+            bacnet_address_same(dest, &subscription->dest)) {
+            return subscription;
+        }
+    }
+
+    return NULL;
+}
+
+BACNET_COV_SUBSCRIPTION* cov_subscription_add(BACNET_ADDRESS* dest,
+    uint32_t process_identifier,
+    const BACNET_OBJECT_ID* object_id,
+    BACNET_PROPERTY_ID property,
+    uint32_t array_index) {
+    if (COV_Subscriptions.size() + COV_Reference_Count >= MAX_COV_SUBSCRIPTIONS) {
+        return NULL;
+    }
+
+    std::unique_ptr<CovSubscription> entry(new CovSubscription());
+    BACNET_COV_SUBSCRIPTION* subscription = &entry->subscription;
+    bacnet_address_copy(&subscription->dest, dest);
+    subscription->subscriberProcessIdentifier = process_identifier;
+    subscription->monitoredObjectIdentifier = *object_id;
+    subscription->monitoredProperty = property;
+    subscription->propertyArrayIndex = array_index;
+    subscription->index = (unsigned)COV_Subscriptions.size();
+
+    COV_Object_Index[cov_object_key(object_id)].push_back(subscription);
+    COV_Subscriptions.push_back(std::move(entry));
+
+    return subscription;
+}
+
+void cov_subscription_remove(BACNET_COV_SUBSCRIPTION* subscription) {
+    unsigned index = subscription->index;
+
+    if (subscription->invokeID) {
+        tsm_free_invoke_id(subscription->invokeID);
+        subscription->invokeID = 0;
+    }
+    cov_expiry_erase(subscription);
+    cov_list_erase(COV_Pending, subscription);
+    cov_list_erase(COV_Confirmed, subscription);
+
+    auto it = COV_Object_Index.find(cov_object_key(&subscription->monitoredObjectIdentifier));
+    if (it != COV_Object_Index.end()) {
+        cov_list_erase(it->second, subscription);
+        if (it->second.empty()) {
+            COV_Object_Index.erase(it);
+        }
+    }
+
+    /* move the last subscription into the freed position */
+    if (index + 1 < COV_Subscriptions.size()) {
+        COV_Subscriptions[index] = std::move(COV_Subscriptions.back());
+        COV_Subscriptions[index]->subscription.index = index;
+    }
+    COV_Subscriptions.pop_back();
+}
+
+void cov_subscription_set_lifetime(BACNET_COV_SUBSCRIPTION* subscription, uint32_t lifetime) {
+    cov_expiry_erase(subscription);
+    subscription->lifetime = lifetime;
+    if (lifetime) {
+        subscription->expires = COV_Seconds + lifetime;
+        COV_Expiries.emplace(subscription->expires, subscription);
+    }
+}
+
+uint32_t cov_subscription_time_remaining(const BACNET_COV_SUBSCRIPTION* subscription) {
+    if (subscription->expires == 0) {
+        return 0;
+    }
+    /* a subscription about to expire still has a second to go */
+    return subscription->expires > COV_Seconds ? (uint32_t)(subscription->expires - COV_Seconds) : 1;
+}
+
+void cov_subscription_request_send(BACNET_COV_SUBSCRIPTION* subscription) {
+    if (!subscription->send_requested) {
+        subscription->send_requested = true;
+        COV_Pending.push_back(subscription);
+    }
+}
+
+void cov_subscription_notified(BACNET_COV_SUBSCRIPTION* subscription, const uint8_t* value, unsigned value_len) {
+    COV_Subscriptions[subscription->index]->reported.assign(value, value + value_len);
+}
+
+void cov_subscriptions_timer(uint32_t elapsed_seconds) {
+    COV_Seconds += elapsed_seconds;
+    while (!COV_Expiries.empty() && (COV_Expiries.begin()->first <= COV_Seconds)) {
+#if PRINT_ENABLED
+        BACNET_COV_SUBSCRIPTION* subscription = COV_Expiries.begin()->second;
+        fprintf(stderr, "COVtimer: PID=%u %u:%u expired\n", subscription->subscriberProcessIdentifier,
+            (unsigned)subscription->monitoredObjectIdentifier.type, subscription->monitoredObjectIdentifier.instance);
+#endif
+        cov_subscription_remove(COV_Expiries.begin()->second);
+    }
+    while (!COV_Multiple_Expiries.empty() && (COV_Multiple_Expiries.begin()->first <= COV_Seconds)) {
+        cov_multiple_remove(COV_Multiple_Expiries.begin()->second);
+    }
+}
+
+BACNET_COV_MULTIPLE_SUBSCRIPTION* cov_multiple_find(BACNET_ADDRESS* dest, uint32_t process_identifier) {
+    for (auto& multiple : COV_Multiple) {
+        if ((multiple->subscription.subscriberProcessIdentifier == process_identifier) &&
+            bacnet_address_same(dest, &multiple->subscription.dest)) {
+            return &multiple->subscription;
+        }
+    }
+
+    return NULL;
+}
+
+BACNET_COV_MULTIPLE_SUBSCRIPTION* cov_multiple_subscribe(BACNET_ADDRESS* dest,
+    uint32_t process_identifier,
+    const BACNET_COV_REFERENCE* references,
+    unsigned count) {
+    BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription = cov_multiple_find(dest, process_identifier);
+    CovMultiple* multiple = subscription ? COV_Multiple[subscription->index].get() : NULL;
+    unsigned added = 0;
+    unsigned i = 0;
+
+    /* all or nothing, an upper bound is good enough when a request names a property twice */
+    for (i = 0; i < count; i++) {
+        if (!multiple || (cov_reference_find(multiple, &references[i]) == multiple->references.end())) {
+            added++;
+        }
+    }
+    if (COV_Subscriptions.size() + COV_Reference_Count + added > MAX_COV_SUBSCRIPTIONS) {
+        return NULL;
+    }
+
+    if (!multiple) {
+        std::unique_ptr<CovMultiple> entry(new CovMultiple());
+        bacnet_address_copy(&entry->subscription.dest, dest);
+        entry->subscription.subscriberProcessIdentifier = process_identifier;
+        entry->subscription.index = (unsigned)COV_Multiple.size();
+        multiple = entry.get();
+        COV_Multiple.push_back(std::move(entry));
+    }
+
+    for (i = 0; i < count; i++) {
+        auto it = cov_reference_find(multiple, &references[i]);
+
+        if (it != multiple->references.end()) {
+            /* a renewal may change the increment, the state of the property is kept */
+            it->reference = references[i];
+            continue;
+        }
+        CovReference entry = {};
+        entry.reference = references[i];
+        it = std::upper_bound(multiple->references.begin(), multiple->references.end(), references[i],
+            [](const BACNET_COV_REFERENCE& key, const CovReference& other) {
+                return cov_reference_less(key, other.reference);
+            });
+        it = multiple->references.insert(it, std::move(entry));
+        COV_Reference_Count++;
+        /* the subscriber gets the current value right away */
+        cov_reference_set_pending(multiple, *it);
+        multiple->subscription.due = COV_Seconds;
+    }
+
+    return &multiple->subscription;
+}
+
+void cov_multiple_cancel(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription,
+    const BACNET_COV_REFERENCE* references,
+    unsigned count) {
+    CovMultiple* multiple = COV_Multiple[subscription->index].get();
+    unsigned i = 0;
+
+    for (i = 0; i < count; i++) {
+        auto it = cov_reference_find(multiple, &references[i]);
+
+        if (it == multiple->references.end()) {
+            continue;
+        }
+        cov_reference_clear_pending(multiple, *it);
+        multiple->references.erase(it);
+        COV_Reference_Count--;
+    }
+    if (multiple->references.empty()) {
+        cov_multiple_remove(subscription);
+    }
+}
+
+void cov_multiple_remove(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription) {
+    unsigned index = subscription->index;
+
+    if (subscription->invokeID) {
+        tsm_free_invoke_id(subscription->invokeID);
+        subscription->invokeID = 0;
+    }
+    cov_multiple_expiry_erase(subscription);
+    COV_Reference_Count -= (unsigned)COV_Multiple[index]->references.size();
+
+    /* move the last entry into the freed position */
+    if (index + 1 < COV_Multiple.size()) {
+        COV_Multiple[index] = std::move(COV_Multiple.back());
+        COV_Multiple[index]->subscription.index = index;
+    }
+    COV_Multiple.pop_back();
+}
+
+void cov_multiple_set_lifetime(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription, uint32_t lifetime) {
+    cov_multiple_expiry_erase(subscription);
+    subscription->lifetime = lifetime;
+    if (lifetime) {
+        subscription->expires = COV_Seconds + lifetime;
+        COV_Multiple_Expiries.emplace(subscription->expires, subscription);
+    }
+}
+
+uint32_t cov_multiple_time_remaining(const BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription) {
+    if (subscription->expires == 0) {
+        return 0;
+    }
+    return subscription->expires > COV_Seconds ? (uint32_t)(subscription->expires - COV_Seconds) : 1;
+}
+
+/* listOfValues entry of a changed property */
+static int cov_reference_encode(uint8_t* apdu, const CovReference& entry) {
+    int len = 0;
+
+    len = encode_context_enumerated(&apdu[0], 0, entry.reference.monitoredProperty);
+    if (entry.reference.propertyArrayIndex != BACNET_ARRAY_ALL) {
+        len += encode_context_unsigned(&apdu[len], 1, entry.reference.propertyArrayIndex);
+    }
+    len += encode_opening_tag(&apdu[len], 2);
+    memcpy(&apdu[len], entry.value.data(), entry.value.size());
+    len += (int)entry.value.size();
+    len += encode_closing_tag(&apdu[len], 2);
+    if (entry.reference.timestamped) {
+        BACNET_TIME time_of_change = entry.time_of_change;
+        len += encode_context_time(&apdu[len], 3, &time_of_change);
+    }
+
+    return len;
+}
+
+int cov_multiple_encode_notifications(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription,
+    uint8_t* apdu,
+    unsigned max_apdu) {
+    CovMultiple* multiple = COV_Multiple[subscription->index].get();
+    /* a property value is read into MAX_APDU bytes, the rest is its tags */
+    uint8_t buffer[MAX_APDU + 16];
+    uint8_t header[8];
+    const BACNET_OBJECT_ID* object_id = NULL;
+    unsigned len = 0;
+    unsigned encoded = 0;
+    bool full = false;
+
+    /* room for the opening and closing [4] and a closing [1] */
+    if (max_apdu < 3) {
+        return 0;
+    }
+    len = (unsigned)encode_opening_tag(&apdu[0], 4);
+    for (auto& entry : multiple->references) {
+        unsigned entry_len = 0;
+        unsigned header_len = 0;
+        bool same_object = false;
+
+        entry.encoded = false;
+        if (full || !entry.pending || entry.value.empty()) {
+            continue;
+        }
+        entry_len = (unsigned)cov_reference_encode(&buffer[0], entry);
+        same_object = object_id &&
+            (cov_object_key(object_id) == cov_object_key(&entry.reference.monitoredObjectIdentifier));
+        if (!same_object) {
+            /* close the values of the previous object, open those of this one */
+            header_len = object_id ? 1 : 0;
+            header_len += (unsigned)encode_context_object_id(&header[0], 0,
+                (BACNET_OBJECT_TYPE)entry.reference.monitoredObjectIdentifier.type,
+                entry.reference.monitoredObjectIdentifier.instance);
+            header_len += 1;
+        }
+        if (len + header_len + entry_len + 2 > max_apdu) {
+            if (3 + header_len + entry_len > max_apdu) {
+                /* too large for any notification, drop it rather than stall the others */
+                entry.reported.swap(entry.value);
+                entry.value.clear();
+                cov_reference_clear_pending(multiple, entry);
+                continue;
+            }
+            full = true;
+            continue;
+        }
+        if (!same_object) {
+            if (object_id) {
+                len += (unsigned)encode_closing_tag(&apdu[len], 1);
+            }
+            object_id = &entry.reference.monitoredObjectIdentifier;
+            len += (unsigned)encode_context_object_id(&apdu[len], 0, (BACNET_OBJECT_TYPE)object_id->type,
+                object_id->instance);
+            len += (unsigned)encode_opening_tag(&apdu[len], 1);
+        }
+        memcpy(&apdu[len], &buffer[0], entry_len);
+        len += entry_len;
+        entry.encoded = true;
+        encoded++;
+    }
+    if (encoded == 0) {
+        return 0;
+    }
+    len += (unsigned)encode_closing_tag(&apdu[len], 1);
+    len += (unsigned)encode_closing_tag(&apdu[len], 4);
+
+    return (int)len;
+}
+
+void cov_multiple_notified(BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription) {
+    CovMultiple* multiple = COV_Multiple[subscription->index].get();
+
+    for (auto& entry : multiple->references) {
+        if (!entry.encoded) {
+            continue;
+        }
+        entry.reported.swap(entry.value);
+        entry.value.clear();
+        cov_reference_clear_pending(multiple, entry);
+    }
+}
+
+/* Dispatch a SubscribeCOVPropertyMultiple request, the stack's confirmed service table has no slot for it */
+static bool cov_multiple_subscribe_request(BACNET_ADDRESS* dest,
+    BACNET_ADDRESS* src,
+    uint8_t* apdu,
+    uint16_t apdu_len) {
+    BACNET_CONFIRMED_SERVICE_DATA service_data;
+    uint8_t service_choice = 0;
+    uint8_t* service_request = NULL;
+    uint16_t service_request_len = 0;
+
+    /* like npdu_handler(), only requests addressed to this network */
+    if ((dest->net != 0) && (dest->net != BACNET_BROADCAST_NETWORK)) {
+        return false;
+    }
+    memset(&service_data, 0, sizeof(service_data));
+    apdu_decode_confirmed_service_request(&apdu[0], apdu_len, &service_data, &service_choice, &service_request,
+        &service_request_len);
+    if ((service_choice != COV_SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE) || (service_request == NULL)) {
+        return false;
+    }
+    /* while communication is disabled requests are dropped */
+    if (dcc_communication_enabled()) {
+        handler_cov_subscribe_property_multiple(service_request, service_request_len, src, &service_data);
+    }
+
+    return true;
+}
+
+bool cov_multiple_handler(BACNET_ADDRESS* src, uint8_t* pdu, uint16_t pdu_len) {
+    BACNET_ADDRESS dest;
+    BACNET_ADDRESS npdu_src;
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t* apdu = NULL;
+    int apdu_offset = 0;
+    uint8_t pdu_type = 0;
+
+    if (pdu[0] != BACNET_PROTOCOL_VERSION) {
+        return false;
+    }
+    npdu_src = *src;
+    apdu_offset = npdu_decode(&pdu[0], &dest, &npdu_src, &npdu_data);
+    if ((apdu_offset <= 0) || npdu_data.network_layer_message || ((apdu_offset + 3) > pdu_len)) {
+        return false;
+    }
+    apdu = &pdu[apdu_offset];
+    pdu_type = apdu[0] & 0xF0;
+    if (pdu_type == PDU_TYPE_CONFIRMED_SERVICE_REQUEST) {
+        return cov_multiple_subscribe_request(&dest, &npdu_src, apdu, (uint16_t)(pdu_len - apdu_offset));
+    }
+    if (COV_Multiple.empty()) {
+        return false;
+    }
+    if (((pdu_type != PDU_TYPE_SIMPLE_ACK) && (pdu_type != PDU_TYPE_ERROR)) ||
+        (apdu[2] != COV_SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE)) {
+        return false;
+    }
+
+    for (auto& multiple : COV_Multiple) {
+        BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription = &multiple->subscription;
+
+        if ((subscription->invokeID == 0) || (subscription->invokeID != apdu[1]) ||
+            !bacnet_address_same(&subscription->dest, &npdu_src)) {
+            continue;
+        }
+#if PRINT_ENABLED
+        if (pdu_type == PDU_TYPE_ERROR) {
+            fprintf(stderr, "COVnotificationMultiple: PID=%u rejected the notification\n",
+                subscription->subscriberProcessIdentifier);
+        }
+#endif
+        tsm_free_invoke_id(subscription->invokeID);
+        subscription->invokeID = 0;
+        return true;
+    }
+
+    return false;
+}
+
+/* the current value of a monitored property, read on the first request of a pass and shared by the rest */
+static const std::vector<uint8_t>& cov_property_read(const BACNET_OBJECT_ID* object_id,
+    BACNET_PROPERTY_ID property,
+    uint32_t array_index,
+    uint8_t* buffer,
+    unsigned size) {
+    auto inserted = COV_Reads.emplace(std::piecewise_construct,
+        std::forward_as_tuple(cov_object_key(object_id), (uint32_t)property, array_index), std::forward_as_tuple());
+    std::vector<uint8_t>& value = inserted.first->second;
+    BACNET_READ_PROPERTY_DATA rpdata;
+    int len = 0;
+
+    if (!inserted.second) {
+        return value;
+    }
+    rpdata.object_type = (BACNET_OBJECT_TYPE)object_id->type;
+    rpdata.object_instance = object_id->instance;
+    rpdata.object_property = property;
+    rpdata.array_index = array_index;
+    rpdata.application_data = buffer;
+    rpdata.application_data_len = (int)size;
+    len = Device_Read_Property(&rpdata);
+    if (len > 0) {
+        value.assign(buffer, buffer + len);
+    }
+
+    return value;
+}
+
+/* collect the changes of the properties of a SubscribeCOVPropertyMultiple subscriber */
+static void cov_multiple_poll(CovMultiple* multiple, uint8_t* buffer, unsigned size) {
+    BACNET_DATE_TIME now;
+
+    for (auto& entry : multiple->references) {
+        const std::vector<uint8_t>& value = cov_property_read(&entry.reference.monitoredObjectIdentifier,
+            entry.reference.monitoredProperty, entry.reference.propertyArrayIndex, buffer, size);
+
+        if (value.empty()) {
+            continue;
+        }
+        if (!entry.pending &&
+            !cov_value_changed(entry.reference.covIncrementPresent, entry.reference.covIncrement, entry.reported,
+                value.data(), (unsigned)value.size())) {
+            continue;
+        }
+        entry.value = value;
+        if (entry.reference.timestamped) {
+            Device_getCurrentDateTime(&now);
+            entry.time_of_change = now.time;
+        }
+        cov_reference_set_pending(multiple, entry);
+    }
+}
+
+/* whether a property subscribed with SubscribeCOVProperty changed by its COV increment or more */
+static bool cov_subscription_poll(BACNET_COV_SUBSCRIPTION* subscription, uint8_t* buffer, unsigned size) {
+    CovSubscription* entry = COV_Subscriptions[subscription->index].get();
+    const std::vector<uint8_t>& value = cov_property_read(&subscription->monitoredObjectIdentifier,
+        subscription->monitoredProperty, subscription->propertyArrayIndex, buffer, size);
+
+    if (value.empty()) {
+        return false;
+    }
+    if (!cov_value_changed(subscription->covIncrementPresent, subscription->covIncrement, entry->reported,
+            value.data(), (unsigned)value.size())) {
+        return false;
+    }
+    /* changes below the increment add up until they reach it */
+    entry->reported = value;
+
+    return true;
+}
+
+void cov_subscriptions_task(cov_notify_function notify, cov_multiple_notify_function notify_multiple) {
+    uint8_t buffer[MAX_APDU];
+    size_t i = 0;
+
+    COV_Reads.clear();
+    /* one change check per monitored object, however many subscribers it has */
+    for (auto& entry : COV_Object_Index) {
+        BACNET_OBJECT_TYPE object_type = (BACNET_OBJECT_TYPE)(entry.first >> 32);
+        uint32_t object_instance = (uint32_t)entry.first;
+        bool checked = false;
+        bool changed = false;
+
+        for (auto subscription : entry.second) {
+            if (subscription->monitoredProperty != COV_OBJECT_VALUE_LIST) {
+                if (cov_subscription_poll(subscription, &buffer[0], sizeof(buffer))) {
+                    cov_subscription_request_send(subscription);
+                }
+                continue;
+            }
+            if (!checked) {
+                changed = Device_COV(object_type, object_instance);
+                checked = true;
+            }
+            if (changed) {
+                cov_subscription_request_send(subscription);
+            }
+        }
+        if (changed) {
+            Device_COV_Clear(object_type, object_instance);
+        }
+    }
+    for (auto& multiple : COV_Multiple) {
+        cov_multiple_poll(multiple.get(), &buffer[0], sizeof(buffer));
+    }
+
+    /* confirmed notification house keeping */
+    while (i < COV_Confirmed.size()) {
+        BACNET_COV_SUBSCRIPTION* subscription = COV_Confirmed[i];
+
+        if (tsm_invoke_id_free(subscription->invokeID)) {
+            subscription->invokeID = 0;
+        } else if (tsm_invoke_id_failed(subscription->invokeID)) {
+            tsm_free_invoke_id(subscription->invokeID);
+            subscription->invokeID = 0;
+        }
+        if (subscription->invokeID == 0) {
+            COV_Confirmed[i] = COV_Confirmed.back();
+            COV_Confirmed.pop_back();
+        } else {
+            i++;
+        }
+    }
+    for (auto& multiple : COV_Multiple) {
+        BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription = &multiple->subscription;
+
+        if (subscription->invokeID == 0) {
+            continue;
+        }
+        if (tsm_invoke_id_free(subscription->invokeID)) {
+            subscription->invokeID = 0;
+        } else if (tsm_invoke_id_failed(subscription->invokeID)) {
+            tsm_free_invoke_id(subscription->invokeID);
+            subscription->invokeID = 0;
+        }
+    }
+
+    /* send what is queued, keeping what can't go out yet for the next pass */
+    i = 0;
+    while (i < COV_Pending.size()) {
+        BACNET_COV_SUBSCRIPTION* subscription = COV_Pending[i];
+
+        if (subscription->issueConfirmedNotifications &&
+            ((subscription->invokeID != 0) || !tsm_transaction_available())) {
+            i++;
+            continue;
+        }
+        if (!notify(subscription)) {
+            i++;
+            continue;
+        }
+        subscription->send_requested = false;
+        if (subscription->invokeID != 0) {
+            COV_Confirmed.push_back(subscription);
+        }
+        COV_Pending[i] = COV_Pending.back();
+        COV_Pending.pop_back();
+    }
+
+    /* changes collected for longer than the subscriber's delay, as many notifications as they need */
+    for (auto& multiple : COV_Multiple) {
+        BACNET_COV_MULTIPLE_SUBSCRIPTION* subscription = &multiple->subscription;
+
+        while ((multiple->pending > 0) && (subscription->due <= COV_Seconds)) {
+            if (subscription->issueConfirmedNotifications &&
+                ((subscription->invokeID != 0) || !tsm_transaction_available())) {
+                break;
+            }
+            if (!notify_multiple(subscription)) {
+                break;
+            }
+        }
+    }
+}
+
+bool handler_cov_active(void) {
+    return !COV_Subscriptions.empty() || !COV_Multiple.empty();
+}
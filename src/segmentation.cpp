@@ -0,0 +1,349 @@
+/** @file segmentation.cpp  Sending segmented complex ACKs (Clause 5.4.5) */
+
+#include <stdbool.h> /* for the standard bool type. */
+#include <stdint.h>  /* for standard integer types uint8_t etc. */
+#include <string.h>
+
+#include "abort.h"
+#include "apdu.h"
+#include "bacdcode.h"
+#include "bacenum.h"
+#include "config.h"
+#include "custom_bacnet_config.h"
+#include "datalink.h"
+#include "npdu.h"
+#include "segmentation.h"
+
+#include <vector>
+
+/* APDU header flags of segmented messages */
+#define APDU_SEGMENTED_MESSAGE 0x08
+#define APDU_MORE_FOLLOWS 0x04
+#define APDU_SENT_BY_SERVER 0x01
+
+/* header of a segmented complex ACK: type, invoke id, sequence number,
+   proposed window size and service choice */
+#define SEGMENTED_COMPLEX_ACK_HEADER_LEN 5
+/* header of an unsegmented complex ACK: type, invoke id and service choice */
+#define COMPLEX_ACK_HEADER_LEN 3
+
+typedef struct Segmented_Transaction {
+    bool active;
+    BACNET_ADDRESS dest;
+    uint8_t invoke_id;
+    uint8_t service_choice;
+    /* service data of the complex ACK, split into segment_size chunks;
+       sized to this reply and released when the transaction ends */
+    std::vector<uint8_t> service_data;
+    unsigned segment_size;
+    unsigned segment_count;
+    /* first segment of the current window and the requester's window size */
+    unsigned initial_sequence_number;
+    unsigned actual_window_size;
+    bool sent_all_segments;
+    uint32_t segment_timer;
+    uint8_t retry_count;
+} SEGMENTED_TRANSACTION;
+
+static uint8_t Segmentation_Buffer[MAX_SEGMENTED_APDU];
+static SEGMENTED_TRANSACTION Segmented_Transactions[MAX_SEGMENTED_TRANSACTIONS];
+
+static bool segmentation_address_same(BACNET_ADDRESS* dest, BACNET_ADDRESS* src) {
+    if ((dest->mac_len != src->mac_len) || (dest->net != src->net) || (dest->len != src->len)) {
+        return false;
+    }
+    if (memcmp(dest->mac, src->mac, dest->mac_len) != 0) {
+        return false;
+    }
+    if ((dest->net != 0) && (memcmp(dest->adr, src->adr, dest->len) != 0)) {
+        return false;
+    }
+
+    return true;
+}
+
+/** Encode the NPDU in front of an APDU and send it to the requester
+ *
+ * @param dest - destination address
+ * @param apdu - the APDU
+ * @param apdu_len - length of the APDU
+ * @return number of bytes sent, negative on failure
+ */
+static int segmentation_send_apdu(BACNET_ADDRESS* dest, uint8_t* apdu, unsigned apdu_len) {
+    uint8_t pdu[MAX_PDU];
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_ADDRESS my_address;
+    int pdu_len = 0;
+
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    pdu_len = npdu_encode_pdu(&pdu[0], dest, &my_address, &npdu_data);
+    memcpy(&pdu[pdu_len], apdu, apdu_len);
+    pdu_len += apdu_len;
+
+    return datalink_send_pdu(dest, &npdu_data, &pdu[0], pdu_len);
+}
+
+static int segmentation_send_abort(BACNET_ADDRESS* dest, uint8_t invoke_id, BACNET_ABORT_REASON reason) {
+    uint8_t apdu[MAX_APDU];
+    int apdu_len = 0;
+
+    apdu_len = abort_encode_apdu(&apdu[0], invoke_id, reason, true);
+    return segmentation_send_apdu(dest, &apdu[0], apdu_len);
+}
+
+/** Send one segment of a segmented complex ACK
+ *
+ * @param transaction - the segmented transaction
+ * @param sequence_number - the segment to send
+ * @return number of bytes sent, negative on failure
+ */
+static int segmentation_send_segment(SEGMENTED_TRANSACTION* transaction, unsigned sequence_number) {
+    uint8_t apdu[MAX_APDU];
+    unsigned offset = sequence_number * transaction->segment_size;
+    unsigned len = transaction->service_data.size() - offset;
+    bool more_follows = (sequence_number + 1) < transaction->segment_count;
+
+    if (len > transaction->segment_size) {
+        len = transaction->segment_size;
+    }
+    apdu[0] = PDU_TYPE_COMPLEX_ACK | APDU_SEGMENTED_MESSAGE | (more_follows ? APDU_MORE_FOLLOWS : 0);
+    apdu[1] = transaction->invoke_id;
+    apdu[2] = (uint8_t)sequence_number;
+    apdu[3] = SEGMENTATION_WINDOW_SIZE;
+    apdu[4] = transaction->service_choice;
+    memcpy(&apdu[SEGMENTED_COMPLEX_ACK_HEADER_LEN], &transaction->service_data[offset], len);
+    if (!more_follows) {
+        transaction->sent_all_segments = true;
+    }
+
+    return segmentation_send_apdu(&transaction->dest, &apdu[0], SEGMENTED_COMPLEX_ACK_HEADER_LEN + len);
+}
+
+/** Send the window of segments starting at a sequence number and restart
+ * the segment timer
+ *
+ * @param transaction - the segmented transaction
+ * @param sequence_number - first segment of the window
+ */
+static void segmentation_fill_window(SEGMENTED_TRANSACTION* transaction, unsigned sequence_number) {
+    unsigned i = 0;
+
+    for (i = 0; i < transaction->actual_window_size; i++) {
+        if ((sequence_number + i) >= transaction->segment_count) {
+            break;
+        }
+        segmentation_send_segment(transaction, sequence_number + i);
+    }
+    transaction->segment_timer = apdu_timeout();
+}
+
+static void segmentation_free(SEGMENTED_TRANSACTION* transaction) {
+    transaction->active = false;
+    transaction->service_data.clear();
+    transaction->service_data.shrink_to_fit();
+}
+
+uint8_t* segmentation_buffer(void) {
+    return &Segmentation_Buffer[0];
+}
+
+unsigned segmentation_max_apdu(BACNET_CONFIRMED_SERVICE_DATA* service_data) {
+    unsigned max_apdu = service_data->max_resp;
+    unsigned max_segments = service_data->max_segs;
+
+    if (max_apdu > MAX_APDU) {
+        max_apdu = MAX_APDU;
+    }
+    if (!service_data->segmented_response_accepted) {
+        return max_apdu;
+    }
+    /* zero means the requester did not say, more than 64 is encoded as 65 */
+    if ((max_segments == 0) || (max_segments > MAX_SEGMENTS_ACCEPTED)) {
+        max_segments = MAX_SEGMENTS_ACCEPTED;
+    }
+    if (max_segments < 2) {
+        return max_apdu;
+    }
+
+    return COMPLEX_ACK_HEADER_LEN + max_segments * (max_apdu - SEGMENTED_COMPLEX_ACK_HEADER_LEN);
+}
+
+BACNET_ERROR_CODE segmentation_abort_error_code(BACNET_CONFIRMED_SERVICE_DATA* service_data,
+    BACNET_ERROR_CODE error_code) {
+    /* a segmented request is refused because we can't receive segments */
+    if ((error_code == ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED) && service_data->segmented_response_accepted &&
+        !service_data->segmented_message) {
+        return ERROR_CODE_ABORT_BUFFER_OVERFLOW;
+    }
+
+    return error_code;
+}
+
+int segmentation_send_complex_ack(BACNET_ADDRESS* dest,
+    BACNET_CONFIRMED_SERVICE_DATA* service_data,
+    uint8_t* apdu,
+    unsigned apdu_len) {
+    SEGMENTED_TRANSACTION* transaction = NULL;
+    unsigned max_apdu = service_data->max_resp;
+    unsigned i = 0;
+
+    if (max_apdu > MAX_APDU) {
+        max_apdu = MAX_APDU;
+    }
+    if (apdu_len <= max_apdu) {
+        return segmentation_send_apdu(dest, apdu, apdu_len);
+    }
+    if (apdu_len > segmentation_max_apdu(service_data)) {
+        return segmentation_send_abort(dest,
+            service_data->invoke_id,
+            service_data->segmented_response_accepted ? ABORT_REASON_BUFFER_OVERFLOW
+                                                      : ABORT_REASON_SEGMENTATION_NOT_SUPPORTED);
+    }
+
+    /* a retransmitted request restarts its transaction */
+    for (i = 0; i < MAX_SEGMENTED_TRANSACTIONS; i++) {
+        if (Segmented_Transactions[i].active && (Segmented_Transactions[i].invoke_id == service_data->invoke_id) &&
+            segmentation_address_same(&Segmented_Transactions[i].dest, dest)) {
+            transaction = &Segmented_Transactions[i];
+            break;
+        }
+    }
+    for (i = 0; (transaction == NULL) && (i < MAX_SEGMENTED_TRANSACTIONS); i++) {
+        if (!Segmented_Transactions[i].active) {
+            transaction = &Segmented_Transactions[i];
+        }
+    }
+    if (transaction == NULL) {
+        return segmentation_send_abort(dest, service_data->invoke_id, ABORT_REASON_PREEMPTED_BY_HIGHER_PRIORITY_TASK);
+    }
+
+    transaction->active = true;
+    transaction->dest = *dest;
+    transaction->invoke_id = service_data->invoke_id;
+    transaction->service_choice = apdu[2];
+    transaction->service_data.assign(apdu + COMPLEX_ACK_HEADER_LEN, apdu + apdu_len);
+    transaction->segment_size = max_apdu - SEGMENTED_COMPLEX_ACK_HEADER_LEN;
+    transaction->segment_count =
+        (transaction->service_data.size() + transaction->segment_size - 1) / transaction->segment_size;
+    transaction->initial_sequence_number = 0;
+    /* the requester's window size is not known until its first SegmentACK */
+    transaction->actual_window_size = 1;
+    transaction->sent_all_segments = false;
+    transaction->retry_count = 0;
+    transaction->segment_timer = apdu_timeout();
+
+    return segmentation_send_segment(transaction, 0);
+}
+
+/** Handle a SegmentACK for a segmented complex ACK we are sending
+ *
+ * @param transaction - the segmented transaction
+ * @param sequence_number - last segment the requester received in order
+ * @param window_size - the requester's actual window size
+ */
+static void segmentation_segment_ack(SEGMENTED_TRANSACTION* transaction,
+    unsigned sequence_number,
+    unsigned window_size) {
+    /* sequence numbers are modulo 256 */
+    unsigned window_offset = (uint8_t)(sequence_number - transaction->initial_sequence_number);
+
+    if (window_offset >= transaction->actual_window_size) {
+        /* duplicate ACK */
+        transaction->segment_timer = apdu_timeout();
+        return;
+    }
+    sequence_number = transaction->initial_sequence_number + window_offset;
+    if (sequence_number + 1 >= transaction->segment_count) {
+        /* final ACK */
+        segmentation_free(transaction);
+        return;
+    }
+    if ((window_size < 1) || (window_size > 127)) {
+        window_size = 1;
+    }
+    transaction->initial_sequence_number = sequence_number + 1;
+    transaction->actual_window_size = window_size;
+    transaction->retry_count = 0;
+    segmentation_fill_window(transaction, transaction->initial_sequence_number);
+}
+
+bool segmentation_handler(BACNET_ADDRESS* src, uint8_t* pdu, uint16_t pdu_len) {
+    BACNET_ADDRESS dest;
+    BACNET_ADDRESS npdu_src;
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t* apdu = NULL;
+    int apdu_offset = 0;
+    uint8_t pdu_type = 0;
+    unsigned i = 0;
+
+    if (!segmentation_active()) {
+        return false;
+    }
+    if (pdu[0] != BACNET_PROTOCOL_VERSION) {
+        return false;
+    }
+    npdu_src = *src;
+    apdu_offset = npdu_decode(&pdu[0], &dest, &npdu_src, &npdu_data);
+    if ((apdu_offset <= 0) || npdu_data.network_layer_message || ((apdu_offset + 2) > pdu_len)) {
+        return false;
+    }
+    apdu = &pdu[apdu_offset];
+    pdu_type = apdu[0] & 0xF0;
+    /* only PDUs from the requester side belong to us */
+    if (((pdu_type != PDU_TYPE_SEGMENT_ACK) && (pdu_type != PDU_TYPE_ABORT)) || (apdu[0] & APDU_SENT_BY_SERVER)) {
+        return false;
+    }
+
+    for (i = 0; i < MAX_SEGMENTED_TRANSACTIONS; i++) {
+        SEGMENTED_TRANSACTION* transaction = &Segmented_Transactions[i];
+
+        if (!transaction->active || (transaction->invoke_id != apdu[1]) ||
+            !segmentation_address_same(&transaction->dest, &npdu_src)) {
+            continue;
+        }
+        if (pdu_type == PDU_TYPE_ABORT) {
+            segmentation_free(transaction);
+        } else if ((apdu_offset + 4) <= pdu_len) {
+            /* a negative ACK also names the last segment received in order */
+            segmentation_segment_ack(transaction, apdu[2], apdu[3]);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void segmentation_timer(uint32_t milliseconds) {
+    unsigned i = 0;
+
+    for (i = 0; i < MAX_SEGMENTED_TRANSACTIONS; i++) {
+        SEGMENTED_TRANSACTION* transaction = &Segmented_Transactions[i];
+
+        if (!transaction->active) {
+            continue;
+        }
+        if (transaction->segment_timer > milliseconds) {
+            transaction->segment_timer -= milliseconds;
+            continue;
+        }
+        if (transaction->retry_count < apdu_retries()) {
+            transaction->retry_count++;
+            segmentation_fill_window(transaction, transaction->initial_sequence_number);
+        } else {
+            segmentation_free(transaction);
+        }
+    }
+}
+
+bool segmentation_active(void) {
+    unsigned i = 0;
+
+    for (i = 0; i < MAX_SEGMENTED_TRANSACTIONS; i++) {
+        if (Segmented_Transactions[i].active) {
+            return true;
+        }
+    }
+
+    return false;
+}